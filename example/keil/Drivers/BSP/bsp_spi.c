@@ -1,15 +1,26 @@
 #include "bsp_spi.h"
+#include "spi_bus.h"
 
+#ifdef SPI_BUS_USING_SPI2
+/* SPI2由总线仲裁器管理, BSP设备没有片选脚, 由调用者控制片选 */
+static spi_bus_device g_spi2_bus_dev = {"bsp_spi2", NULL, SPI_BUS_MODE_3, SPI_BAUDRATEPRESCALER_256, NULL, 0,
+                                        SPI2_BUS_PRIORITY};
+#else
 SPI_HandleTypeDef g_spi2_handler; /* SPI2句柄 */
+#endif
 
 /**
  * @brief       SPI初始化代码
  *   @note      主机模式,8位数据,禁止硬件片选
+ *              定义SPI_BUS_USING_SPI2时, SPI2由总线仲裁器初始化, 这里只把BSP设备挂到总线上
  * @param       无
  * @retval      无
  */
 void spi2_init(void)
 {
+#ifdef SPI_BUS_USING_SPI2
+    spi_bus_attach(spi_bus_port_get("SPI2"), &g_spi2_bus_dev);
+#else
     SPI2_SPI_CLK_ENABLE(); /* SPI2时钟使能 */
 
     g_spi2_handler.Instance = SPI2_SPI;         /* SPI2 */
@@ -28,6 +39,7 @@ void spi2_init(void)
     HAL_SPI_Init(&g_spi2_handler);                                   /* 初始化 */
 
     __HAL_SPI_ENABLE(&g_spi2_handler); /* 使能SPI2 */
+#endif
 
     spi2_read_write_byte(0Xff); /* 启动传输, 实际上就是产生8个时钟脉冲, 达到清空DR的作用, 非必需 */
 }
@@ -75,21 +87,55 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef *hspi)
  */
 void spi2_set_speed(uint8_t speed)
 {
+#ifdef SPI_BUS_USING_SPI2
+    g_spi2_bus_dev.prescaler = (uint32_t)speed << 3; /* 下次传输时由仲裁器设置SPI速度 */
+#else
     assert_param(IS_SPI_BAUDRATE_PRESCALER(speed)); /* 判断有效性 */
     __HAL_SPI_DISABLE(&g_spi2_handler);             /* 关闭SPI */
     g_spi2_handler.Instance->CR1 &= 0XFFC7;         /* 位3-5清零，用来设置波特率 */
     g_spi2_handler.Instance->CR1 |= speed << 3;     /* 设置SPI速度 */
     __HAL_SPI_ENABLE(&g_spi2_handler);              /* 使能SPI */
+#endif
 }
 
 /**
  * @brief       SPI2读写一个字节数据
+ *   @note      定义SPI_BUS_USING_SPI2时, 通过总线仲裁器传输, 会等待正在进行的DMA传输
  * @param       txdata  : 要发送的数据(1字节)
  * @retval      接收到的数据(1字节)
  */
 uint8_t spi2_read_write_byte(uint8_t txdata)
 {
-    uint8_t rxdata;
+    uint8_t rxdata = 0xFF;
+#ifdef SPI_BUS_USING_SPI2
+    spi_bus_exchange(&g_spi2_bus_dev, &txdata, &rxdata, 1);
+#else
     HAL_SPI_TransmitReceive(&g_spi2_handler, &txdata, &rxdata, 1, 1000);
+#endif
     return rxdata; /* 返回收到的数据 */
 }
+
+/**
+ * @brief       占用SPI2总线
+ *   @note      片选由调用者控制, 选中片选前占用总线, 释放片选后再释放总线, 其间不会插入其他设备的传输
+ * @param       无
+ * @retval      无
+ */
+void spi2_bus_acquire(void)
+{
+#ifdef SPI_BUS_USING_SPI2
+    spi_bus_acquire(&g_spi2_bus_dev);
+#endif
+}
+
+/**
+ * @brief       释放SPI2总线
+ * @param       无
+ * @retval      无
+ */
+void spi2_bus_release(void)
+{
+#ifdef SPI_BUS_USING_SPI2
+    spi_bus_release(&g_spi2_bus_dev);
+#endif
+}
@@ -50,8 +50,13 @@
 #define SPI_SPEED_128 6
 #define SPI_SPEED_256 7
 
+/* SPI总线仲裁器中BSP设备的优先级, 0最高 */
+#define SPI2_BUS_PRIORITY 1
+
 void spi2_init(void);
 void spi2_set_speed(uint8_t speed);
 uint8_t spi2_read_write_byte(uint8_t txdata);
+void spi2_bus_acquire(void);
+void spi2_bus_release(void);
 
 #endif
@@ -8,11 +8,17 @@
 #include "easyflash.h"
 #include <stdlib.h>
 #include "sfud_cfg.h"
+#include <sfud.h>
 #include "bsp_spi.h"
 
 #define BUF_SIZE 512
+/* benchmark the CRC32 speed on boot by the DWT cycle counter */
+// #define TEST_CRC32_BENCH
 static int fal_test(const char *partiton_name);
 static void test_env(void);
+#ifdef TEST_CRC32_BENCH
+static void test_crc32(void);
+#endif
 
 int main(void)
 {
@@ -50,33 +56,101 @@ int main(void)
     {
         /* test Env demo */
         test_env();
+#ifdef TEST_CRC32_BENCH
+        test_crc32();
+#endif
     }
 
     while (1)
     {
+        /* collect the dirty ENV sectors on idle, so the ENV set rarely runs the GC */
+#ifdef EF_ENV_CHECKPOINT_ADDR
+        /* save the ENV checkpoint when the GC is finished, the next boot loads the ENV faster */
+        if (!ef_env_gc_step(4, 2000))
+        {
+            ef_env_checkpoint();
+        }
+#else
+        ef_env_gc_step(4, 2000);
+#endif
+#ifdef SFUD_USING_WRITE_BUFFER
+        /* program the buffered data which is not flushed by the ENV unlock, like the EF_USING_LOG writes */
+        sfud_write_buffer_poll(sfud_get_device(SFUD_XXXX_DEVICE_INDEX));
+#endif
         delay_ms(500);
     }
     return 0;
 }
 
+/**
+ * Get the boot count number from Env. It's saved as uint32_t now, but the older firmware saved it as the decimal
+ * string, such as "17". The string is still read here and the next ef_set_env_u32 converts it to uint32_t. A uint32_t
+ * value has 4 digit characters only when it's above 0x30303030, so the 4 characters string "1000" is not mistaken.
+ */
+static uint32_t get_boot_times(void)
+{
+    char value[10];
+    size_t len, saved_len, i;
+    uint32_t boot_times = 0;
+
+    len = ef_get_env_blob("boot_times", value, sizeof(value), &saved_len);
+    if (len == 0 || len != saved_len)
+    {
+        return 0;
+    }
+    for (i = 0; i < len && value[i] >= '0' && value[i] <= '9'; i++)
+    {
+        boot_times = boot_times * 10 + (value[i] - '0');
+    }
+    if (i != len)
+    {
+        boot_times = 0;
+        if (len == sizeof(boot_times))
+        {
+            memcpy(&boot_times, value, sizeof(boot_times));
+        }
+    }
+
+    return boot_times;
+}
+
 static void test_env(void)
 {
-    uint32_t i_boot_times = 0;
-    char *c_old_boot_times, c_new_boot_times[11] = {0};
+    uint32_t i_boot_times = get_boot_times();
 
-    /* get the boot count number from Env */
-    c_old_boot_times = ef_get_env("boot_times");
-    assert_param(c_old_boot_times);
-    i_boot_times = atol(c_old_boot_times);
     /* boot count +1 */
     i_boot_times++;
     printf("The system now boot %lu times\n\r", (unsigned long)i_boot_times);
-    /* interger to string */
-    sprintf(c_new_boot_times, "%lu", (unsigned long)i_boot_times);
     /* set and store the boot count number to Env */
-    ef_set_env("boot_times", c_new_boot_times);
+    ef_set_env_u32("boot_times", i_boot_times);
     ef_save_env();
+#ifdef EF_USING_LOG
+    /* save the boot event to log */
+    ef_log_write(&i_boot_times, sizeof(i_boot_times));
+    ef_log_flush();
+    printf("The log used size is %lu bytes\n\r", (unsigned long)ef_log_get_used_size());
+#endif
+}
+
+#ifdef TEST_CRC32_BENCH
+static void test_crc32(void)
+{
+    uint32_t cycles, crc = 0, i;
+
+    /* SysTick has no interrupt (it's used by delay_us), so HAL_GetTick doesn't advance. Count the cycles by DWT. */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    /* calculate the CRC32 of the first 64K internal flash for 16 times */
+    for (i = 0; i < 16; i++)
+    {
+        crc = ef_calc_crc32(crc, (const void *)FLASH_BASE, 64 * 1024);
+    }
+    cycles = DWT->CYCCNT;
+    printf("The CRC32 (0x%08lX) of 1024 KB takes %lu cycles, speed is %lu KB/s\n\r", (unsigned long)crc,
+           (unsigned long)cycles, (unsigned long)(cycles ? 1024ULL * SystemCoreClock / cycles : 0));
 }
+#endif
 
 static int fal_test(const char *partiton_name)
 {
@@ -141,6 +141,26 @@ sfud_err sfud_write(const sfud_flash *flash, uint32_t addr, size_t size, const u
  */
 sfud_err sfud_erase_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
 
+#ifdef SFUD_USING_UPDATE
+/**
+ * update flash data by read-modify-write, the data out of the range is kept
+ *
+ * Every affected sector is compared with the new data. When the new data only changes bits from 1 to 0, the
+ * different bytes are programmed in place. Otherwise the sector is erased once and the merged data is programmed.
+ *
+ * @note The sector buffer is static, the caller must serialize the updating.
+ * @note The other data on the erased sector will be lost when power fails during updating.
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size update size
+ * @param data update data
+ *
+ * @return result
+ */
+sfud_err sfud_update(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
+#endif /* SFUD_USING_UPDATE */
+
 /**
  * erase all flash data
  *
@@ -150,6 +170,100 @@ sfud_err sfud_erase_write(const sfud_flash *flash, uint32_t addr, size_t size, c
  */
 sfud_err sfud_chip_erase(const sfud_flash *flash);
 
+#ifdef SFUD_USING_WRITE_BUFFER
+/**
+ * write flash data (no erase operate) by the page write-combining buffer
+ *
+ * @note The data is NOT on flash after this function returned. It will be programmed when it's flushed:
+ *       1. write to other page
+ *       2. read, write (not buffered) or erase operate on this flash
+ *       3. call sfud_write_buffer_flush
+ *       4. timeout @see sfud_write_buffer_poll
+ *       The pages are programmed by the order of writing. All of the pending data in one page is programmed by
+ *       one page program, so a power fail may program any part of it. The commit flag (like the status) must be
+ *       written by sfud_write, which programs the pending data first and the flag by its own page program.
+ * @note The buffer isn't locked, the caller must serialize the writing.
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size write size
+ * @param data write data
+ *
+ * @return result
+ */
+sfud_err sfud_write_buffered(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
+
+/**
+ * program the pending data in write-combining buffer to flash
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+sfud_err sfud_write_buffer_flush(const sfud_flash *flash);
+
+/**
+ * The write-combining buffer timeout process. It should be called periodically.
+ * The buffer will be flushed after SFUD_WRITE_BUFFER_TIMEOUT calls without buffered write.
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+sfud_err sfud_write_buffer_poll(const sfud_flash *flash);
+#endif /* SFUD_USING_WRITE_BUFFER */
+
+#ifdef SFUD_USING_ASYNC_WRITE
+/**
+ * start to program data in one page, it doesn't wait for the program finish
+ *
+ * @note only the 256 bytes page write mode is supported
+ * @note The program is running after this function returned. Use sfud_is_busy or sfud_wait_ready for the finish.
+ *       The next program or erase on this flash will wait for it.
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size program size, the data must be in one page
+ * @param data program data
+ *
+ * @return result
+ */
+sfud_err sfud_program_start(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
+
+/**
+ * start to erase one sector or block by the suitable eraser, it doesn't wait for the erase finish
+ *
+ * @note the whole sector or block which contains the start address is erased
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size the size which will be erased
+ * @param erase_size the erased size from the start address by this erase command
+ *
+ * @return result
+ */
+sfud_err sfud_erase_start(const sfud_flash *flash, uint32_t addr, size_t size, size_t *erase_size);
+
+/**
+ * check the flash is busy on program or erase
+ *
+ * @param flash flash device
+ * @param busy true: the program or erase is running
+ *
+ * @return result
+ */
+sfud_err sfud_is_busy(const sfud_flash *flash, bool *busy);
+
+/**
+ * wait for the program or erase finish
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+sfud_err sfud_wait_ready(const sfud_flash *flash);
+#endif /* SFUD_USING_ASYNC_WRITE */
+
 /**
  * read flash register status
  *
@@ -35,6 +35,34 @@
 
 #define SFUD_USING_FLASH_INFO_TABLE
 
+/* cache the probed flash parameters by port, then the SFDP probing will be skipped on next booting. The port saves it
+ * on the on-chip flash page 0x0800F800, which is reserved by the Keil project (@see sfud_port.c). */
+#define SFUD_USING_PARAM_CACHE
+
+/* Maximum read size for one SPI transaction, the interrupts are disabled by port while it's running.
+ * 64K read at 18MHz SCK: no limit 29.4ms (29.4ms IRQ off), 1024 bytes 29.7ms (0.46ms IRQ off),
+ * 128 bytes 31.8ms (62us IRQ off, shorter than one byte time at 115200 baud), 64 bytes 34.2ms (33us IRQ off).
+ * They are measured by tools/sim/sim_read_chunk.c. */
+#ifndef SFUD_READ_MAX_CHUNK_SIZE
+#define SFUD_READ_MAX_CHUNK_SIZE                       128
+#endif
+
+/* merge the small writes in one page to one page program by sfud_write_buffered */
+#define SFUD_USING_WRITE_BUFFER
+
+/* sfud_update: update flash data by read-modify-write, the erase is skipped when it's not necessary (4K static RAM) */
+/* #define SFUD_USING_UPDATE */
+
+/* start the program and erase without waiting for the finish, it's used by FAL striped flash device */
+/* #define SFUD_USING_ASYNC_WRITE */
+
+/* the second SPI flash (sfud_norflash1) on SPI2, the CS pin is configured by SFUD_NOR_FLASH1_CS_xxx on port */
+/* #define SFUD_USING_NOR_FLASH1 */
+
+/* share SPI2 with the other devices by the SPI bus arbiter (src/spi_bus), the port acquires the bus instead of
+ * disabling the interrupts. SPI_BUS_USING_SPI2 must be defined on 'spi_bus_cfg.h'. */
+/* #define SFUD_USING_SPI_BUS */
+
 enum {
     SFUD_XXXX_DEVICE_INDEX = 0,
 };
@@ -166,10 +166,66 @@ if (!(EXPR))                                                                   \
 #define SFUD_CMD_EXIT_4B_ADDRESS_MODE                  0xE9
 #endif
 
+#ifndef SFUD_CMD_4B_READ_DATA
+#define SFUD_CMD_4B_READ_DATA                          0x13
+#endif
+
+#ifndef SFUD_CMD_4B_FAST_READ_DATA
+#define SFUD_CMD_4B_FAST_READ_DATA                     0x0C
+#endif
+
+#ifndef SFUD_CMD_4B_PAGE_PROGRAM
+#define SFUD_CMD_4B_PAGE_PROGRAM                       0x12
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_STATUS_REGISTER
+#define SFUD_CMD_DATAFLASH_STATUS_REGISTER             0xD7
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_BUFFER1_WRITE
+#define SFUD_CMD_DATAFLASH_BUFFER1_WRITE               0x84
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_BUFFER2_WRITE
+#define SFUD_CMD_DATAFLASH_BUFFER2_WRITE               0x87
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_BUFFER1_PROGRAM
+#define SFUD_CMD_DATAFLASH_BUFFER1_PROGRAM             0x88
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_BUFFER2_PROGRAM
+#define SFUD_CMD_DATAFLASH_BUFFER2_PROGRAM             0x89
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER1
+#define SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER1             0x53
+#endif
+
+#ifndef SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER2
+#define SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER2             0x55
+#endif
+
 #ifndef SFUD_WRITE_MAX_PAGE_SIZE
 #define SFUD_WRITE_MAX_PAGE_SIZE                        256
 #endif
 
+/* maximum read size for one SPI transaction. The large read is split to some chunks and the SPI lock
+ * is released between chunks. 0: no limit */
+#ifndef SFUD_READ_MAX_CHUNK_SIZE
+#define SFUD_READ_MAX_CHUNK_SIZE                       0
+#endif
+
+/* the write buffer will be flushed after these sfud_write_buffer_poll calls without buffered write */
+#ifndef SFUD_WRITE_BUFFER_TIMEOUT
+#define SFUD_WRITE_BUFFER_TIMEOUT                      10
+#endif
+
+/* the sector buffer size for sfud_update, it must be not less than the erase granularity */
+#ifndef SFUD_UPDATE_BUF_SIZE
+#define SFUD_UPDATE_BUF_SIZE                           4096
+#endif
+
 /* send dummy data for read data */
 #ifndef SFUD_DUMMY_DATA
 #define SFUD_DUMMY_DATA                                0xFF
@@ -187,6 +243,14 @@ enum {
     SFUD_STATUS_REGISTER_SRP = (1 << 7),                   /**< status register protect */
 };
 
+/**
+ * dual-buffer (like AT45DB series) flash status register bits
+ */
+enum {
+    SFUD_DATAFLASH_STATUS_REGISTER_PAGE_SIZE = (1 << 0),   /**< page size, 1: binary (power of 2), 0: DataFlash */
+    SFUD_DATAFLASH_STATUS_REGISTER_READY = (1 << 7),       /**< ready, it's 0 when device is busy */
+};
+
 /**
  * error code
  */
@@ -232,15 +296,32 @@ typedef struct {
     uint8_t vola_sr_we_cmd;                      /**< volatile status register write enable command */
     bool addr_3_byte;                            /**< supports 3-Byte addressing */
     bool addr_4_byte;                            /**< supports 4-Byte addressing */
+    bool addr_4_byte_cmd;                        /**< supports 4-Byte address read, program and erase commands */
     uint32_t capacity;                           /**< flash capacity (bytes) */
     struct {
         uint32_t size;                           /**< erase sector size (bytes). 0x00: not available */
         uint8_t cmd;                             /**< erase command */
+        uint8_t cmd_4b;                          /**< 4-Byte address erase command. 0x00: not available */
     } eraser[SFUD_SFDP_ERASE_TYPE_MAX_NUM];      /**< supported eraser types table */
     //TODO lots of fast read-related stuff (like modes supported and number of wait states/dummy cycles needed in each)
 } sfud_sfdp, *sfud_sfdp_t;
 #endif
 
+#ifdef SFUD_USING_WRITE_BUFFER
+/**
+ * page write-combining buffer, the small writes in one page are merged to one page program
+ */
+typedef struct {
+    uint32_t page_addr;                          /**< buffered page address */
+    uint16_t start;                              /**< pending data start offset in page */
+    uint16_t end;                                /**< pending data end offset in page, start == end: empty */
+    size_t idle_polls;                           /**< poll counts since last buffered write */
+    uint32_t writes;                             /**< buffered write counts */
+    uint32_t programs;                           /**< page program counts for flush */
+    uint8_t data[SFUD_WRITE_MAX_PAGE_SIZE];      /**< page data */
+} sfud_write_buffer, *sfud_write_buffer_t;
+#endif /* SFUD_USING_WRITE_BUFFER */
+
 /**
  * SPI device
  */
@@ -273,6 +354,7 @@ typedef struct {
     sfud_spi spi;                                /**< SPI device */
     bool init_ok;                                /**< initialize OK flag */
     bool addr_in_4_byte;                         /**< flash is in 4-Byte addressing */
+    bool addr_4_byte_cmd;                        /**< using 4-Byte address commands, the addressing mode isn't changed */
     struct {
         void (*delay)(void);                     /**< every retry's delay */
         size_t times;                            /**< default times for error retry */
@@ -287,6 +369,10 @@ typedef struct {
     sfud_sfdp sfdp;                              /**< serial flash discoverable parameters by JEDEC standard */
 #endif
 
+#ifdef SFUD_USING_WRITE_BUFFER
+    sfud_write_buffer *write_buf;                /**< page write-combining buffer, NULL: not used */
+#endif
+
 } sfud_flash, *sfud_flash_t;
 
 #ifdef __cplusplus
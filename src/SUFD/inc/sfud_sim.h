@@ -0,0 +1,152 @@
+/*
+ * This file is part of the Serial Flash Universal Driver Library.
+ *
+ * Function: Host side W25Qxx SPI NOR flash simulator. It implements the sfud_spi.wr contract.
+ * Created on: 2026-10-19
+ */
+
+#ifndef _SFUD_SIM_H_
+#define _SFUD_SIM_H_
+
+#include "sfud_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* simulated sector (4K erase) size */
+#define SFUD_SIM_SECTOR_SIZE                           4096
+
+/* simulated program page size */
+#define SFUD_SIM_PAGE_SIZE                             256
+
+/* simulated SFDP area size */
+#define SFUD_SIM_SFDP_SIZE                             256
+
+/**
+ * simulator timing model, all of the times are in nanoseconds
+ */
+typedef struct {
+    uint32_t sck_ns;                             /**< SPI clock period */
+    uint32_t cs_ns;                              /**< chip select setup and hold overhead for every transaction */
+    uint32_t program_base_ns;                    /**< page program fixed time */
+    uint32_t program_byte_ns;                    /**< page program time for every programmed byte */
+    uint32_t erase_4k_ns;                        /**< tSE: 4K sector erase time */
+    uint32_t erase_32k_ns;                       /**< tBE1: 32K block erase time */
+    uint32_t erase_64k_ns;                       /**< tBE2: 64K block erase time */
+    uint64_t erase_chip_ns;                      /**< tCE: chip erase time */
+    uint32_t write_status_ns;                    /**< tW: non-volatile status register write time */
+    uint32_t suspend_ns;                         /**< tSUS: suspend latency */
+    uint32_t resume_ns;                          /**< extra busy time added when resumed */
+} sfud_sim_timing;
+
+/**
+ * simulator configuration
+ */
+typedef struct {
+    uint8_t mf_id;                               /**< JEDEC manufacturer ID */
+    uint8_t type_id;                             /**< JEDEC memory type ID */
+    uint8_t capacity_id;                         /**< JEDEC capacity ID */
+    uint32_t capacity;                           /**< flash capacity (bytes) */
+    bool sfdp;                                   /**< SFDP table is readable */
+    bool addr_4b_table;                          /**< SFDP has 4-Byte address instruction table when larger than 16MB */
+    sfud_sim_timing timing;                      /**< timing model */
+} sfud_sim_config;
+
+/**
+ * simulator operation statistics
+ */
+typedef struct {
+    uint32_t transactions;                       /**< chip select cycles */
+    uint64_t bus_bytes;                          /**< bytes clocked on the bus */
+    uint64_t bus_ns;                             /**< time spent on the bus */
+    uint64_t busy_ns;                            /**< time the array spent programming or erasing */
+    uint32_t read_cmds;                          /**< 0x03, 0x0B and 0x3B commands */
+    uint64_t read_bytes;                         /**< bytes returned by read commands */
+    uint32_t program_cmds;                       /**< page program commands */
+    uint64_t program_bytes;                      /**< bytes sent by page program commands */
+    uint32_t erase_4k;                           /**< 4K sector erase commands */
+    uint32_t erase_32k;                          /**< 32K block erase commands */
+    uint32_t erase_64k;                          /**< 64K block erase commands */
+    uint32_t erase_chip;                         /**< chip erase commands */
+    uint32_t status_reads;                       /**< status register read commands */
+    uint32_t status_writes;                      /**< status register write commands */
+    uint32_t write_enables;                      /**< write enable commands */
+    uint32_t write_disables;                     /**< write disable commands */
+    uint32_t suspends;                           /**< accepted suspend commands */
+    uint32_t resumes;                            /**< accepted resume commands */
+    uint32_t resets;                             /**< software reset commands */
+    uint32_t id_reads;                           /**< JEDEC, manufacturer and unique ID reads */
+    uint32_t sfdp_reads;                         /**< SFDP read commands */
+    uint32_t addr_mode_switches;                 /**< enter and exit 4-Byte addressing mode commands */
+    uint32_t ignored_cmds;                       /**< commands ignored because the device was busy or write disabled */
+    uint32_t unknown_cmds;                       /**< commands not supported by the simulator */
+} sfud_sim_stats;
+
+struct sfud_sim;
+
+/**
+ * simulated SPI NOR flash device
+ */
+typedef struct sfud_sim {
+    sfud_sim_config cfg;                         /**< configuration */
+    uint8_t *array;                              /**< memory array */
+    uint32_t *erase_count;                       /**< erase count of every 4K sector */
+    uint8_t sfdp[SFUD_SIM_SFDP_SIZE];            /**< SFDP area */
+    uint8_t sr1;                                 /**< status register 1 */
+    uint8_t sr2;                                 /**< status register 2 */
+    bool reset_enabled;                          /**< enable reset (0x66) has been received */
+    bool volatile_sr_we;                         /**< volatile status register write enable (0x50) has been received */
+    bool addr_4_byte;                            /**< 4-Byte addressing mode (0xB7) */
+    uint8_t busy_op;                             /**< running operation, one of SFUD_SIM_OP_xxx */
+    uint64_t busy_until;                         /**< simulated time when the running operation finishes */
+    struct {
+        uint8_t op;                              /**< suspended operation */
+        uint64_t remain;                         /**< remaining busy time of the suspended operation */
+    } suspended;
+    sfud_sim_stats stats;                        /**< operation statistics */
+    struct {
+        uint64_t budget;                         /**< programmed bytes and erased sectors to cut, 0: never */
+        uint64_t used;                           /**< programmed bytes and erased sectors since the budget is set */
+        void (*cut)(struct sfud_sim *sim);       /**< power cut hook, the array has the torn data, it must not return */
+    } power;
+} sfud_sim, *sfud_sim_t;
+
+/**
+ * simulated operations
+ */
+enum {
+    SFUD_SIM_OP_NONE = 0,
+    SFUD_SIM_OP_PROGRAM = 1,
+    SFUD_SIM_OP_ERASE = 2,
+    SFUD_SIM_OP_WRITE_STATUS = 3,
+};
+
+/**
+ * status register 2 bits
+ */
+enum {
+    SFUD_SIM_SR2_QE = (1 << 1),                  /**< quad enable */
+    SFUD_SIM_SR2_SUS = (1 << 7),                 /**< erase/program suspend status */
+};
+
+void sfud_sim_default_config(sfud_sim_config *cfg);
+sfud_err sfud_sim_init(sfud_sim *sim, const sfud_sim_config *cfg);
+void sfud_sim_deinit(sfud_sim *sim);
+void sfud_sim_attach(sfud_sim *sim, sfud_flash *flash);
+sfud_err sfud_sim_spi_write_read(const sfud_spi *spi, const uint8_t *write_buf, size_t write_size, uint8_t *read_buf,
+        size_t read_size);
+void sfud_sim_delay(uint64_t ns);
+uint64_t sfud_sim_get_time(void);
+void sfud_sim_clear_stats(sfud_sim *sim);
+void sfud_sim_set_power_cut(sfud_sim *sim, uint64_t budget, void (*cut)(sfud_sim *sim));
+void sfud_sim_print_stats(const sfud_sim *sim);
+
+/* sfud_sim_port.c */
+sfud_sim *sfud_sim_port_get_device(const char *spi_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SFUD_SIM_H_ */
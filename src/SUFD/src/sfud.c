@@ -28,6 +28,7 @@
 
 #include "../inc/sfud.h"
 #include <string.h>
+#include <stddef.h>
 
 /* send dummy data for read data */
 #define DUMMY_DATA                               0xFF
@@ -50,17 +51,53 @@ static const sfud_mf mf_table[] = SFUD_MF_TABLE;
 static const sfud_flash_chip flash_chip_table[] = SFUD_FLASH_CHIP_TABLE;
 #endif
 
+#ifdef SFUD_USING_PARAM_CACHE
+/* the magic word of parameter cache record ('S', 'F', 'P', 'C') */
+#define PARAM_CACHE_MAGIC_WORD                   0x43504653
+/* the chip name isn't found in flash chip information table */
+#define PARAM_CACHE_NO_CHIP_NAME                 0xFFFFFFFF
+
+/**
+ * The probed flash parameter record. It's saved by port after the first probing.
+ * On the next booting only the JEDEC ID is read, then the parameters are loaded from this record.
+ */
+typedef struct {
+    uint32_t magic;                              /**< magic word */
+    uint32_t size;                               /**< record size, the record is invalid when the layout is changed */
+    uint32_t chip_name_index;                    /**< chip name index of flash chip information table */
+    sfud_flash_chip chip;                        /**< flash chip information, the name is not saved */
+#ifdef SFUD_USING_SFDP
+    sfud_sfdp sfdp;                              /**< SFDP parameters */
+#endif
+    uint32_t crc32;                              /**< CRC32 of all of the above */
+} sfud_param_cache;
+#endif /* SFUD_USING_PARAM_CACHE */
+
 static sfud_err software_init(const sfud_flash *flash);
 static sfud_err hardware_init(sfud_flash *flash);
 static sfud_err page256_or_1_byte_write(const sfud_flash *flash, uint32_t addr, size_t size, uint16_t write_gran,
         const uint8_t *data);
 static sfud_err aai_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
+static sfud_err dual_buffer_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data);
 static sfud_err wait_busy(const sfud_flash *flash);
 static sfud_err reset(const sfud_flash *flash);
 static sfud_err read_jedec_id(sfud_flash *flash);
 static sfud_err set_write_enabled(const sfud_flash *flash, bool enabled);
 static sfud_err set_4_byte_address_mode(sfud_flash *flash, bool enabled);
+static sfud_err set_dataflash_binary_page(const sfud_flash *flash);
 static void make_adress_byte_array(const sfud_flash *flash, uint32_t addr, uint8_t *array);
+static void get_eraser(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t *cmd, size_t *erase_size);
+#ifdef SFUD_USING_UPDATE
+static sfud_err update_program(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *old,
+        const uint8_t *data);
+#endif
+#ifdef SFUD_USING_WRITE_BUFFER
+static sfud_err flush_write_buffer(const sfud_flash *flash, uint32_t addr, size_t size);
+#endif
+#ifdef SFUD_USING_PARAM_CACHE
+static bool read_param_cache(sfud_flash *flash);
+static void write_param_cache(const sfud_flash *flash);
+#endif
 
 /* ../port/sfup_port.c */
 extern void sfud_log_debug(const char *file, const long line, const char *format, ...);
@@ -158,6 +195,9 @@ static sfud_err hardware_init(sfud_flash *flash) {
 
     sfud_err result = SFUD_SUCCESS;
     size_t i;
+#ifdef SFUD_USING_PARAM_CACHE
+    bool probed = false, param_cached = false;
+#endif
 
     SFUD_ASSERT(flash);
 
@@ -177,6 +217,13 @@ static sfud_err hardware_init(sfud_flash *flash) {
             return result;
         }
 
+#ifdef SFUD_USING_PARAM_CACHE
+        probed = true;
+        /* using the cached parameters when the JEDEC ID is matched, so the SFDP probing will be skipped */
+        param_cached = read_param_cache(flash);
+        if (!param_cached) {
+#endif
+
 #ifdef SFUD_USING_SFDP
         extern bool sfud_read_sfdp(sfud_flash *flash);
         /* read SFDP parameters */
@@ -221,6 +268,9 @@ static sfud_err hardware_init(sfud_flash *flash) {
         }
 #endif
 
+#ifdef SFUD_USING_PARAM_CACHE
+        }
+#endif
     }
 
     if (flash->chip.capacity == 0 || flash->chip.write_mode == 0 || flash->chip.erase_gran == 0
@@ -243,6 +293,11 @@ static sfud_err hardware_init(sfud_flash *flash) {
         } else if (flash_mf_name) {
             SFUD_INFO("Find a %s flash chip. Size is %ld bytes.", flash_mf_name, flash->chip.capacity);
         }
+#ifdef SFUD_USING_PARAM_CACHE
+        if (probed && !param_cached) {
+            write_param_cache(flash);
+        }
+#endif
     }
 
     /* reset flash device */
@@ -251,6 +306,14 @@ static sfud_err hardware_init(sfud_flash *flash) {
         return result;
     }
 
+    /* dual-buffer write, like AT45DB series flash is shipped on the DataFlash page size (e.g. 528 bytes) */
+    if (flash->chip.write_mode & SFUD_WM_DUAL_BUFFER) {
+        result = set_dataflash_binary_page(flash);
+        if (result != SFUD_SUCCESS) {
+            return result;
+        }
+    }
+
     /* I found when the flash read mode is supported AAI mode. The flash all blocks is protected,
      * so need change the flash status to unprotected before write and erase operate. */
     if (flash->chip.write_mode & SFUD_WM_AAI) {
@@ -261,8 +324,19 @@ static sfud_err hardware_init(sfud_flash *flash) {
     }
 
     /* if the flash is large than 16MB (256Mb) then enter in 4-Byte addressing mode */
+    flash->addr_4_byte_cmd = false;
     if (flash->chip.capacity > (1 << 24)) {
-        result = set_4_byte_address_mode(flash, true);
+#ifdef SFUD_USING_SFDP
+        /* the 4-Byte address commands are used first, the flash addressing mode is kept */
+        if (flash->sfdp.available && flash->sfdp.addr_4_byte_cmd) {
+            flash->addr_in_4_byte = true;
+            flash->addr_4_byte_cmd = true;
+            SFUD_DEBUG("Using the 4-Byte address commands.");
+        } else
+#endif
+        {
+            result = set_4_byte_address_mode(flash, true);
+        }
     } else {
         flash->addr_in_4_byte = false;
     }
@@ -299,6 +373,7 @@ sfud_err sfud_read(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t
     sfud_err result = SFUD_SUCCESS;
     const sfud_spi *spi = &flash->spi;
     uint8_t cmd_data[5], cmd_size;
+    size_t read_size;
 
     SFUD_ASSERT(flash);
     SFUD_ASSERT(data);
@@ -309,28 +384,51 @@ sfud_err sfud_read(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t
         SFUD_INFO("Error: Flash address is out of bound.");
         return SFUD_ERR_ADDR_OUT_OF_BOUND;
     }
-    /* lock SPI */
-    if (spi->lock) {
-        spi->lock(spi);
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* read after write, the pending data must be programmed before */
+    result = flush_write_buffer(flash, addr, size);
+    if (result != SFUD_SUCCESS) {
+        return result;
     }
+#endif
+    /* The large read is split to some chunks. The SPI is unlocked between chunks and the address is
+     * sent again for every chunk, so the SPI lock time is bounded by chunk size. */
+    while (size) {
+        read_size = size;
+#if SFUD_READ_MAX_CHUNK_SIZE
+        if (read_size > SFUD_READ_MAX_CHUNK_SIZE) {
+            read_size = SFUD_READ_MAX_CHUNK_SIZE;
+        }
+#endif
+        /* lock SPI */
+        if (spi->lock) {
+            spi->lock(spi);
+        }
 
-    result = wait_busy(flash);
+        result = wait_busy(flash);
 
-    if (result == SFUD_SUCCESS) {
-        cmd_data[0] = SFUD_CMD_READ_DATA;
-        make_adress_byte_array(flash, addr, &cmd_data[1]);
-        cmd_size = flash->addr_in_4_byte ? 5 : 4;
-        result = spi->wr(spi, cmd_data, cmd_size, data, size);
-    }
-    /* unlock SPI */
-    if (spi->unlock) {
-        spi->unlock(spi);
+        if (result == SFUD_SUCCESS) {
+            cmd_data[0] = flash->addr_4_byte_cmd ? SFUD_CMD_4B_READ_DATA : SFUD_CMD_READ_DATA;
+            make_adress_byte_array(flash, addr, &cmd_data[1]);
+            cmd_size = flash->addr_in_4_byte ? 5 : 4;
+            result = spi->wr(spi, cmd_data, cmd_size, data, read_size);
+        }
+        /* unlock SPI */
+        if (spi->unlock) {
+            spi->unlock(spi);
+        }
+        if (result != SFUD_SUCCESS) {
+            break;
+        }
+
+        addr += read_size;
+        data += read_size;
+        size -= read_size;
     }
 
     return result;
 }
 
-
 /**
  * erase all flash data
  *
@@ -346,6 +444,13 @@ sfud_err sfud_chip_erase(const sfud_flash *flash) {
     SFUD_ASSERT(flash);
     /* must be call this function after initialize OK */
     SFUD_ASSERT(flash->init_ok);
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* the pending data must be programmed before, so the operates are kept in order */
+    result = flush_write_buffer(flash, 0, flash->chip.capacity);
+    if (result != SFUD_SUCCESS) {
+        return result;
+    }
+#endif
     /* lock SPI */
     if (spi->lock) {
         spi->lock(spi);
@@ -396,12 +501,10 @@ __exit:
  * @return result
  */
 sfud_err sfud_erase(const sfud_flash *flash, uint32_t addr, size_t size) {
-    extern size_t sfud_sfdp_get_suitable_eraser(const sfud_flash *flash, uint32_t addr, size_t erase_size);
-
     sfud_err result = SFUD_SUCCESS;
     const sfud_spi *spi = &flash->spi;
     uint8_t cmd_data[5], cmd_size, cur_erase_cmd;
-    size_t eraser_index, cur_erase_size;
+    size_t cur_erase_size;
 
     SFUD_ASSERT(flash);
     /* must be call this function after initialize OK */
@@ -415,6 +518,13 @@ sfud_err sfud_erase(const sfud_flash *flash, uint32_t addr, size_t size) {
     if (addr == 0 && size == flash->chip.capacity) {
         return sfud_chip_erase(flash);
     }
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* the pending data must be programmed before, so the operates are kept in order */
+    result = flush_write_buffer(flash, 0, flash->chip.capacity);
+    if (result != SFUD_SUCCESS) {
+        return result;
+    }
+#endif
 
     /* lock SPI */
     if (spi->lock) {
@@ -423,20 +533,7 @@ sfud_err sfud_erase(const sfud_flash *flash, uint32_t addr, size_t size) {
 
     /* loop erase operate. erase unit is erase granularity */
     while (size) {
-        /* if this flash is support SFDP parameter, then used SFDP parameter supplies eraser */
-#ifdef SFUD_USING_SFDP
-        if (flash->sfdp.available) {
-            /* get the suitable eraser for erase process from SFDP parameter */
-            eraser_index = sfud_sfdp_get_suitable_eraser(flash, addr, size);
-            cur_erase_cmd = flash->sfdp.eraser[eraser_index].cmd;
-            cur_erase_size = flash->sfdp.eraser[eraser_index].size;
-        } else {
-#else
-        {
-#endif
-            cur_erase_cmd = flash->chip.erase_gran_cmd;
-            cur_erase_size = flash->chip.erase_gran;
-        }
+        get_eraser(flash, addr, size, &cur_erase_cmd, &cur_erase_size);
         /* set the flash write enable */
         result = set_write_enabled(flash, true);
         if (result != SFUD_SUCCESS) {
@@ -524,7 +621,7 @@ static sfud_err page256_or_1_byte_write(const sfud_flash *flash, uint32_t addr,
         if (result != SFUD_SUCCESS) {
             goto __exit;
         }
-        cmd_data[0] = SFUD_CMD_PAGE_PROGRAM;
+        cmd_data[0] = flash->addr_4_byte_cmd ? SFUD_CMD_4B_PAGE_PROGRAM : SFUD_CMD_PAGE_PROGRAM;
         make_adress_byte_array(flash, addr, &cmd_data[1]);
         cmd_size = flash->addr_in_4_byte ? 5 : 4;
 
@@ -662,6 +759,119 @@ __exit:
     return result;
 }
 
+/**
+ * write flash data (no erase operate) for dual-buffer mode, like AT45DB series
+ *
+ * The page size is the erase granularity. Every page is filled to one SRAM buffer then programmed to main memory
+ * without built-in erase. The two buffers are used alternately, so the next page is filled while the previous page
+ * is programming. The partial page is loaded from main memory to buffer before filling for protect the old data.
+ *
+ * @note The device is configured to the binary (power of 2) page size by hardware_init, the buffer address is the page
+ *       offset.
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size write size
+ * @param data write data
+ *
+ * @return result
+ */
+static sfud_err dual_buffer_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data) {
+    static const uint8_t load_cmd[] = { SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER1, SFUD_CMD_DATAFLASH_MAIN_TO_BUFFER2 };
+    static const uint8_t fill_cmd[] = { SFUD_CMD_DATAFLASH_BUFFER1_WRITE, SFUD_CMD_DATAFLASH_BUFFER2_WRITE };
+    static const uint8_t program_cmd[] = { SFUD_CMD_DATAFLASH_BUFFER1_PROGRAM, SFUD_CMD_DATAFLASH_BUFFER2_PROGRAM };
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t cmd_data[5 + SFUD_WRITE_MAX_PAGE_SIZE], cmd_size, buffer = 0;
+    uint32_t page_size = flash->chip.erase_gran, page_addr, offset;
+    size_t data_size, fill_size, i;
+
+    SFUD_ASSERT(flash);
+    SFUD_ASSERT(flash->init_ok);
+    SFUD_ASSERT(page_size);
+    /* check the flash address bound */
+    if (addr + size > flash->chip.capacity) {
+        SFUD_INFO("Error: Flash address is out of bound.");
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+    /* lock SPI */
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+
+    cmd_size = flash->addr_in_4_byte ? 5 : 4;
+    while (size) {
+        page_addr = addr - addr % page_size;
+        offset = addr % page_size;
+        data_size = page_size - offset;
+        if (data_size > size) {
+            data_size = size;
+        }
+        /* the whole page will be programmed, so the partial page must be loaded to buffer before */
+        if (data_size != page_size) {
+            /* main memory operate needs the device is ready */
+            result = wait_busy(flash);
+            if (result != SFUD_SUCCESS) {
+                goto __exit;
+            }
+            cmd_data[0] = load_cmd[buffer];
+            make_adress_byte_array(flash, page_addr, &cmd_data[1]);
+            result = spi->wr(spi, cmd_data, cmd_size, NULL, 0);
+            if (result != SFUD_SUCCESS) {
+                SFUD_INFO("Error: Flash write SPI communicate error.");
+                goto __exit;
+            }
+            result = wait_busy(flash);
+            if (result != SFUD_SUCCESS) {
+                goto __exit;
+            }
+        }
+        /* fill the buffer, it's allowed when the other buffer is programming */
+        for (i = 0; i < data_size; i += fill_size) {
+            fill_size = data_size - i;
+            if (fill_size > SFUD_WRITE_MAX_PAGE_SIZE) {
+                fill_size = SFUD_WRITE_MAX_PAGE_SIZE;
+            }
+            cmd_data[0] = fill_cmd[buffer];
+            make_adress_byte_array(flash, offset + i, &cmd_data[1]);
+            memcpy(&cmd_data[cmd_size], data + i, fill_size);
+            result = spi->wr(spi, cmd_data, cmd_size + fill_size, NULL, 0);
+            if (result != SFUD_SUCCESS) {
+                SFUD_INFO("Error: Flash write SPI communicate error.");
+                goto __exit;
+            }
+        }
+        /* wait the previous page program finish */
+        result = wait_busy(flash);
+        if (result != SFUD_SUCCESS) {
+            goto __exit;
+        }
+        cmd_data[0] = program_cmd[buffer];
+        make_adress_byte_array(flash, page_addr, &cmd_data[1]);
+        result = spi->wr(spi, cmd_data, cmd_size, NULL, 0);
+        if (result != SFUD_SUCCESS) {
+            SFUD_INFO("Error: Flash write SPI communicate error.");
+            goto __exit;
+        }
+        /* switch to the other buffer */
+        buffer ^= 1;
+
+        addr += data_size;
+        data += data_size;
+        size -= data_size;
+    }
+    /* wait the last page program finish */
+    result = wait_busy(flash);
+
+__exit:
+    /* unlock SPI */
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+
+    return result;
+}
+
 /**
  * write flash data (no erase operate)
  *
@@ -675,12 +885,20 @@ __exit:
 sfud_err sfud_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data) {
     sfud_err result = SFUD_SUCCESS;
 
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* the pending data must be programmed before, so the operates are kept in order */
+    result = flush_write_buffer(flash, 0, flash->chip.capacity);
+    if (result != SFUD_SUCCESS) {
+        return result;
+    }
+#endif
+
     if (flash->chip.write_mode & SFUD_WM_PAGE_256B) {
         result = page256_or_1_byte_write(flash, addr, size, 256, data);
     } else if (flash->chip.write_mode & SFUD_WM_AAI) {
         result = aai_write(flash, addr, size, data);
     } else if (flash->chip.write_mode & SFUD_WM_DUAL_BUFFER) {
-        //TODO dual-buffer write mode
+        result = dual_buffer_write(flash, addr, size, data);
     }
 
     return result;
@@ -708,103 +926,508 @@ sfud_err sfud_erase_write(const sfud_flash *flash, uint32_t addr, size_t size, c
     return result;
 }
 
-static sfud_err reset(const sfud_flash *flash) {
+#ifdef SFUD_USING_UPDATE
+/**
+ * update flash data by read-modify-write, the data out of the range is kept
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size update size
+ * @param data update data
+ *
+ * @return result
+ */
+sfud_err sfud_update(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data) {
+    /* the sector buffer */
+    static uint8_t buf[SFUD_UPDATE_BUF_SIZE];
     sfud_err result = SFUD_SUCCESS;
-    const sfud_spi *spi = &flash->spi;
-    uint8_t cmd_data[2];
+    uint32_t erase_gran = flash->chip.erase_gran, sector_addr;
+    size_t offset, data_size, i;
 
     SFUD_ASSERT(flash);
-
-    cmd_data[0] = SFUD_CMD_ENABLE_RESET;
-    cmd_data[1] = SFUD_CMD_RESET;
-    result = spi->wr(spi, cmd_data, 2, NULL, 0);
-
-    if (result == SFUD_SUCCESS) {
-        result = wait_busy(flash);
-    }
-
-    if (result == SFUD_SUCCESS) {
-        SFUD_DEBUG("Flash device reset success.");
-    } else {
-        SFUD_INFO("Error: Flash device reset failed.");
+    SFUD_ASSERT(data);
+    /* must be call this function after initialize OK */
+    SFUD_ASSERT(flash->init_ok);
+    SFUD_ASSERT(erase_gran && erase_gran <= SFUD_UPDATE_BUF_SIZE);
+    /* check the flash address bound */
+    if (addr + size > flash->chip.capacity) {
+        SFUD_INFO("Error: Flash address is out of bound.");
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
     }
 
-    return result;
-}
-
-static sfud_err read_jedec_id(sfud_flash *flash) {
-    sfud_err result = SFUD_SUCCESS;
-    const sfud_spi *spi = &flash->spi;
-    uint8_t cmd_data[1], recv_data[3];
-
-    SFUD_ASSERT(flash);
+    while (size) {
+        sector_addr = addr - addr % erase_gran;
+        offset = addr % erase_gran;
+        data_size = erase_gran - offset;
+        if (data_size > size) {
+            data_size = size;
+        }
+        /* read the old data in the range */
+        result = sfud_read(flash, addr, data_size, buf + offset);
+        if (result != SFUD_SUCCESS) {
+            break;
+        }
+        /* NOR flash program can only change bit from 1 to 0 */
+        for (i = 0; i < data_size; i++) {
+            if ((buf[offset + i] & data[i]) != data[i]) {
+                break;
+            }
+        }
+        if (i == data_size) {
+            result = update_program(flash, addr, data_size, buf + offset, data);
+        } else {
+            /* keep the data out of the range on this sector */
+            if (offset) {
+                result = sfud_read(flash, sector_addr, offset, buf);
+            }
+            if (result == SFUD_SUCCESS && offset + data_size < erase_gran) {
+                result = sfud_read(flash, addr + data_size, erase_gran - offset - data_size,
+                        buf + offset + data_size);
+            }
+            if (result == SFUD_SUCCESS) {
+                memcpy(buf + offset, data, data_size);
+                result = sfud_erase(flash, sector_addr, erase_gran);
+            }
+            if (result == SFUD_SUCCESS) {
+                result = update_program(flash, sector_addr, erase_gran, NULL, buf);
+            }
+        }
+        if (result != SFUD_SUCCESS) {
+            break;
+        }
 
-    cmd_data[0] = SFUD_CMD_JEDEC_ID;
-    result = spi->wr(spi, cmd_data, sizeof(cmd_data), recv_data, sizeof(recv_data));
-    if (result == SFUD_SUCCESS) {
-        flash->chip.mf_id = recv_data[0];
-        flash->chip.type_id = recv_data[1];
-        flash->chip.capacity_id = recv_data[2];
-        SFUD_DEBUG("The flash device manufacturer ID is 0x%02X, memory type ID is 0x%02X, capacity ID is 0x%02X.",
-                flash->chip.mf_id, flash->chip.type_id, flash->chip.capacity_id);
-    } else {
-        SFUD_INFO("Error: Read flash device JEDEC ID error.");
+        addr += data_size;
+        data += data_size;
+        size -= data_size;
     }
 
     return result;
 }
+#endif /* SFUD_USING_UPDATE */
 
+#ifdef SFUD_USING_WRITE_BUFFER
 /**
- * set the flash write enable or write disable
+ * write flash data (no erase operate) by the page write-combining buffer
  *
  * @param flash flash device
- * @param enabled true: enable  false: disable
+ * @param addr start address
+ * @param size write size
+ * @param data write data
  *
  * @return result
  */
-static sfud_err set_write_enabled(const sfud_flash *flash, bool enabled) {
+sfud_err sfud_write_buffered(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data) {
     sfud_err result = SFUD_SUCCESS;
-    uint8_t cmd, register_status;
+    sfud_write_buffer *buf = flash->write_buf;
+    uint32_t page_addr;
+    size_t offset, data_size, i;
 
     SFUD_ASSERT(flash);
-
-    if (enabled) {
-        cmd = SFUD_CMD_WRITE_ENABLE;
-    } else {
-        cmd = SFUD_CMD_WRITE_DISABLE;
+    SFUD_ASSERT(data);
+    /* must be call this function after initialize OK */
+    SFUD_ASSERT(flash->init_ok);
+    /* check the flash address bound */
+    if (addr + size > flash->chip.capacity) {
+        SFUD_INFO("Error: Flash address is out of bound.");
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
     }
-
-    result = flash->spi.wr(&flash->spi, &cmd, 1, NULL, 0);
-
-    if (result == SFUD_SUCCESS) {
-        result = sfud_read_status(flash, &register_status);
+    /* only 256 bytes page write mode is merged */
+    if (buf == NULL || !(flash->chip.write_mode & SFUD_WM_PAGE_256B)) {
+        return sfud_write(flash, addr, size, data);
     }
 
-    if (result == SFUD_SUCCESS) {
-        if (enabled && (register_status & SFUD_STATUS_REGISTER_WEL) == 0) {
-            SFUD_INFO("Error: Can't enable write status.");
-            return SFUD_ERR_WRITE;
-        } else if (!enabled && (register_status & SFUD_STATUS_REGISTER_WEL) == 1) {
-            SFUD_INFO("Error: Can't disable write status.");
-            return SFUD_ERR_WRITE;
+    while (size) {
+        page_addr = addr - addr % SFUD_WRITE_MAX_PAGE_SIZE;
+        offset = addr % SFUD_WRITE_MAX_PAGE_SIZE;
+        data_size = SFUD_WRITE_MAX_PAGE_SIZE - offset;
+        if (data_size > size) {
+            data_size = size;
         }
+        /* write to other page, the pending page will be programmed */
+        if (buf->start != buf->end && buf->page_addr != page_addr) {
+            result = flush_write_buffer(flash, buf->page_addr, SFUD_WRITE_MAX_PAGE_SIZE);
+            if (result != SFUD_SUCCESS) {
+                return result;
+            }
+        }
+        if (buf->start == buf->end) {
+            buf->page_addr = page_addr;
+            buf->start = offset;
+            buf->end = offset;
+            memset(buf->data, 0xFF, SFUD_WRITE_MAX_PAGE_SIZE);
+        }
+        /* the twice programmed byte on NOR flash is the AND result */
+        for (i = 0; i < data_size; i++) {
+            buf->data[offset + i] &= data[i];
+        }
+        if (offset < buf->start) {
+            buf->start = offset;
+        }
+        if (offset + data_size > buf->end) {
+            buf->end = offset + data_size;
+        }
+        buf->writes++;
+        buf->idle_polls = 0;
+
+        addr += data_size;
+        data += data_size;
+        size -= data_size;
     }
 
     return result;
 }
 
 /**
- * enable or disable 4-Byte addressing for flash
- *
- * @note The 4-Byte addressing just supported for the flash capacity which is large then 16MB (256Mb).
+ * program the pending data in write-combining buffer to flash
  *
  * @param flash flash device
- * @param enabled true: enable   false: disable
  *
  * @return result
  */
-static sfud_err set_4_byte_address_mode(sfud_flash *flash, bool enabled) {
-    sfud_err result = SFUD_SUCCESS;
+sfud_err sfud_write_buffer_flush(const sfud_flash *flash) {
+    SFUD_ASSERT(flash);
+
+    return flush_write_buffer(flash, 0, flash->chip.capacity);
+}
+
+/**
+ * The write-combining buffer timeout process. It should be called periodically.
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+sfud_err sfud_write_buffer_poll(const sfud_flash *flash) {
+    sfud_write_buffer *buf = flash->write_buf;
+
+    SFUD_ASSERT(flash);
+
+    if (buf == NULL || buf->start == buf->end) {
+        return SFUD_SUCCESS;
+    }
+    if (++buf->idle_polls < SFUD_WRITE_BUFFER_TIMEOUT) {
+        return SFUD_SUCCESS;
+    }
+
+    return flush_write_buffer(flash, 0, flash->chip.capacity);
+}
+
+/**
+ * program the pending data when the buffered page is overlapped with the given range
+ */
+static sfud_err flush_write_buffer(const sfud_flash *flash, uint32_t addr, size_t size) {
+    sfud_err result = SFUD_SUCCESS;
+    sfud_write_buffer *buf = flash->write_buf;
+
+    if (buf == NULL || buf->start == buf->end) {
+        return SFUD_SUCCESS;
+    }
+    if (addr >= buf->page_addr + SFUD_WRITE_MAX_PAGE_SIZE || addr + size <= buf->page_addr) {
+        return SFUD_SUCCESS;
+    }
+
+    result = page256_or_1_byte_write(flash, buf->page_addr + buf->start, buf->end - buf->start, 256,
+            &buf->data[buf->start]);
+    buf->programs++;
+    /* the buffer is emptied even if program failed, the error is reported to the flushing caller */
+    buf->start = buf->end = 0;
+
+    return result;
+}
+#endif /* SFUD_USING_WRITE_BUFFER */
+
+#ifdef SFUD_USING_ASYNC_WRITE
+/**
+ * start to program data in one page, it doesn't wait for the program finish
+ *
+ * @note only the 256 bytes page write mode is supported
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size program size, the data must be in one page
+ * @param data program data
+ *
+ * @return result
+ */
+sfud_err sfud_program_start(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t cmd_data[5 + SFUD_WRITE_MAX_PAGE_SIZE], cmd_size;
+
+    SFUD_ASSERT(flash);
+    SFUD_ASSERT(data);
+    /* must be call this function after initialize OK */
+    SFUD_ASSERT(flash->init_ok);
+    SFUD_ASSERT(flash->chip.write_mode & SFUD_WM_PAGE_256B);
+    /* the data must be in one page */
+    SFUD_ASSERT(size && addr % 256 + size <= 256);
+    /* check the flash address bound */
+    if (addr + size > flash->chip.capacity) {
+        SFUD_INFO("Error: Flash address is out of bound.");
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* the pending data must be programmed before, so the operates are kept in order */
+    result = flush_write_buffer(flash, 0, flash->chip.capacity);
+    if (result != SFUD_SUCCESS) {
+        return result;
+    }
+#endif
+    /* lock SPI */
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+
+    /* the previous operate must be finished */
+    result = wait_busy(flash);
+    if (result == SFUD_SUCCESS) {
+        result = set_write_enabled(flash, true);
+    }
+    if (result == SFUD_SUCCESS) {
+        cmd_data[0] = flash->addr_4_byte_cmd ? SFUD_CMD_4B_PAGE_PROGRAM : SFUD_CMD_PAGE_PROGRAM;
+        make_adress_byte_array(flash, addr, &cmd_data[1]);
+        cmd_size = flash->addr_in_4_byte ? 5 : 4;
+        memcpy(&cmd_data[cmd_size], data, size);
+        result = spi->wr(spi, cmd_data, cmd_size + size, NULL, 0);
+        if (result != SFUD_SUCCESS) {
+            SFUD_INFO("Error: Flash write SPI communicate error.");
+        }
+    }
+
+    /* unlock SPI */
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+
+    return result;
+}
+
+/**
+ * start to erase one sector or block by the suitable eraser, it doesn't wait for the erase finish
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size the size which will be erased
+ * @param erase_size the erased size from the start address by this erase command
+ *
+ * @return result
+ */
+sfud_err sfud_erase_start(const sfud_flash *flash, uint32_t addr, size_t size, size_t *erase_size) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t cmd_data[5], cmd_size, cur_erase_cmd;
+    size_t cur_erase_size;
+
+    SFUD_ASSERT(flash);
+    SFUD_ASSERT(erase_size);
+    /* must be call this function after initialize OK */
+    SFUD_ASSERT(flash->init_ok);
+    /* check the flash address bound */
+    if (addr + size > flash->chip.capacity) {
+        SFUD_INFO("Error: Flash address is out of bound.");
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* the pending data must be programmed before, so the operates are kept in order */
+    result = flush_write_buffer(flash, 0, flash->chip.capacity);
+    if (result != SFUD_SUCCESS) {
+        return result;
+    }
+#endif
+
+    get_eraser(flash, addr, size, &cur_erase_cmd, &cur_erase_size);
+    /* the erased size is from the start address to the end of sector or block */
+    *erase_size = cur_erase_size - addr % cur_erase_size;
+    if (*erase_size > size) {
+        *erase_size = size;
+    }
+    /* lock SPI */
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+
+    /* the previous operate must be finished */
+    result = wait_busy(flash);
+    if (result == SFUD_SUCCESS) {
+        result = set_write_enabled(flash, true);
+    }
+    if (result == SFUD_SUCCESS) {
+        cmd_data[0] = cur_erase_cmd;
+        make_adress_byte_array(flash, addr, &cmd_data[1]);
+        cmd_size = flash->addr_in_4_byte ? 5 : 4;
+        result = spi->wr(spi, cmd_data, cmd_size, NULL, 0);
+        if (result != SFUD_SUCCESS) {
+            SFUD_INFO("Error: Flash erase SPI communicate error.");
+        }
+    }
+
+    /* unlock SPI */
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+
+    return result;
+}
+
+/**
+ * check the flash is busy on program or erase
+ *
+ * @param flash flash device
+ * @param busy true: the program or erase is running
+ *
+ * @return result
+ */
+sfud_err sfud_is_busy(const sfud_flash *flash, bool *busy) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t status;
+
+    SFUD_ASSERT(flash);
+    SFUD_ASSERT(busy);
+
+    /* lock SPI */
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+    result = sfud_read_status(flash, &status);
+    /* unlock SPI */
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+    *busy = (result != SFUD_SUCCESS || (status & SFUD_STATUS_REGISTER_BUSY));
+
+    return result;
+}
+
+/**
+ * wait for the program or erase finish
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+sfud_err sfud_wait_ready(const sfud_flash *flash) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+
+    SFUD_ASSERT(flash);
+
+    /* lock SPI */
+    if (spi->lock) {
+        spi->lock(spi);
+    }
+    result = wait_busy(flash);
+    /* unlock SPI */
+    if (spi->unlock) {
+        spi->unlock(spi);
+    }
+
+    return result;
+}
+#endif /* SFUD_USING_ASYNC_WRITE */
+
+static sfud_err reset(const sfud_flash *flash) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t cmd_data[2];
+
+    SFUD_ASSERT(flash);
+
+    cmd_data[0] = SFUD_CMD_ENABLE_RESET;
+    cmd_data[1] = SFUD_CMD_RESET;
+    result = spi->wr(spi, cmd_data, 2, NULL, 0);
+
+    if (result == SFUD_SUCCESS) {
+        result = wait_busy(flash);
+    }
+
+    if (result == SFUD_SUCCESS) {
+        SFUD_DEBUG("Flash device reset success.");
+    } else {
+        SFUD_INFO("Error: Flash device reset failed.");
+    }
+
+    return result;
+}
+
+static sfud_err read_jedec_id(sfud_flash *flash) {
+    sfud_err result = SFUD_SUCCESS;
+    const sfud_spi *spi = &flash->spi;
+    uint8_t cmd_data[1], recv_data[3];
+
+    SFUD_ASSERT(flash);
+
+    cmd_data[0] = SFUD_CMD_JEDEC_ID;
+    result = spi->wr(spi, cmd_data, sizeof(cmd_data), recv_data, sizeof(recv_data));
+    if (result == SFUD_SUCCESS) {
+        flash->chip.mf_id = recv_data[0];
+        flash->chip.type_id = recv_data[1];
+        flash->chip.capacity_id = recv_data[2];
+        SFUD_DEBUG("The flash device manufacturer ID is 0x%02X, memory type ID is 0x%02X, capacity ID is 0x%02X.",
+                flash->chip.mf_id, flash->chip.type_id, flash->chip.capacity_id);
+    } else {
+        SFUD_INFO("Error: Read flash device JEDEC ID error.");
+    }
+
+    return result;
+}
+
+/**
+ * set the flash write enable or write disable
+ *
+ * @param flash flash device
+ * @param enabled true: enable  false: disable
+ *
+ * @return result
+ */
+static sfud_err set_write_enabled(const sfud_flash *flash, bool enabled) {
+    sfud_err result = SFUD_SUCCESS;
+    uint8_t cmd, register_status;
+
+    SFUD_ASSERT(flash);
+
+    /* dual-buffer write, like AT45DB series flash has no write enable latch */
+    if (flash->chip.write_mode & SFUD_WM_DUAL_BUFFER) {
+        return SFUD_SUCCESS;
+    }
+
+    if (enabled) {
+        cmd = SFUD_CMD_WRITE_ENABLE;
+    } else {
+        cmd = SFUD_CMD_WRITE_DISABLE;
+    }
+
+    result = flash->spi.wr(&flash->spi, &cmd, 1, NULL, 0);
+
+    if (result == SFUD_SUCCESS) {
+        result = sfud_read_status(flash, &register_status);
+    }
+
+    if (result == SFUD_SUCCESS) {
+        if (enabled && (register_status & SFUD_STATUS_REGISTER_WEL) == 0) {
+            SFUD_INFO("Error: Can't enable write status.");
+            return SFUD_ERR_WRITE;
+        } else if (!enabled && (register_status & SFUD_STATUS_REGISTER_WEL) == 1) {
+            SFUD_INFO("Error: Can't disable write status.");
+            return SFUD_ERR_WRITE;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * enable or disable 4-Byte addressing for flash
+ *
+ * @note The 4-Byte addressing just supported for the flash capacity which is large then 16MB (256Mb).
+ *
+ * @param flash flash device
+ * @param enabled true: enable   false: disable
+ *
+ * @return result
+ */
+static sfud_err set_4_byte_address_mode(sfud_flash *flash, bool enabled) {
+    sfud_err result = SFUD_SUCCESS;
     uint8_t cmd;
 
     SFUD_ASSERT(flash);
@@ -833,6 +1456,45 @@ static sfud_err set_4_byte_address_mode(sfud_flash *flash, bool enabled) {
     return result;
 }
 
+/**
+ * configure the dual-buffer (like AT45DB series) flash to the binary (power of 2) page size, the dual-buffer write
+ * uses the linear buffer and page address
+ *
+ * @note The page size configuration is non-volatile. Some devices use it after power cycle, they are not supported
+ *       until that.
+ *
+ * @param flash flash device
+ *
+ * @return result
+ */
+static sfud_err set_dataflash_binary_page(const sfud_flash *flash) {
+    static const uint8_t config_cmd[] = { 0x3D, 0x2A, 0x80, 0xA6 };
+    sfud_err result = SFUD_SUCCESS;
+    uint8_t cmd = SFUD_CMD_DATAFLASH_STATUS_REGISTER, status;
+
+    SFUD_ASSERT(flash);
+
+    result = flash->spi.wr(&flash->spi, &cmd, 1, &status, 1);
+    if (result != SFUD_SUCCESS || (status & SFUD_DATAFLASH_STATUS_REGISTER_PAGE_SIZE)) {
+        return result;
+    }
+
+    SFUD_INFO("Warning: The flash is on DataFlash page size. Now will configure it to binary page size.");
+    result = flash->spi.wr(&flash->spi, config_cmd, sizeof(config_cmd), NULL, 0);
+    if (result == SFUD_SUCCESS) {
+        result = wait_busy(flash);
+    }
+    if (result == SFUD_SUCCESS) {
+        result = flash->spi.wr(&flash->spi, &cmd, 1, &status, 1);
+    }
+    if (result == SFUD_SUCCESS && (status & SFUD_DATAFLASH_STATUS_REGISTER_PAGE_SIZE) == 0) {
+        SFUD_INFO("Error: The binary page size is not used until the flash is power cycled.");
+        result = SFUD_ERR_NOT_FOUND;
+    }
+
+    return result;
+}
+
 /**
  * read flash register status
  *
@@ -852,27 +1514,116 @@ sfud_err sfud_read_status(const sfud_flash *flash, uint8_t *status) {
 
 static sfud_err wait_busy(const sfud_flash *flash) {
     sfud_err result = SFUD_SUCCESS;
-    uint8_t status;
+    uint8_t status, cmd = SFUD_CMD_DATAFLASH_STATUS_REGISTER;
     size_t retry_times = flash->retry.times;
+    bool busy = true;
 
     SFUD_ASSERT(flash);
 
     while (true) {
-        result = sfud_read_status(flash, &status);
-        if (result == SFUD_SUCCESS && ((status & SFUD_STATUS_REGISTER_BUSY)) == 0) {
+        /* dual-buffer write, like AT45DB series flash has a different status register */
+        if (flash->chip.write_mode & SFUD_WM_DUAL_BUFFER) {
+            result = flash->spi.wr(&flash->spi, &cmd, 1, &status, 1);
+            if (result == SFUD_SUCCESS) {
+                busy = (status & SFUD_DATAFLASH_STATUS_REGISTER_READY) == 0;
+            }
+        } else {
+            result = sfud_read_status(flash, &status);
+            if (result == SFUD_SUCCESS) {
+                busy = (status & SFUD_STATUS_REGISTER_BUSY) != 0;
+            }
+        }
+        /* the status is not read when the SPI failed, the busy state is kept */
+        if (result == SFUD_SUCCESS && !busy) {
             break;
         }
         /* retry counts */
         SFUD_RETRY_PROCESS(flash->retry.delay, retry_times, result);
     }
 
-    if (result != SFUD_SUCCESS || ((status & SFUD_STATUS_REGISTER_BUSY)) != 0) {
+    if (result != SFUD_SUCCESS || busy) {
         SFUD_INFO("Error: Flash wait busy has an error.");
     }
 
     return result;
 }
 
+/**
+ * get the suitable erase command and size for erasing from the address
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size the size which will be erased
+ * @param cmd erase command
+ * @param erase_size sector or block size of the erase command
+ */
+static void get_eraser(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t *cmd, size_t *erase_size) {
+#ifdef SFUD_USING_SFDP
+    extern size_t sfud_sfdp_get_suitable_eraser(const sfud_flash *flash, uint32_t addr, size_t erase_size);
+    size_t eraser_index;
+
+    /* if this flash is support SFDP parameter, then used SFDP parameter supplies eraser */
+    if (flash->sfdp.available) {
+        /* get the suitable eraser for erase process from SFDP parameter */
+        eraser_index = sfud_sfdp_get_suitable_eraser(flash, addr, size);
+        if (flash->addr_4_byte_cmd) {
+            *cmd = flash->sfdp.eraser[eraser_index].cmd_4b;
+        } else {
+            *cmd = flash->sfdp.eraser[eraser_index].cmd;
+        }
+        *erase_size = flash->sfdp.eraser[eraser_index].size;
+        return;
+    }
+#endif
+
+    *cmd = flash->chip.erase_gran_cmd;
+    *erase_size = flash->chip.erase_gran;
+}
+
+#ifdef SFUD_USING_UPDATE
+/**
+ * program the bytes which are different from the old data, the first to last different bytes on every page
+ * are programmed by one page program
+ *
+ * @param flash flash device
+ * @param addr start address
+ * @param size data size
+ * @param old old data on flash, NULL: it's erased
+ * @param data new data
+ *
+ * @return result
+ */
+static sfud_err update_program(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *old,
+        const uint8_t *data) {
+    sfud_err result = SFUD_SUCCESS;
+    size_t page_size, first, last;
+
+    while (size) {
+        page_size = SFUD_WRITE_MAX_PAGE_SIZE - addr % SFUD_WRITE_MAX_PAGE_SIZE;
+        if (page_size > size) {
+            page_size = size;
+        }
+        for (first = 0; first < page_size && data[first] == (old ? old[first] : 0xFF); first++);
+        for (last = page_size; last > first && data[last - 1] == (old ? old[last - 1] : 0xFF); last--);
+        if (first < last) {
+            result = sfud_write(flash, addr + first, last - first, data + first);
+            if (result != SFUD_SUCCESS) {
+                break;
+            }
+        }
+
+        addr += page_size;
+        data += page_size;
+        if (old) {
+            old += page_size;
+        }
+        size -= page_size;
+    }
+
+    return result;
+}
+#endif /* SFUD_USING_UPDATE */
+
 static void make_adress_byte_array(const sfud_flash *flash, uint32_t addr, uint8_t *array) {
     uint8_t len, i;
 
@@ -886,6 +1637,112 @@ static void make_adress_byte_array(const sfud_flash *flash, uint32_t addr, uint8
     }
 }
 
+#ifdef SFUD_USING_PARAM_CACHE
+static uint32_t calc_crc32(const uint8_t *buf, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t i;
+
+    while (size--) {
+        crc ^= *buf++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 0x01)));
+        }
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+/**
+ * load the flash parameters from the cached record which is saved by port
+ *
+ * @param flash flash device, the JEDEC ID must be read before
+ *
+ * @return true: the record is valid and the JEDEC ID is matched
+ */
+static bool read_param_cache(sfud_flash *flash) {
+    extern sfud_err sfud_port_read_param_cache(const sfud_flash *flash, uint8_t *buf, size_t size);
+
+    sfud_param_cache cache;
+
+    SFUD_ASSERT(flash);
+
+    if (sfud_port_read_param_cache(flash, (uint8_t *) &cache, sizeof(cache)) != SFUD_SUCCESS) {
+        return false;
+    }
+    if (cache.magic != PARAM_CACHE_MAGIC_WORD || cache.size != sizeof(cache)
+            || cache.crc32 != calc_crc32((uint8_t *) &cache, offsetof(sfud_param_cache, crc32))) {
+        SFUD_DEBUG("The flash parameter cache is invalid.");
+        return false;
+    }
+    if (cache.chip.mf_id != flash->chip.mf_id || cache.chip.type_id != flash->chip.type_id
+            || cache.chip.capacity_id != flash->chip.capacity_id) {
+        SFUD_DEBUG("The flash parameter cache isn't belong to this flash device.");
+        return false;
+    }
+
+    flash->chip = cache.chip;
+    flash->chip.name = NULL;
+#ifdef SFUD_USING_FLASH_INFO_TABLE
+    if (cache.chip_name_index < sizeof(flash_chip_table) / sizeof(sfud_flash_chip)) {
+        flash->chip.name = flash_chip_table[cache.chip_name_index].name;
+    }
+#endif
+#ifdef SFUD_USING_SFDP
+    flash->sfdp = cache.sfdp;
+#endif
+    SFUD_DEBUG("Load the flash parameters from cache.");
+
+    return true;
+}
+
+/**
+ * save the probed flash parameters to cache by port
+ *
+ * @param flash flash device
+ */
+static void write_param_cache(const sfud_flash *flash) {
+    extern sfud_err sfud_port_write_param_cache(const sfud_flash *flash, const uint8_t *buf, size_t size);
+
+    sfud_param_cache cache;
+
+    SFUD_ASSERT(flash);
+
+    /* clean the padding bytes */
+    memset(&cache, 0, sizeof(cache));
+    cache.magic = PARAM_CACHE_MAGIC_WORD;
+    cache.size = sizeof(cache);
+    cache.chip_name_index = PARAM_CACHE_NO_CHIP_NAME;
+#ifdef SFUD_USING_FLASH_INFO_TABLE
+    {
+        size_t i;
+        for (i = 0; flash->chip.name && i < sizeof(flash_chip_table) / sizeof(sfud_flash_chip); i++) {
+            if (flash_chip_table[i].name == flash->chip.name) {
+                cache.chip_name_index = i;
+                break;
+            }
+        }
+    }
+#endif
+    cache.chip.mf_id = flash->chip.mf_id;
+    cache.chip.type_id = flash->chip.type_id;
+    cache.chip.capacity_id = flash->chip.capacity_id;
+    cache.chip.capacity = flash->chip.capacity;
+    cache.chip.write_mode = flash->chip.write_mode;
+    cache.chip.erase_gran = flash->chip.erase_gran;
+    cache.chip.erase_gran_cmd = flash->chip.erase_gran_cmd;
+#ifdef SFUD_USING_SFDP
+    cache.sfdp = flash->sfdp;
+#endif
+    cache.crc32 = calc_crc32((uint8_t *) &cache, offsetof(sfud_param_cache, crc32));
+
+    if (sfud_port_write_param_cache(flash, (uint8_t *) &cache, sizeof(cache)) == SFUD_SUCCESS) {
+        SFUD_DEBUG("Save the flash parameters to cache success.");
+    } else {
+        SFUD_INFO("Warning: Save the flash parameters to cache failed.");
+    }
+}
+#endif /* SFUD_USING_PARAM_CACHE */
+
 /**
  * write status register
  *
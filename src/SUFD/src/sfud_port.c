@@ -31,19 +31,71 @@
 #include <stdio.h>
 #include <string.h>
 #include <stm32f1xx_hal.h>
+#ifdef SFUD_USING_SPI_BUS
+#include <spi_bus.h>
+#if !defined(SPI_BUS_USING_SPI2)
+#error "SFUD_USING_SPI_BUS needs SPI_BUS_USING_SPI2 on 'spi_bus_cfg.h'"
+#endif
+#endif /* SFUD_USING_SPI_BUS */
+
+/* verify times on every prescaler for SPI clock calibration, 0: calibration is disabled */
+#ifndef SFUD_PORT_CALIBRATE_TIMES
+#define SFUD_PORT_CALIBRATE_TIMES                8
+#endif
+
+/* the maximum SPI clock of read data (03h and 13h) command, it's lower than others. W25Q64FV fR is 50MHz */
+#ifndef SFUD_PORT_READ_DATA_MAX_HZ
+#define SFUD_PORT_READ_DATA_MAX_HZ               50000000
+#endif
+
+#ifdef SFUD_USING_NOR_FLASH1
+/* the CS pin of the second SPI flash on SPI2 */
+#ifndef SFUD_NOR_FLASH1_CS_GPIOX
+#define SFUD_NOR_FLASH1_CS_GPIOX                 GPIOB
+#endif
+#ifndef SFUD_NOR_FLASH1_CS_PIN
+#define SFUD_NOR_FLASH1_CS_PIN                   GPIO_PIN_11
+#endif
+#endif /* SFUD_USING_NOR_FLASH1 */
+
+#ifdef SFUD_USING_SPI_BUS
+/* the priority of SPI flash on SPI bus arbiter, 0 is the highest */
+#ifndef SFUD_PORT_SPI_BUS_PRIORITY
+#define SFUD_PORT_SPI_BUS_PRIORITY               0
+#endif
+#endif /* SFUD_USING_SPI_BUS */
 
 typedef struct {
     SPI_TypeDef *spix;
     SPI_HandleTypeDef *spi_handle;
     GPIO_TypeDef *cs_gpiox;
     uint16_t cs_gpio_pin;
+    uint32_t prescaler;                          /* calibrated prescaler */
+    uint32_t read_prescaler;                     /* prescaler for read data command */
+#ifdef SFUD_USING_SPI_BUS
+    spi_bus_device bus_dev;                      /* the device on SPI bus arbiter */
+#endif
 } spi_user_data, *spi_user_data_t;
 
+/* the candidate prescalers, from the fastest to the slowest */
+static const uint32_t prescaler_table[] = { SPI_BAUDRATEPRESCALER_2, SPI_BAUDRATEPRESCALER_4, SPI_BAUDRATEPRESCALER_8,
+        SPI_BAUDRATEPRESCALER_16, SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_128,
+        SPI_BAUDRATEPRESCALER_256 };
+
 static char log_buf[256];
 
 void sfud_log_debug(const char *file, const long line, const char *format, ...);
 
 static SPI_HandleTypeDef hspi2;
+#ifdef SFUD_USING_SPI_BUS
+/* Every SPI transaction acquires the bus by arbiter, the bus isn't held for the whole flash operation. So the other
+ * devices can use the bus while the flash is busy on program or erase. The SFUD APIs must be called on one thread. */
+static void spi_lock(const sfud_spi *spi) {
+}
+
+static void spi_unlock(const sfud_spi *spi) {
+}
+#else
 static void spi_configuration(spi_user_data_t spi)
 {
     SPI_HandleTypeDef *spi_handle = spi->spi_handle;
@@ -65,6 +117,21 @@ static void spi_configuration(spi_user_data_t spi)
     HAL_SPI_Init(spi_handle);
 }
 
+/* the SPI bus may be shared by several flash devices, so the prescaler is checked on SPI handle */
+static void spi_set_prescaler(spi_user_data_t spi, uint32_t prescaler)
+{
+    SPI_HandleTypeDef *spi_handle = spi->spi_handle;
+
+    if (spi_handle->Init.BaudRatePrescaler == prescaler)
+    {
+        return;
+    }
+    __HAL_SPI_DISABLE(spi_handle);
+    spi_handle->Init.BaudRatePrescaler = prescaler;
+    MODIFY_REG(spi_handle->Instance->CR1, SPI_CR1_BR, prescaler);
+    __HAL_SPI_ENABLE(spi_handle);
+}
+
 static void spi_lock(const sfud_spi *spi) {
     __disable_irq();
 }
@@ -72,6 +139,7 @@ static void spi_lock(const sfud_spi *spi) {
 static void spi_unlock(const sfud_spi *spi) {
     __enable_irq();
 }
+#endif /* SFUD_USING_SPI_BUS */
 
 /**
  * SPI write data then read data
@@ -80,7 +148,9 @@ static sfud_err spi_write_read(const sfud_spi *spi, const uint8_t *write_buf, si
         size_t read_size) {
     sfud_err result = SFUD_SUCCESS;
     spi_user_data_t spi_dev = (spi_user_data_t) spi->user_data;
+#ifndef SFUD_USING_SPI_BUS
     HAL_StatusTypeDef state = HAL_OK;
+#endif
 
     if (write_size) {
         SFUD_ASSERT(write_buf);
@@ -89,6 +159,25 @@ static sfud_err spi_write_read(const sfud_spi *spi, const uint8_t *write_buf, si
         SFUD_ASSERT(read_buf);
     }
 
+#ifdef SFUD_USING_SPI_BUS
+    /* the bus is reconfigured by arbiter when the prescaler is changed */
+    if (write_size && (write_buf[0] == SFUD_CMD_READ_DATA || write_buf[0] == SFUD_CMD_4B_READ_DATA)) {
+        spi_dev->bus_dev.prescaler = spi_dev->read_prescaler;
+    } else {
+        spi_dev->bus_dev.prescaler = spi_dev->prescaler;
+    }
+    if (spi_bus_transfer(&spi_dev->bus_dev, write_buf, write_size, read_buf, read_size) != SPI_BUS_SUCCESS) {
+        result = SFUD_ERR_TIMEOUT;
+    }
+    return result;
+#else
+    /* the read data command has a lower maximum clock than the others */
+    if (write_size && (write_buf[0] == SFUD_CMD_READ_DATA || write_buf[0] == SFUD_CMD_4B_READ_DATA)) {
+        spi_set_prescaler(spi_dev, spi_dev->read_prescaler);
+    } else {
+        spi_set_prescaler(spi_dev, spi_dev->prescaler);
+    }
+
     HAL_GPIO_WritePin(spi_dev->cs_gpiox, spi_dev->cs_gpio_pin, GPIO_PIN_RESET);
 
     if (write_size) {
@@ -111,6 +200,7 @@ __exit:
     HAL_GPIO_WritePin(spi_dev->cs_gpiox, spi_dev->cs_gpio_pin, GPIO_PIN_SET);
 
     return result;
+#endif /* SFUD_USING_SPI_BUS */
 }
 
 /* about 100 microsecond delay */
@@ -119,35 +209,184 @@ static void retry_delay_100us(void) {
     while(delay--);
 }
 
+/**
+ * read the JEDEC ID and SFDP header, they are used as the known pattern for SPI clock calibration
+ */
+static sfud_err spi_read_pattern(const sfud_spi *spi, uint8_t *pattern)
+{
+    uint8_t jedec_id_cmd = SFUD_CMD_JEDEC_ID;
+    uint8_t sfdp_cmd[] = { SFUD_CMD_READ_SFDP_REGISTER, 0x00, 0x00, 0x00, SFUD_DUMMY_DATA };
+    sfud_err result;
+
+    result = spi->wr(spi, &jedec_id_cmd, 1, pattern, 3);
+    if (result == SFUD_SUCCESS)
+    {
+        result = spi->wr(spi, sfdp_cmd, sizeof(sfdp_cmd), pattern + 3, 8);
+    }
+
+    return result;
+}
+
+/**
+ * Calibrate the SPI clock. The known pattern is read on the slowest clock as reference. Then the fastest
+ * prescaler which passes all of the verify times will be kept. The read data command uses the fastest
+ * prescaler which isn't faster than its maximum clock.
+ */
+static void spi_calibrate(const sfud_spi *spi)
+{
+    spi_user_data_t spi_dev = (spi_user_data_t) spi->user_data;
+    uint8_t reference[11], pattern[11];
+    uint32_t pclk;
+    size_t i, j, read_index, num = sizeof(prescaler_table) / sizeof(prescaler_table[0]);
+
+    /* read the reference pattern on the slowest clock */
+    spi_dev->prescaler = prescaler_table[num - 1];
+    if (spi_read_pattern(spi, reference) != SFUD_SUCCESS || reference[0] == 0x00 || reference[0] == 0xFF)
+    {
+        SFUD_INFO("Warning: SPI clock calibration failed, the flash device is not responded.");
+        spi_dev->prescaler = prescaler_table[0];
+        spi_dev->read_prescaler = prescaler_table[0];
+        return;
+    }
+    for (i = 0; i < num - 1; i++)
+    {
+        spi_dev->prescaler = prescaler_table[i];
+        for (j = 0; j < SFUD_PORT_CALIBRATE_TIMES; j++)
+        {
+            if (spi_read_pattern(spi, pattern) != SFUD_SUCCESS || memcmp(pattern, reference, sizeof(pattern)))
+            {
+                break;
+            }
+        }
+        if (j == SFUD_PORT_CALIBRATE_TIMES)
+        {
+            break;
+        }
+    }
+    spi_dev->prescaler = prescaler_table[i];
+    /* SPI1 is on APB2, others are on APB1 */
+    pclk = spi_dev->spix == SPI1 ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+    for (read_index = i; read_index < num - 1 && (pclk >> (read_index + 1)) > SFUD_PORT_READ_DATA_MAX_HZ;
+            read_index++);
+    spi_dev->read_prescaler = prescaler_table[read_index];
+    SFUD_DEBUG("SPI clock calibration is OK. The clock is %ld Hz, read data clock is %ld Hz.", pclk >> (i + 1),
+            pclk >> (read_index + 1));
+}
+
 static spi_user_data spi2 = { .spix = SPI2, .cs_gpiox = GPIOB, .cs_gpio_pin = GPIO_PIN_12, .spi_handle = &hspi2};
+#ifdef SFUD_USING_NOR_FLASH1
+static spi_user_data spi2_cs1 = { .spix = SPI2, .cs_gpiox = SFUD_NOR_FLASH1_CS_GPIOX,
+        .cs_gpio_pin = SFUD_NOR_FLASH1_CS_PIN, .spi_handle = &hspi2};
+#endif
+
 sfud_err sfud_spi_port_init(sfud_flash *flash) {
     sfud_err result = SFUD_SUCCESS;
+    spi_user_data_t spi_dev = NULL;
 
     if (!strcmp(flash->spi.name, "SPI2"))
+    {
+        spi_dev = &spi2;
+    }
+#ifdef SFUD_USING_NOR_FLASH1
+    else if (!strcmp(flash->spi.name, "SPI2_CS1"))
+    {
+        spi_dev = &spi2_cs1;
+    }
+#endif
+
+    if (spi_dev)
     {
         GPIO_InitTypeDef GPIO_Initure;
 
-        spi_configuration(&spi2);
+#ifdef SFUD_USING_SPI_BUS
+        /* the SPI bus is configured by arbiter */
+        spi_dev->bus_dev.name = flash->name;
+        spi_dev->bus_dev.mode = SPI_BUS_MODE_0;
+        spi_dev->bus_dev.prescaler = SPI_BAUDRATEPRESCALER_2;
+        spi_dev->bus_dev.cs_port = spi_dev->cs_gpiox;
+        spi_dev->bus_dev.cs_pin = spi_dev->cs_gpio_pin;
+        spi_dev->bus_dev.priority = SFUD_PORT_SPI_BUS_PRIORITY;
+#else
+        /* the SPI bus is shared by the flash devices, it's configured by the first one */
+        if (spi_dev->spi_handle->Instance != spi_dev->spix)
+        {
+            spi_configuration(spi_dev);
+        }
+#endif /* SFUD_USING_SPI_BUS */
+        spi_dev->prescaler = SPI_BAUDRATEPRESCALER_2;
+        spi_dev->read_prescaler = SPI_BAUDRATEPRESCALER_2;
 
-        GPIO_Initure.Pin = spi2.cs_gpio_pin;
+        GPIO_Initure.Pin = spi_dev->cs_gpio_pin;
         GPIO_Initure.Mode = GPIO_MODE_OUTPUT_PP;
         GPIO_Initure.Pull = GPIO_PULLUP;
         GPIO_Initure.Speed = GPIO_SPEED_FREQ_HIGH;
-        HAL_GPIO_Init(spi2.cs_gpiox, &GPIO_Initure);
-        HAL_GPIO_WritePin(spi2.cs_gpiox, spi2.cs_gpio_pin, GPIO_PIN_SET);
+        HAL_GPIO_Init(spi_dev->cs_gpiox, &GPIO_Initure);
+        HAL_GPIO_WritePin(spi_dev->cs_gpiox, spi_dev->cs_gpio_pin, GPIO_PIN_SET);
+#ifdef SFUD_USING_SPI_BUS
+        spi_bus_attach(spi_bus_port_get("SPI2"), &spi_dev->bus_dev);
+#endif
 
         flash->spi.wr = spi_write_read;
         flash->spi.lock = spi_lock;
         flash->spi.unlock = spi_unlock;
-        flash->spi.user_data = &spi2;
+        flash->spi.user_data = spi_dev;
         /* about 100 microsecond delay */
         flash->retry.delay = retry_delay_100us;
         /* adout 60 seconds timeout */
         flash->retry.times = 60 * 10000;
+#if SFUD_PORT_CALIBRATE_TIMES
+        spi_calibrate(&flash->spi);
+#endif
+    }
+
+    return result;
+}
+
+#ifdef SFUD_USING_PARAM_CACHE
+/* The flash parameter cache is saved on the last on-chip flash page of bootloader partition (64K). The page is
+ * reserved by the IROM1 size (0xF800) of the Keil project, so the linker rejects the bootloader image which uses it.
+ * Change both of them together. */
+#ifndef SFUD_PARAM_CACHE_ADDR
+#define SFUD_PARAM_CACHE_ADDR                    (0x08000000 + 64 * 1024 - FLASH_PAGE_SIZE)
+#endif
+
+sfud_err sfud_port_read_param_cache(const sfud_flash *flash, uint8_t *buf, size_t size) {
+    memcpy(buf, (const uint8_t *) SFUD_PARAM_CACHE_ADDR, size);
+
+    return SFUD_SUCCESS;
+}
+
+sfud_err sfud_port_write_param_cache(const sfud_flash *flash, const uint8_t *buf, size_t size) {
+    sfud_err result = SFUD_SUCCESS;
+    FLASH_EraseInitTypeDef erase_init;
+    uint32_t page_error = 0, addr = SFUD_PARAM_CACHE_ADDR, data;
+    size_t i;
+
+    erase_init.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase_init.PageAddress = addr;
+    erase_init.NbPages = 1;
+
+    HAL_FLASH_Unlock();
+    if (HAL_FLASHEx_Erase(&erase_init, &page_error) != HAL_OK) {
+        result = SFUD_ERR_WRITE;
+        goto __exit;
     }
+    /* the on-chip flash is programmed by word */
+    for (i = 0; i < size; i += 4, addr += 4) {
+        data = 0xFFFFFFFF;
+        memcpy(&data, buf + i, size - i < 4 ? size - i : 4);
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, data) != HAL_OK) {
+            result = SFUD_ERR_WRITE;
+            goto __exit;
+        }
+    }
+
+__exit:
+    HAL_FLASH_Lock();
 
     return result;
 }
+#endif /* SFUD_USING_PARAM_CACHE */
 
 /**
  * This function is print debug info.
@@ -192,12 +431,24 @@ sfud_flash sfud_norflash0 = {
         .spi.name = "SPI2",
         .chip = { "W25Q64FV", SFUD_MF_ID_WINBOND, 0x40, 0x17, 8L * 1024L * 1024L, SFUD_WM_PAGE_256B, 4096, 0x20 } };
 
+#ifdef SFUD_USING_NOR_FLASH1
+sfud_flash sfud_norflash1 = {
+        .name = "norflash1",
+        .spi.name = "SPI2_CS1",
+        .chip = { "W25Q64FV", SFUD_MF_ID_WINBOND, 0x40, 0x17, 8L * 1024L * 1024L, SFUD_WM_PAGE_256B, 4096, 0x20 } };
+#endif
+
 int spi_flash_init(void)
 {
     /* SFUD initialize */
-    if (sfud_device_init(&sfud_norflash0) == SFUD_SUCCESS) {
-        return 0;
-    } else {
+    if (sfud_device_init(&sfud_norflash0) != SFUD_SUCCESS) {
+        return -1;
+    }
+#ifdef SFUD_USING_NOR_FLASH1
+    if (sfud_device_init(&sfud_norflash1) != SFUD_SUCCESS) {
         return -1;
     }
+#endif
+
+    return 0;
 }
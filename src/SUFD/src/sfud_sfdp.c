@@ -50,6 +50,12 @@
 #define BASIC_TABLE_LEN                             9
 /* the smallest eraser in SFDP eraser table */
 #define SMALLEST_ERASER_INDEX                       0
+/* the JEDEC 4-Byte address instruction parameter table ID (MSB and LSB) on JESD216B */
+#define ADDR_4B_TABLE_ID                            0xFF84
+/* the JEDEC 4-Byte address instruction parameter table length is 2 DWORDs */
+#define ADDR_4B_TABLE_LEN                           2
+/* the erase types offset in JEDEC basic flash parameter table, it's the 8th DWORD */
+#define BASIC_TABLE_ERASE_TYPES_OFFSET              28
 /**
  *  SFDP parameter header structure
  */
@@ -62,9 +68,10 @@ typedef struct {
 } sfdp_para_header;
 
 static sfud_err read_sfdp_data(const sfud_flash *flash, uint32_t addr, uint8_t *read_buf, size_t size);
-static bool read_sfdp_header(sfud_flash *flash);
+static bool read_sfdp_header(sfud_flash *flash, uint8_t *nph);
 static bool read_basic_header(const sfud_flash *flash, sfdp_para_header *basic_header);
 static bool read_basic_table(sfud_flash *flash, sfdp_para_header *basic_header);
+static bool read_4b_addr_table(sfud_flash *flash, uint8_t nph, const sfdp_para_header *basic_header);
 
 /* ../port/sfup_port.c */
 extern void sfud_log_debug(const char *file, const long line, const char *format, ...);
@@ -82,8 +89,15 @@ bool sfud_read_sfdp(sfud_flash *flash) {
 
     /* JEDEC basic flash parameter header */
     sfdp_para_header basic_header;
-    if (read_sfdp_header(flash) && read_basic_header(flash, &basic_header)) {
-        return read_basic_table(flash, &basic_header);
+    /* number of parameter headers */
+    uint8_t nph;
+    if (read_sfdp_header(flash, &nph) && read_basic_header(flash, &basic_header)) {
+        if (!read_basic_table(flash, &basic_header)) {
+            return false;
+        }
+        /* the 4-Byte address instruction table is optional */
+        read_4b_addr_table(flash, nph, &basic_header);
+        return true;
     } else {
         SFUD_INFO("Warning: Read SFDP parameter header information failed. The %s is not support JEDEC SFDP.", flash->name);
         return false;
@@ -94,10 +108,11 @@ bool sfud_read_sfdp(sfud_flash *flash) {
  * Read SFDP parameter header
  *
  * @param flash flash device
+ * @param nph number of parameter headers (zero-based)
  *
  * @return true: read OK
  */
-static bool read_sfdp_header(sfud_flash *flash) {
+static bool read_sfdp_header(sfud_flash *flash, uint8_t *nph) {
     sfud_sfdp *sfdp = &flash->sfdp;
     /* The SFDP header is located at address 000000h of the SFDP data structure.
      * It identifies the SFDP Signature, the number of parameter headers, and the SFDP revision numbers. */
@@ -130,6 +145,7 @@ static bool read_sfdp_header(sfud_flash *flash) {
     }
     SFUD_DEBUG("Check SFDP header is OK. The reversion is V%d.%d, NPN is %d.", sfdp->major_rev, sfdp->minor_rev,
             header[6]);
+    *nph = header[6];
 
     return true;
 }
@@ -334,6 +350,91 @@ static bool read_basic_table(sfud_flash *flash, sfdp_para_header *basic_header)
     return true;
 }
 
+/**
+ * Read JEDEC 4-Byte address instruction parameter table (JESD216B). The table is found by parameter ID
+ * from the parameter headers. The erase types of this table are matched to eraser table by the basic table.
+ *
+ * @param flash flash device
+ * @param nph number of parameter headers (zero-based)
+ * @param basic_header JEDEC basic flash parameter header
+ *
+ * @return true: the 4-Byte address read, program and erase commands are all supported
+ */
+static bool read_4b_addr_table(sfud_flash *flash, uint8_t nph, const sfdp_para_header *basic_header) {
+    sfud_sfdp *sfdp = &flash->sfdp;
+    /* each parameter header being 2 DWORDs (64-bit) */
+    uint8_t header[2 * 4] = { 0 };
+    /* parameter table */
+    uint8_t table[ADDR_4B_TABLE_LEN * 4] = { 0 };
+    /* the erase types of JEDEC basic flash parameter table */
+    uint8_t erase_types[SFUD_SFDP_ERASE_TYPE_MAX_NUM * 2] = { 0 };
+    uint32_t table_addr = 0, support;
+    size_t i, j;
+
+    SFUD_ASSERT(flash);
+    SFUD_ASSERT(basic_header);
+
+    sfdp->addr_4_byte_cmd = false;
+    for (i = 0; i < SFUD_SFDP_ERASE_TYPE_MAX_NUM; i++) {
+        sfdp->eraser[i].cmd_4b = 0x00;
+    }
+    if (!sfdp->addr_4_byte) {
+        return false;
+    }
+    /* find the table from 2nd parameter header, the 1st is JEDEC basic flash parameter header */
+    for (i = 1; i <= nph; i++) {
+        if (read_sfdp_data(flash, 8 + i * 8, header, sizeof(header)) != SFUD_SUCCESS) {
+            SFUD_INFO("Warning: Can't read SFDP parameter header.");
+            return false;
+        }
+        if (((uint16_t) header[7] << 8 | header[0]) == ADDR_4B_TABLE_ID && header[3] >= ADDR_4B_TABLE_LEN) {
+            table_addr = (long)header[4] | (long)header[5] << 8 | (long)header[6] << 16;
+            break;
+        }
+    }
+    if (i > nph) {
+        SFUD_DEBUG("The JEDEC 4-Byte address instruction table is not found.");
+        return false;
+    }
+    /* read JEDEC 4-Byte address instruction table and erase types */
+    if (read_sfdp_data(flash, table_addr, table, sizeof(table)) != SFUD_SUCCESS
+            || read_sfdp_data(flash, basic_header->ptp + BASIC_TABLE_ERASE_TYPES_OFFSET, erase_types,
+                    sizeof(erase_types)) != SFUD_SUCCESS) {
+        SFUD_INFO("Warning: Can't read JEDEC 4-Byte address instruction table.");
+        return false;
+    }
+    support = ((long)table[3] << 24) | ((long)table[2] << 16) | ((long)table[1] << 8) | (long)table[0];
+    SFUD_DEBUG("4-Byte address instruction table support is 0x%08lX.", support);
+    /* the erase type N is supported by bit (8 + N), the command is in the 2nd DWORD */
+    for (i = 0; i < SFUD_SFDP_ERASE_TYPE_MAX_NUM; i++) {
+        if (erase_types[2 * i] == 0x00 || !(support & (1L << (9 + i)))) {
+            continue;
+        }
+        for (j = 0; j < SFUD_SFDP_ERASE_TYPE_MAX_NUM; j++) {
+            if (sfdp->eraser[j].size == 1L << erase_types[2 * i] && sfdp->eraser[j].cmd == erase_types[2 * i + 1]) {
+                sfdp->eraser[j].cmd_4b = table[4 + i];
+                SFUD_DEBUG("Flash device supports %ldKB block erase by 4-Byte address. Command is 0x%02X.",
+                        sfdp->eraser[j].size / 1024, sfdp->eraser[j].cmd_4b);
+            }
+        }
+    }
+    /* the read (13h) and page program (12h) commands are necessary */
+    if (!(support & (1L << 0)) || !(support & (1L << 6))) {
+        SFUD_DEBUG("The 4-Byte address read or page program command is not supported.");
+        return false;
+    }
+    /* all of the erasers must have 4-Byte address command */
+    for (i = 0; i < SFUD_SFDP_ERASE_TYPE_MAX_NUM; i++) {
+        if (sfdp->eraser[i].size != 0 && sfdp->eraser[i].cmd_4b == 0x00) {
+            SFUD_DEBUG("The %ldKB block erase is not supported by 4-Byte address.", sfdp->eraser[i].size / 1024);
+            return false;
+        }
+    }
+    sfdp->addr_4_byte_cmd = true;
+
+    return true;
+}
+
 static sfud_err read_sfdp_data(const sfud_flash *flash, uint32_t addr, uint8_t *read_buf, size_t size) {
     uint8_t cmd[] = {
             SFUD_CMD_READ_SFDP_REGISTER,
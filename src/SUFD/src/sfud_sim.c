@@ -0,0 +1,723 @@
+/*
+ * This file is part of the Serial Flash Universal Driver Library.
+ *
+ * Function: Host side W25Qxx SPI NOR flash simulator. It implements the sfud_spi.wr contract.
+ * Created on: 2026-10-19
+ */
+
+#include <sfud_sim.h>
+#include <string.h>
+
+/**
+ * The simulator decodes every SPI transaction as one W25Qxx command. It is cycle approximate:
+ * the bus time is calculated by the clocked bytes and the array busy time by the timing model.
+ * All simulated devices share one simulated clock, so that several devices on one host behave
+ * like several chips on one board.
+ *
+ * NOR semantics:
+ * 1. page program can only change bits from 1 to 0, the programmed data is wrapped in the page
+ * 2. erase sets the whole (aligned) sector or block to 0xFF
+ * 3. program, erase and status register write need the write enable latch, it will be cleared when finished
+ * 4. all commands except read status, suspend and reset are ignored when the device is busy
+ *
+ * The power cut is simulated by a budget of programmed bytes and erased 4K sectors. The byte which is programming
+ * when the power is cut has half of its bits programmed, and the sector which is erasing has half of it erased.
+ *
+ * The device which is larger than 16MB supports the 4-Byte addressing mode (0xB7/0xE9) and the 4-Byte
+ * address commands, like W25Q256. The reset returns to 3-Byte addressing mode.
+ */
+
+/* the commands which are not used by the SFUD core */
+#define SIM_CMD_FAST_READ_DATA                         0x0B
+#define SIM_CMD_READ_STATUS_REGISTER2                  0x35
+#define SIM_CMD_ERASE_4K                               0x20
+#define SIM_CMD_ERASE_32K                              0x52
+#define SIM_CMD_ERASE_64K                              0xD8
+#define SIM_CMD_ERASE_CHIP2                            0x60
+#define SIM_CMD_SUSPEND                                0x75
+#define SIM_CMD_RESUME                                 0x7A
+#define SIM_CMD_4B_ERASE_4K                            0x21
+#define SIM_CMD_4B_ERASE_32K                           0x5C
+#define SIM_CMD_4B_ERASE_64K                           0xDC
+
+/* the SFDP basic flash parameter table offset */
+#define SIM_SFDP_BASIC_TABLE_ADDR                      0x80
+/* the SFDP 4-Byte address instruction table offset */
+#define SIM_SFDP_4B_TABLE_ADDR                         0xC0
+
+/* the simulated time (nanoseconds), it's shared by all simulated devices */
+static uint64_t sim_time = 0;
+
+/* ../port/sfup_port.c */
+extern void sfud_log_debug(const char *file, const long line, const char *format, ...);
+extern void sfud_log_info(const char *format, ...);
+
+static void build_sfdp(sfud_sim *sim);
+static void update_busy(sfud_sim *sim);
+static bool is_busy(const sfud_sim *sim);
+static void start_busy(sfud_sim *sim, uint8_t op, uint64_t ns);
+static uint32_t get_addr(const uint8_t *buf, uint8_t len);
+static void read_array(sfud_sim *sim, uint32_t addr, uint8_t *read_buf, size_t read_size);
+static void program_page(sfud_sim *sim, uint32_t addr, const uint8_t *data, size_t size);
+static void erase_array(sfud_sim *sim, uint32_t addr, uint32_t size, uint64_t ns);
+static bool power_is_cut(sfud_sim *sim);
+
+/**
+ * Get the default W25Q64FV simulator configuration.
+ * The bus is clocked at 18MHz, it's the maximum SPI2 clock on STM32F103.
+ *
+ * @param cfg configuration
+ */
+void sfud_sim_default_config(sfud_sim_config *cfg) {
+    SFUD_ASSERT(cfg);
+
+    memset(cfg, 0, sizeof(sfud_sim_config));
+    cfg->mf_id = SFUD_MF_ID_WINBOND;
+    cfg->type_id = 0x40;
+    cfg->capacity_id = 0x17;
+    cfg->capacity = 8L * 1024L * 1024L;
+    cfg->sfdp = true;
+    cfg->addr_4b_table = true;
+    cfg->timing.sck_ns = 56;
+    cfg->timing.cs_ns = 1000;
+    cfg->timing.program_base_ns = 200 * 1000;
+    cfg->timing.program_byte_ns = 2 * 1000;
+    cfg->timing.erase_4k_ns = 45 * 1000 * 1000;
+    cfg->timing.erase_32k_ns = 120 * 1000 * 1000;
+    cfg->timing.erase_64k_ns = 150 * 1000 * 1000;
+    cfg->timing.erase_chip_ns = 20ULL * 1000 * 1000 * 1000;
+    cfg->timing.write_status_ns = 10 * 1000 * 1000;
+    cfg->timing.suspend_ns = 20 * 1000;
+    cfg->timing.resume_ns = 0;
+}
+
+/**
+ * Initialize the simulated device. The memory array will be erased.
+ *
+ * @param sim simulated device
+ * @param cfg configuration
+ *
+ * @return result
+ */
+sfud_err sfud_sim_init(sfud_sim *sim, const sfud_sim_config *cfg) {
+    size_t sector_num;
+
+    SFUD_ASSERT(sim);
+    SFUD_ASSERT(cfg);
+    /* the capacity must be aligned by 64K block */
+    SFUD_ASSERT(cfg->capacity && cfg->capacity % (64L * 1024L) == 0);
+
+    memset(sim, 0, sizeof(sfud_sim));
+    sim->cfg = *cfg;
+    sector_num = cfg->capacity / SFUD_SIM_SECTOR_SIZE;
+    sim->array = malloc(cfg->capacity);
+    sim->erase_count = calloc(sector_num, sizeof(uint32_t));
+    if (!sim->array || !sim->erase_count) {
+        sfud_sim_deinit(sim);
+        return SFUD_ERR_NOT_FOUND;
+    }
+    memset(sim->array, 0xFF, cfg->capacity);
+    build_sfdp(sim);
+
+    return SFUD_SUCCESS;
+}
+
+/**
+ * Free the simulated device memory.
+ *
+ * @param sim simulated device
+ */
+void sfud_sim_deinit(sfud_sim *sim) {
+    SFUD_ASSERT(sim);
+
+    free(sim->array);
+    free(sim->erase_count);
+    sim->array = NULL;
+    sim->erase_count = NULL;
+}
+
+/**
+ * Attach the simulated device to the flash device's SPI. It's used on sfud_spi_port_init.
+ *
+ * @param sim simulated device
+ * @param flash flash device
+ */
+void sfud_sim_attach(sfud_sim *sim, sfud_flash *flash) {
+    SFUD_ASSERT(sim);
+    SFUD_ASSERT(flash);
+
+    flash->spi.wr = sfud_sim_spi_write_read;
+    flash->spi.lock = NULL;
+    flash->spi.unlock = NULL;
+    flash->spi.user_data = sim;
+}
+
+/**
+ * Delay on the simulated clock. It's used as the flash device's retry delay function.
+ *
+ * @param ns delay time (nanoseconds)
+ */
+void sfud_sim_delay(uint64_t ns) {
+    sim_time += ns;
+}
+
+/**
+ * Get the simulated time.
+ *
+ * @return simulated time (nanoseconds)
+ */
+uint64_t sfud_sim_get_time(void) {
+    return sim_time;
+}
+
+/**
+ * Set the power cut budget. The power is cut on the budget programmed byte or erased 4K sector, then the hook is called
+ * with the torn data on the array.
+ *
+ * @param sim simulated device
+ * @param budget programmed bytes and erased sectors until the power is cut, 0: never
+ * @param cut power cut hook, it must not return (e.g. save the array and exit)
+ */
+void sfud_sim_set_power_cut(sfud_sim *sim, uint64_t budget, void (*cut)(sfud_sim *sim)) {
+    SFUD_ASSERT(sim);
+    SFUD_ASSERT(!budget || cut);
+
+    sim->power.budget = budget;
+    sim->power.used = 0;
+    sim->power.cut = cut;
+}
+
+/**
+ * Clear the operation statistics.
+ *
+ * @param sim simulated device
+ */
+void sfud_sim_clear_stats(sfud_sim *sim) {
+    SFUD_ASSERT(sim);
+
+    memset(&sim->stats, 0, sizeof(sfud_sim_stats));
+}
+
+/**
+ * Print the operation statistics.
+ *
+ * @param sim simulated device
+ */
+void sfud_sim_print_stats(const sfud_sim *sim) {
+    const sfud_sim_stats *stats;
+    uint32_t i, min_erase = UINT32_MAX, max_erase = 0;
+
+    SFUD_ASSERT(sim);
+
+    stats = &sim->stats;
+    for (i = 0; i < sim->cfg.capacity / SFUD_SIM_SECTOR_SIZE; i++) {
+        if (sim->erase_count[i] < min_erase) {
+            min_erase = sim->erase_count[i];
+        }
+        if (sim->erase_count[i] > max_erase) {
+            max_erase = sim->erase_count[i];
+        }
+    }
+    SFUD_INFO("bus: %lu transactions, %llu bytes, %llu us", (unsigned long) stats->transactions,
+            (unsigned long long) stats->bus_bytes, (unsigned long long) stats->bus_ns / 1000);
+    SFUD_INFO("array busy: %llu us", (unsigned long long) stats->busy_ns / 1000);
+    SFUD_INFO("read: %lu commands, %llu bytes", (unsigned long) stats->read_cmds,
+            (unsigned long long) stats->read_bytes);
+    SFUD_INFO("program: %lu commands, %llu bytes", (unsigned long) stats->program_cmds,
+            (unsigned long long) stats->program_bytes);
+    SFUD_INFO("erase: 4K %lu, 32K %lu, 64K %lu, chip %lu", (unsigned long) stats->erase_4k,
+            (unsigned long) stats->erase_32k, (unsigned long) stats->erase_64k, (unsigned long) stats->erase_chip);
+    SFUD_INFO("status: %lu reads, %lu writes, WREN %lu, WRDI %lu", (unsigned long) stats->status_reads,
+            (unsigned long) stats->status_writes, (unsigned long) stats->write_enables,
+            (unsigned long) stats->write_disables);
+    SFUD_INFO("suspend %lu, resume %lu, reset %lu, ID %lu, SFDP %lu", (unsigned long) stats->suspends,
+            (unsigned long) stats->resumes, (unsigned long) stats->resets, (unsigned long) stats->id_reads,
+            (unsigned long) stats->sfdp_reads);
+    SFUD_INFO("address mode switches %lu, ignored %lu, unknown %lu", (unsigned long) stats->addr_mode_switches,
+            (unsigned long) stats->ignored_cmds, (unsigned long) stats->unknown_cmds);
+    SFUD_INFO("sector erase count: min %lu, max %lu", (unsigned long) min_erase, (unsigned long) max_erase);
+}
+
+/**
+ * SPI write data then read data. The first written byte is the command.
+ */
+sfud_err sfud_sim_spi_write_read(const sfud_spi *spi, const uint8_t *write_buf, size_t write_size, uint8_t *read_buf,
+        size_t read_size) {
+    sfud_sim *sim = (sfud_sim *) spi->user_data;
+    const sfud_sim_timing *timing;
+    /* the data phase clocks of every byte */
+    size_t data_clocks = 8;
+    uint32_t addr;
+    uint8_t cmd, addr_len;
+
+    SFUD_ASSERT(sim);
+    if (write_size) {
+        SFUD_ASSERT(write_buf);
+    }
+    if (read_size) {
+        SFUD_ASSERT(read_buf);
+        memset(read_buf, 0xFF, read_size);
+    }
+
+    timing = &sim->cfg.timing;
+    update_busy(sim);
+    sim->stats.transactions++;
+    sim->stats.bus_bytes += write_size + read_size;
+
+    if (write_size == 0) {
+        goto __exit;
+    }
+
+    cmd = write_buf[0];
+    if (cmd != SFUD_CMD_ENABLE_RESET) {
+        /* the reset enable will be cancelled by any other command */
+        if (cmd != SFUD_CMD_RESET) {
+            sim->reset_enabled = false;
+        }
+    }
+    if (is_busy(sim) && cmd != SFUD_CMD_READ_STATUS_REGISTER && cmd != SIM_CMD_READ_STATUS_REGISTER2
+            && cmd != SIM_CMD_SUSPEND && cmd != SFUD_CMD_ENABLE_RESET && cmd != SFUD_CMD_RESET) {
+        sim->stats.ignored_cmds++;
+        goto __exit;
+    }
+
+    /* the 4-Byte address commands always have 4 address bytes, the others follow the addressing mode */
+    switch (cmd) {
+    case SFUD_CMD_4B_READ_DATA:
+    case SFUD_CMD_4B_FAST_READ_DATA:
+    case SFUD_CMD_4B_PAGE_PROGRAM:
+    case SIM_CMD_4B_ERASE_4K:
+    case SIM_CMD_4B_ERASE_32K:
+    case SIM_CMD_4B_ERASE_64K:
+        addr_len = 4;
+        break;
+    default:
+        addr_len = sim->addr_4_byte ? 4 : 3;
+        break;
+    }
+
+    switch (cmd) {
+    case SFUD_CMD_JEDEC_ID:
+        sim->stats.id_reads++;
+        if (read_size > 0) read_buf[0] = sim->cfg.mf_id;
+        if (read_size > 1) read_buf[1] = sim->cfg.type_id;
+        if (read_size > 2) read_buf[2] = sim->cfg.capacity_id;
+        break;
+
+    case SFUD_CMD_MANUFACTURER_DEVICE_ID:
+        sim->stats.id_reads++;
+        if (read_size > 0) read_buf[0] = sim->cfg.mf_id;
+        if (read_size > 1) read_buf[1] = sim->cfg.capacity_id - 1;
+        break;
+
+    case SFUD_CMD_READ_UNIQUE_ID:
+        sim->stats.id_reads++;
+        for (addr = 0; addr < read_size && addr < 8; addr++) {
+            read_buf[addr] = (uint8_t) (0xA0 + addr);
+        }
+        break;
+
+    case SFUD_CMD_READ_SFDP_REGISTER:
+        /* command + 3 address bytes + dummy byte */
+        if (!sim->cfg.sfdp || write_size < 5) {
+            sim->stats.unknown_cmds++;
+            break;
+        }
+        sim->stats.sfdp_reads++;
+        for (addr = get_addr(write_buf + 1, 3); read_size; read_size--, read_buf++, addr++) {
+            *read_buf = sim->sfdp[addr % SFUD_SIM_SFDP_SIZE];
+        }
+        break;
+
+    case SFUD_CMD_READ_STATUS_REGISTER:
+        sim->stats.status_reads++;
+        if (read_size) {
+            read_buf[0] = sim->sr1;
+        }
+        break;
+
+    case SIM_CMD_READ_STATUS_REGISTER2:
+        sim->stats.status_reads++;
+        if (read_size) {
+            read_buf[0] = sim->sr2;
+        }
+        break;
+
+    case SFUD_CMD_WRITE_ENABLE:
+        sim->stats.write_enables++;
+        sim->sr1 |= SFUD_STATUS_REGISTER_WEL;
+        break;
+
+    case SFUD_CMD_WRITE_DISABLE:
+        sim->stats.write_disables++;
+        sim->sr1 &= ~SFUD_STATUS_REGISTER_WEL;
+        break;
+
+    case SFUD_VOLATILE_SR_WRITE_ENABLE:
+        sim->volatile_sr_we = true;
+        break;
+
+    case SFUD_CMD_WRITE_STATUS_REGISTER:
+        sim->stats.status_writes++;
+        if (write_size < 2) {
+            break;
+        }
+        if (sim->volatile_sr_we) {
+            /* volatile write, it doesn't need the write enable latch and has no busy time */
+            sim->sr1 = (sim->sr1 & 0x03) | (write_buf[1] & 0xFC);
+            if (write_size > 2) {
+                sim->sr2 = (sim->sr2 & SFUD_SIM_SR2_SUS) | (write_buf[2] & ~SFUD_SIM_SR2_SUS);
+            }
+            sim->volatile_sr_we = false;
+        } else if (sim->sr1 & SFUD_STATUS_REGISTER_WEL) {
+            sim->sr1 = (sim->sr1 & 0x03) | (write_buf[1] & 0xFC);
+            if (write_size > 2) {
+                sim->sr2 = (sim->sr2 & SFUD_SIM_SR2_SUS) | (write_buf[2] & ~SFUD_SIM_SR2_SUS);
+            }
+            start_busy(sim, SFUD_SIM_OP_WRITE_STATUS, timing->write_status_ns);
+        } else {
+            sim->stats.ignored_cmds++;
+        }
+        break;
+
+    case SFUD_CMD_READ_DATA:
+    case SIM_CMD_FAST_READ_DATA:
+    case SFUD_CMD_DUAL_OUTPUT_READ_DATA:
+    case SFUD_CMD_4B_READ_DATA:
+    case SFUD_CMD_4B_FAST_READ_DATA:
+        /* fast read and dual output read need 8 dummy clocks after the address */
+        if (write_size < (size_t) 1 + addr_len + (cmd == SFUD_CMD_READ_DATA || cmd == SFUD_CMD_4B_READ_DATA ? 0 : 1)) {
+            sim->stats.unknown_cmds++;
+            break;
+        }
+        if (cmd == SFUD_CMD_DUAL_OUTPUT_READ_DATA) {
+            data_clocks = 4;
+        }
+        sim->stats.read_cmds++;
+        sim->stats.read_bytes += read_size;
+        read_array(sim, get_addr(write_buf + 1, addr_len), read_buf, read_size);
+        break;
+
+    case SFUD_CMD_PAGE_PROGRAM:
+    case SFUD_CMD_4B_PAGE_PROGRAM:
+        if (write_size < (size_t) 2 + addr_len) {
+            sim->stats.unknown_cmds++;
+            break;
+        }
+        if (!(sim->sr1 & SFUD_STATUS_REGISTER_WEL) || (sim->suspended.op == SFUD_SIM_OP_PROGRAM)) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        sim->stats.program_cmds++;
+        sim->stats.program_bytes += write_size - 1 - addr_len;
+        program_page(sim, get_addr(write_buf + 1, addr_len), write_buf + 1 + addr_len, write_size - 1 - addr_len);
+        start_busy(sim, SFUD_SIM_OP_PROGRAM,
+                timing->program_base_ns + (uint64_t) timing->program_byte_ns * (write_size - 1 - addr_len));
+        break;
+
+    case SIM_CMD_ERASE_4K:
+    case SIM_CMD_ERASE_32K:
+    case SIM_CMD_ERASE_64K:
+    case SIM_CMD_4B_ERASE_4K:
+    case SIM_CMD_4B_ERASE_32K:
+    case SIM_CMD_4B_ERASE_64K:
+        if (write_size < (size_t) 1 + addr_len) {
+            sim->stats.unknown_cmds++;
+            break;
+        }
+        /* erase can't be issued when an operation has been suspended */
+        if (!(sim->sr1 & SFUD_STATUS_REGISTER_WEL) || sim->suspended.op != SFUD_SIM_OP_NONE) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        addr = get_addr(write_buf + 1, addr_len);
+        if (cmd == SIM_CMD_ERASE_4K || cmd == SIM_CMD_4B_ERASE_4K) {
+            sim->stats.erase_4k++;
+            erase_array(sim, addr, 4L * 1024L, timing->erase_4k_ns);
+        } else if (cmd == SIM_CMD_ERASE_32K || cmd == SIM_CMD_4B_ERASE_32K) {
+            sim->stats.erase_32k++;
+            erase_array(sim, addr, 32L * 1024L, timing->erase_32k_ns);
+        } else {
+            sim->stats.erase_64k++;
+            erase_array(sim, addr, 64L * 1024L, timing->erase_64k_ns);
+        }
+        break;
+
+    case SFUD_CMD_ERASE_CHIP:
+    case SIM_CMD_ERASE_CHIP2:
+        if (!(sim->sr1 & SFUD_STATUS_REGISTER_WEL) || sim->suspended.op != SFUD_SIM_OP_NONE) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        sim->stats.erase_chip++;
+        erase_array(sim, 0, sim->cfg.capacity, timing->erase_chip_ns);
+        break;
+
+    case SFUD_CMD_ENTER_4B_ADDRESS_MODE:
+    case SFUD_CMD_EXIT_4B_ADDRESS_MODE:
+        if (sim->cfg.capacity <= (1L << 24)) {
+            sim->stats.unknown_cmds++;
+            break;
+        }
+        sim->stats.addr_mode_switches++;
+        sim->addr_4_byte = (cmd == SFUD_CMD_ENTER_4B_ADDRESS_MODE);
+        break;
+
+    case SIM_CMD_SUSPEND:
+        /* only program and erase can be suspended */
+        if (!is_busy(sim) || (sim->busy_op != SFUD_SIM_OP_PROGRAM && sim->busy_op != SFUD_SIM_OP_ERASE)) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        sim->stats.suspends++;
+        sim->suspended.op = sim->busy_op;
+        sim->suspended.remain = sim->busy_until - sim_time;
+        /* the suspend latency is simulated as a short busy time */
+        sim->busy_op = SFUD_SIM_OP_NONE;
+        sim->busy_until = sim_time + timing->suspend_ns;
+        sim->sr1 |= SFUD_STATUS_REGISTER_BUSY;
+        sim->sr2 |= SFUD_SIM_SR2_SUS;
+        break;
+
+    case SIM_CMD_RESUME:
+        if (sim->suspended.op == SFUD_SIM_OP_NONE) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        sim->stats.resumes++;
+        sim->sr2 &= ~SFUD_SIM_SR2_SUS;
+        start_busy(sim, sim->suspended.op, sim->suspended.remain + timing->resume_ns);
+        sim->suspended.op = SFUD_SIM_OP_NONE;
+        break;
+
+    case SFUD_CMD_ENABLE_RESET:
+        sim->reset_enabled = true;
+        /* SFUD sends the enable reset and reset command on one transaction */
+        if (write_size < 2 || write_buf[1] != SFUD_CMD_RESET) {
+            break;
+        }
+        /* fall through */
+    case SFUD_CMD_RESET:
+        if (!sim->reset_enabled) {
+            sim->stats.ignored_cmds++;
+            break;
+        }
+        sim->stats.resets++;
+        sim->reset_enabled = false;
+        sim->volatile_sr_we = false;
+        sim->addr_4_byte = false;
+        /* the running operation is aborted, but its data has been already changed */
+        sim->busy_op = SFUD_SIM_OP_NONE;
+        sim->busy_until = sim_time;
+        sim->suspended.op = SFUD_SIM_OP_NONE;
+        sim->sr1 &= ~(SFUD_STATUS_REGISTER_BUSY | SFUD_STATUS_REGISTER_WEL);
+        sim->sr2 &= ~SFUD_SIM_SR2_SUS;
+        break;
+
+    default:
+        sim->stats.unknown_cmds++;
+        break;
+    }
+
+__exit:
+    /* the bus time: command and address phase is always single line */
+    {
+        uint64_t bus_ns = timing->cs_ns + ((uint64_t) write_size * 8 + (uint64_t) read_size * data_clocks)
+                * timing->sck_ns;
+        sim_time += bus_ns;
+        sim->stats.bus_ns += bus_ns;
+    }
+
+    return SFUD_SUCCESS;
+}
+
+/**
+ * build the SFDP area by the configuration, it's the JESD216 (V1.0) header and basic flash parameter table.
+ * The device which is larger than 16MB has the JESD216B (V1.6) 4-Byte address instruction table.
+ */
+static void build_sfdp(sfud_sim *sim) {
+    uint8_t *header = sim->sfdp, *table = sim->sfdp + SIM_SFDP_BASIC_TABLE_ADDR;
+    uint32_t density = sim->cfg.capacity * 8 - 1;
+
+    memset(sim->sfdp, 0xFF, sizeof(sim->sfdp));
+    /* SFDP header: signature, V1.0, one parameter header */
+    header[0] = 'S';
+    header[1] = 'F';
+    header[2] = 'D';
+    header[3] = 'P';
+    header[4] = 0x00;
+    header[5] = 0x01;
+    header[6] = 0x00;
+    header[7] = 0xFF;
+    /* JEDEC basic flash parameter header: V1.0, 9 DWORDs */
+    header[8] = 0x00;
+    header[9] = 0x00;
+    header[10] = 0x01;
+    header[11] = 0x09;
+    header[12] = SIM_SFDP_BASIC_TABLE_ADDR;
+    header[13] = 0x00;
+    header[14] = 0x00;
+    header[15] = 0xFF;
+    /* 1st DWORD: uniform 4K erase, write granularity 64 bytes or larger, non-volatile status register */
+    table[0] = 0xE5;
+    table[1] = SIM_CMD_ERASE_4K;
+    /* 3-byte only addressing, 1-1-2 fast read */
+    table[2] = 0xF1;
+    table[3] = 0xFF;
+    /* 2nd DWORD: flash memory density (bits - 1) */
+    table[4] = (uint8_t) (density >> 0);
+    table[5] = (uint8_t) (density >> 8);
+    table[6] = (uint8_t) (density >> 16);
+    table[7] = (uint8_t) (density >> 24);
+    /* 3rd to 7th DWORDs: fast read parameters, 1-1-2 read is 0x3B with 8 dummy clocks */
+    memset(table + 8, 0x00, 20);
+    table[14] = 0x08;
+    table[15] = SFUD_CMD_DUAL_OUTPUT_READ_DATA;
+    /* 8th and 9th DWORDs: erase types, 4K/0x20, 32K/0x52, 64K/0xD8 */
+    table[28] = 12;
+    table[29] = SIM_CMD_ERASE_4K;
+    table[30] = 15;
+    table[31] = SIM_CMD_ERASE_32K;
+    table[32] = 16;
+    table[33] = SIM_CMD_ERASE_64K;
+    table[34] = 0x00;
+    table[35] = 0xFF;
+
+    if (sim->cfg.capacity > (1L << 24)) {
+        /* 3- or 4-Byte addressing */
+        table[2] = 0xF3;
+        if (sim->cfg.addr_4b_table) {
+            /* V1.6, two parameter headers */
+            header[4] = 0x06;
+            header[6] = 0x01;
+            /* 4-Byte address instruction parameter header: ID 0xFF84, V1.0, 2 DWORDs */
+            header[16] = 0x84;
+            header[17] = 0x00;
+            header[18] = 0x01;
+            header[19] = 0x02;
+            header[20] = SIM_SFDP_4B_TABLE_ADDR;
+            header[21] = 0x00;
+            header[22] = 0x00;
+            header[23] = 0xFF;
+            table = sim->sfdp + SIM_SFDP_4B_TABLE_ADDR;
+            /* 1st DWORD: 13h read, 0Ch fast read, 12h page program, erase type 1 to 3 */
+            table[0] = 0x43;
+            table[1] = 0x0E;
+            table[2] = 0x00;
+            table[3] = 0x00;
+            /* 2nd DWORD: erase type 1 to 4 commands */
+            table[4] = SIM_CMD_4B_ERASE_4K;
+            table[5] = SIM_CMD_4B_ERASE_32K;
+            table[6] = SIM_CMD_4B_ERASE_64K;
+            table[7] = 0xFF;
+        }
+    }
+}
+
+/**
+ * finish the running operation when its busy time is over
+ */
+static void update_busy(sfud_sim *sim) {
+    if ((sim->sr1 & SFUD_STATUS_REGISTER_BUSY) && sim_time >= sim->busy_until) {
+        /* the write enable latch is only cleared by a finished write operation, not by the suspend latency */
+        if (sim->busy_op != SFUD_SIM_OP_NONE) {
+            sim->sr1 &= ~SFUD_STATUS_REGISTER_WEL;
+        }
+        sim->sr1 &= ~SFUD_STATUS_REGISTER_BUSY;
+        sim->busy_op = SFUD_SIM_OP_NONE;
+    }
+}
+
+static bool is_busy(const sfud_sim *sim) {
+    return (sim->sr1 & SFUD_STATUS_REGISTER_BUSY) ? true : false;
+}
+
+/**
+ * start the write operation after the chip select is deasserted
+ */
+static void start_busy(sfud_sim *sim, uint8_t op, uint64_t ns) {
+    sim->busy_op = op;
+    sim->busy_until = sim_time + ns;
+    sim->sr1 |= SFUD_STATUS_REGISTER_BUSY;
+    sim->stats.busy_ns += ns;
+}
+
+static uint32_t get_addr(const uint8_t *buf, uint8_t len) {
+    uint32_t addr = 0;
+    uint8_t i;
+
+    for (i = 0; i < len; i++) {
+        addr = (addr << 8) | buf[i];
+    }
+
+    return addr;
+}
+
+/**
+ * read data, the address will be wrapped when it reaches the end of memory array
+ */
+static void read_array(sfud_sim *sim, uint32_t addr, uint8_t *read_buf, size_t read_size) {
+    size_t i;
+
+    for (i = 0; i < read_size; i++) {
+        read_buf[i] = sim->array[(addr + i) % sim->cfg.capacity];
+    }
+}
+
+/**
+ * program data in one page, the address will be wrapped at the page boundary
+ */
+static void program_page(sfud_sim *sim, uint32_t addr, const uint8_t *data, size_t size) {
+    uint32_t page_addr, offset;
+    size_t i;
+
+    addr %= sim->cfg.capacity;
+    page_addr = addr - addr % SFUD_SIM_PAGE_SIZE;
+    offset = addr % SFUD_SIM_PAGE_SIZE;
+    /* only the last page size bytes will be programmed when the data is larger than page */
+    if (size > SFUD_SIM_PAGE_SIZE) {
+        offset = (offset + size - SFUD_SIM_PAGE_SIZE) % SFUD_SIM_PAGE_SIZE;
+        data += size - SFUD_SIM_PAGE_SIZE;
+        size = SFUD_SIM_PAGE_SIZE;
+    }
+    for (i = 0; i < size; i++) {
+        if (power_is_cut(sim)) {
+            /* the torn byte has half of its bits programmed */
+            sim->array[page_addr + (offset + i) % SFUD_SIM_PAGE_SIZE] &= data[i] | 0x55;
+            sim->power.cut(sim);
+            SFUD_ASSERT(0);
+        }
+        /* NOR flash program can only change bit from 1 to 0 */
+        sim->array[page_addr + (offset + i) % SFUD_SIM_PAGE_SIZE] &= data[i];
+    }
+}
+
+/**
+ * erase the aligned area
+ */
+static void erase_array(sfud_sim *sim, uint32_t addr, uint32_t size, uint64_t ns) {
+    uint32_t i;
+
+    addr %= sim->cfg.capacity;
+    addr -= addr % size;
+    for (i = addr / SFUD_SIM_SECTOR_SIZE; i < (addr + size) / SFUD_SIM_SECTOR_SIZE; i++) {
+        if (power_is_cut(sim)) {
+            /* the torn sector has half of it erased */
+            memset(sim->array + i * SFUD_SIM_SECTOR_SIZE, 0xFF, SFUD_SIM_SECTOR_SIZE / 2);
+            sim->power.cut(sim);
+            SFUD_ASSERT(0);
+        }
+        memset(sim->array + i * SFUD_SIM_SECTOR_SIZE, 0xFF, SFUD_SIM_SECTOR_SIZE);
+        sim->erase_count[i]++;
+    }
+    start_busy(sim, SFUD_SIM_OP_ERASE, ns);
+}
+
+/**
+ * use one unit of the power cut budget, the used units are counted without the budget too
+ *
+ * @return true: the power is cut on this unit
+ */
+static bool power_is_cut(sfud_sim *sim) {
+    return ++sim->power.used == sim->power.budget;
+}
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the Serial Flash Universal Driver Library.
+ *
+ * Function: Portable interface for the host side simulator. It's used instead of sfud_port.c
+ *           when the library is built on Linux, e.g.
+ *           gcc -Isrc/SUFD/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c
+ *               src/SUFD/src/sfud_sim_port.c app.c
+ * Created on: 2026-10-19
+ */
+
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* the simulated devices, every SPI device name has one simulated flash chip */
+static struct {
+    const char *spi_name;
+    bool init_ok;
+    sfud_sim sim;
+} sim_table[] = {
+    { .spi_name = "SPI2" },
+    { .spi_name = "SPI2_CS1" },
+};
+
+static char log_buf[256];
+
+#ifdef SFUD_USING_PARAM_CACHE
+/* the flash parameter cache, it's kept while the host process is running */
+static uint8_t param_cache[256];
+#endif
+
+void sfud_log_debug(const char *file, const long line, const char *format, ...);
+
+/* about 100 microsecond delay */
+static void retry_delay_100us(void) {
+    sfud_sim_delay(100 * 1000);
+}
+
+/**
+ * Get the simulated device by the SPI device name. It will be initialized by the default configuration
+ * on the first time.
+ *
+ * @param spi_name SPI device name
+ *
+ * @return simulated device, NULL: not found
+ */
+sfud_sim *sfud_sim_port_get_device(const char *spi_name) {
+    size_t i;
+    sfud_sim_config cfg;
+
+    for (i = 0; i < sizeof(sim_table) / sizeof(sim_table[0]); i++) {
+        if (!strcmp(sim_table[i].spi_name, spi_name)) {
+            if (!sim_table[i].init_ok) {
+                sfud_sim_default_config(&cfg);
+                if (sfud_sim_init(&sim_table[i].sim, &cfg) != SFUD_SUCCESS) {
+                    return NULL;
+                }
+                sim_table[i].init_ok = true;
+            }
+            return &sim_table[i].sim;
+        }
+    }
+
+    return NULL;
+}
+
+sfud_err sfud_spi_port_init(sfud_flash *flash) {
+    sfud_err result = SFUD_SUCCESS;
+    sfud_sim *sim = sfud_sim_port_get_device(flash->spi.name);
+
+    if (sim) {
+        sfud_sim_attach(sim, flash);
+        /* about 100 microsecond delay */
+        flash->retry.delay = retry_delay_100us;
+        /* adout 60 seconds timeout */
+        flash->retry.times = 60 * 10000;
+    } else {
+        result = SFUD_ERR_NOT_FOUND;
+    }
+
+    return result;
+}
+
+#ifdef SFUD_USING_PARAM_CACHE
+sfud_err sfud_port_read_param_cache(const sfud_flash *flash, uint8_t *buf, size_t size) {
+    SFUD_ASSERT(size <= sizeof(param_cache));
+
+    memcpy(buf, param_cache, size);
+
+    return SFUD_SUCCESS;
+}
+
+sfud_err sfud_port_write_param_cache(const sfud_flash *flash, const uint8_t *buf, size_t size) {
+    SFUD_ASSERT(size <= sizeof(param_cache));
+
+    memcpy(param_cache, buf, size);
+
+    return SFUD_SUCCESS;
+}
+#endif /* SFUD_USING_PARAM_CACHE */
+
+/**
+ * This function is print debug info.
+ *
+ * @param file the file which has call this function
+ * @param line the line number which has call this function
+ * @param format output format
+ * @param ... args
+ */
+void sfud_log_debug(const char *file, const long line, const char *format, ...) {
+    va_list args;
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    printf("[SFUD](%s:%ld) ", file, line);
+    /* must use vprintf to print */
+    vsnprintf(log_buf, sizeof(log_buf), format, args);
+    printf("%s\n", log_buf);
+    va_end(args);
+}
+
+/**
+ * This function is print routine info.
+ *
+ * @param format output format
+ * @param ... args
+ */
+void sfud_log_info(const char *format, ...) {
+    va_list args;
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    printf("[SFUD]");
+    /* must use vprintf to print */
+    vsnprintf(log_buf, sizeof(log_buf), format, args);
+    printf("%s\n", log_buf);
+    va_end(args);
+}
+
+sfud_flash sfud_norflash0 = {
+        .name = "norflash0",
+        .spi.name = "SPI2",
+        .chip = { "W25Q64FV", SFUD_MF_ID_WINBOND, 0x40, 0x17, 8L * 1024L * 1024L, SFUD_WM_PAGE_256B, 4096, 0x20 } };
+
+#ifdef SFUD_USING_NOR_FLASH1
+sfud_flash sfud_norflash1 = {
+        .name = "norflash1",
+        .spi.name = "SPI2_CS1",
+        .chip = { "W25Q64FV", SFUD_MF_ID_WINBOND, 0x40, 0x17, 8L * 1024L * 1024L, SFUD_WM_PAGE_256B, 4096, 0x20 } };
+#endif
+
+int spi_flash_init(void)
+{
+    /* SFUD initialize */
+    if (sfud_device_init(&sfud_norflash0) != SFUD_SUCCESS) {
+        return -1;
+    }
+#ifdef SFUD_USING_NOR_FLASH1
+    if (sfud_device_init(&sfud_norflash1) != SFUD_SUCCESS) {
+        return -1;
+    }
+#endif
+
+    return 0;
+}
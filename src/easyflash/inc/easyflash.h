@@ -48,11 +48,26 @@ EfErrCode easyflash_init(void);
 size_t ef_get_env_blob(const char *key, void *value_buf, size_t buf_len, size_t *saved_value_len);
 bool ef_get_env_obj(const char *key, env_node_obj_t env);
 size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len);
+size_t ef_read_env_value_at(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len);
+size_t ef_read_iterated_env_value(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len);
+bool ef_get_env_value_addr(const char *key, uint32_t *addr, size_t *value_len);
+size_t ef_env_iterate(const char *prefix, bool (*callback)(env_node_obj_t env, void *arg), void *arg);
 EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len);
+bool ef_get_env_u32(const char *key, uint32_t *value);
+bool ef_get_env_i32(const char *key, int32_t *value);
+bool ef_get_env_u64(const char *key, uint64_t *value);
+bool ef_get_env_bool(const char *key, bool *value);
+EfErrCode ef_set_env_u32(const char *key, uint32_t value);
+EfErrCode ef_set_env_i32(const char *key, int32_t value);
+EfErrCode ef_set_env_u64(const char *key, uint64_t value);
+EfErrCode ef_set_env_bool(const char *key, bool value);
 
 /* ef_env.c, ef_env_legacy_wl.c and ef_env_legacy.c */
 EfErrCode ef_load_env(void);
 void ef_print_env(void);
+void ef_print_env_wear(void);
+void ef_print_env_gc(void);
+void ef_env_set_gc_policy(EfGcPolicy policy);
 char *ef_get_env(const char *key);
 EfErrCode ef_set_env(const char *key, const char *value);
 EfErrCode ef_del_env(const char *key);
@@ -61,6 +76,21 @@ EfErrCode ef_env_set_default(void);
 size_t ef_get_env_write_bytes(void);
 EfErrCode ef_set_and_save_env(const char *key, const char *value);
 EfErrCode ef_del_and_save_env(const char *key);
+bool ef_env_gc_step(size_t env_num, uint32_t time_us);
+EfErrCode ef_env_checkpoint(void);
+EfErrCode ef_txn_begin(void);
+EfErrCode ef_txn_set(const char *key, const void *value_buf, size_t buf_len);
+EfErrCode ef_txn_commit(void);
+void ef_txn_abort(void);
+#endif
+
+#ifdef EF_USING_LOG
+/* ef_log.c */
+EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size);
+EfErrCode ef_log_write(const uint32_t *log, size_t size);
+EfErrCode ef_log_flush(void);
+EfErrCode ef_log_clean(void);
+size_t ef_log_get_used_size(void);
 #endif
 
 /* ef_utils.c */
@@ -70,8 +100,10 @@ uint32_t ef_calc_crc32(uint32_t crc, const void *buf, size_t size);
 EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size);
 EfErrCode ef_port_erase(uint32_t addr, size_t size);
 EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size);
+EfErrCode ef_port_write_status(uint32_t addr, const uint32_t *buf, size_t size);
 void ef_port_env_lock(void);
 void ef_port_env_unlock(void);
+uint32_t ef_port_get_us(void);
 void ef_log_debug(const char *file, const long line, const char *format, ...);
 void ef_log_info(const char *format, ...);
 void ef_print(const char *format, ...);
@@ -81,8 +81,22 @@
 #define EF_START_ADDR                  (0) /* from the chip position: 64KB */
 /* ENV area size. It's at least one empty sector for GC. So it's definination must more then or equal 2 flash sector size. */
 #define ENV_AREA_SIZE                  (2 * EF_ERASE_MIN_SIZE)      /* 8K */
-/* saved log area size */
-/* #define LOG_AREA_SIZE             (10 * EF_ERASE_MIN_SIZE)*/      /* 20K */
+/* saved log area size, it's used when EF_USING_LOG is defined. The following areas are behind it on this case. */
+/* #define LOG_AREA_SIZE                  (16 * EF_ERASE_MIN_SIZE) */     /* 64K */
+/* ENV checkpoint sector address. The sector state is saved on it by ef_env_checkpoint() when the ENV is idle, the ENV
+ * loading trusts it and skips the CRC check of every ENV. It's one sector (EF_ERASE_MIN_SIZE) out of the ENV area. */
+// #define EF_ENV_CHECKPOINT_ADDR         (EF_START_ADDR + ENV_AREA_SIZE)
+/* default ENV image start address. The image (ENV_AREA_SIZE and the 8 bytes CRC32 trailer) is built by tools/ef_image
+ * and programmed by the factory, ENV set default copies it instead of creating the default ENV one by one. */
+// #define EF_ENV_DEFAULT_IMAGE_ADDR      (EF_START_ADDR + ENV_AREA_SIZE + EF_ERASE_MIN_SIZE)
+
+/* the ENV hash index table size, it must be power of 2, 8 bytes for every node. It's enough for 3/4 table size ENV,
+ * the more ENV are found by traversal. 0: the index is not used. Default: 64 */
+// #define EF_ENV_INDEX_TABLE_SIZE        64
+
+/* the CRC32 slice number for ENV and image check, 1: byte-wise (1K table), 4: slice-by-4 (4K tables),
+ * 8: slice-by-8 (8K tables) */
+#define EF_CRC32_SLICE_NUM             4
 
 /* print debug information of flash */
 #define PRINT_DEBUG
@@ -72,6 +72,13 @@ typedef struct _ef_env {
     size_t value_len;
 } ef_env, *ef_env_t;
 
+/* the default ENV image trailer, it's behind the ENV area image (ENV_AREA_SIZE) which is built by tools/ef_image */
+#define EF_ENV_IMAGE_MAGIC_WORD                  0x30494645
+struct ef_env_image_trailer {
+    uint32_t magic;                              /**< magic word(`E`, `F`, `I`, `0`) */
+    uint32_t crc32;                              /**< CRC32 of the ENV area image */
+};
+
 /* EasyFlash error code */
 typedef enum {
     EF_NO_ERR,
@@ -91,6 +98,12 @@ typedef enum {
     EF_SECTOR_FULL,
 } EfSecrorStatus;
 
+/* the GC victim sector selection policy */
+typedef enum {
+    EF_GC_POLICY_GREEDY,                         /**< the most reclaimed space first */
+    EF_GC_POLICY_AGE_WEIGHTED,                   /**< the best cost-benefit ratio (1 - u) * age / (1 + u) first */
+} EfGcPolicy;
+
 enum env_status {
     ENV_UNUSED,
     ENV_PRE_WRITE,
@@ -66,6 +66,7 @@ EfErrCode easyflash_init(void)
 {
     extern EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size);
     extern EfErrCode ef_env_init(ef_env const *default_env, size_t default_env_size);
+    extern EfErrCode ef_log_init(void);
 
     size_t default_env_set_size = 0;
     const ef_env *default_env_set;
@@ -86,6 +87,13 @@ EfErrCode easyflash_init(void)
     }
 #endif
 
+#ifdef EF_USING_LOG
+    if (result == EF_NO_ERR)
+    {
+        result = ef_log_init();
+    }
+#endif
+
     if (result == EF_NO_ERR)
     {
         init_ok = true;
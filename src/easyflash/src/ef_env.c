@@ -43,6 +43,8 @@
 #define SECTOR_MAGIC_WORD                        0x30344645
 /* magic word(`K`, `V`, `4`, `0`) */
 #define ENV_MAGIC_WORD                           0x3034564B
+/* magic word(`E`, `F`, `C`, `P`) */
+#define CHECKPOINT_MAGIC_WORD                    0x50434645
 
 /* the using status sector table length */
 #ifndef USING_SECTOR_TABLE_LEN
@@ -64,6 +66,22 @@
 #define EF_GC_EMPTY_SEC_THRESHOLD                1
 #endif
 
+/* the GC collects the dirty sectors until the empty sector number reaches this target */
+#ifndef EF_GC_EMPTY_SEC_TARGET
+#define EF_GC_EMPTY_SEC_TARGET                   (EF_GC_EMPTY_SEC_THRESHOLD + 1)
+#endif
+
+/* the default GC victim sector selection policy, @see EfGcPolicy */
+#ifndef EF_GC_POLICY
+#define EF_GC_POLICY                             EF_GC_POLICY_AGE_WEIGHTED
+#endif
+
+/* the erase cost of one sector for the age-weighted GC policy, it's the copied ENV size on the same time. The sector
+ * size makes the score the cost-benefit ratio (1 - u) * age / (1 + u), u is the live ENV ratio of the sector */
+#ifndef EF_GC_ERASE_COST
+#define EF_GC_ERASE_COST                         EF_ERASE_MIN_SIZE
+#endif
+
 /* the ENV cache table size, it will improve ENV search speed when using cache */
 #ifndef EF_ENV_CACHE_TABLE_SIZE
 #define EF_ENV_CACHE_TABLE_SIZE                  16
@@ -74,6 +92,61 @@
 #define EF_SECTOR_CACHE_TABLE_SIZE               4
 #endif
 
+/* the ENV hash index table size, it must be power of 2. Every ENV uses one node (8 bytes), the ENV which is more
+ * than 3/4 table size is not added, it's found by traversal until next loading. 0: the index is not used */
+#ifndef EF_ENV_INDEX_TABLE_SIZE
+#define EF_ENV_INDEX_TABLE_SIZE                  64
+#endif
+
+#if EF_ENV_INDEX_TABLE_SIZE > 0
+#if (EF_ENV_INDEX_TABLE_SIZE & (EF_ENV_INDEX_TABLE_SIZE - 1)) != 0
+#error "The ENV index table size must be power of 2"
+#endif
+#define EF_ENV_USING_INDEX
+#endif
+
+/* the ENV name Bloom filter size (bits), it must be power of 2 and not less than 8. The lookup of the absent ENV is
+ * rejected without reading flash. 3 bits for every ENV, the false positive rate is about 5% for 300 ENV on 2048 bits.
+ * 0: the Bloom filter is not used */
+#ifndef EF_ENV_BLOOM_BITS
+#define EF_ENV_BLOOM_BITS                        2048
+#endif
+
+#if EF_ENV_BLOOM_BITS > 0
+#if (EF_ENV_BLOOM_BITS & (EF_ENV_BLOOM_BITS - 1)) != 0 || EF_ENV_BLOOM_BITS < 8
+#error "The ENV Bloom filter size must be power of 2 and not less than 8"
+#endif
+#define EF_ENV_USING_BLOOM
+/* the bit number for every ENV name */
+#define EF_ENV_BLOOM_HASH_NUM                    3
+#endif
+
+/* the max ENV number of one transaction. The transaction saves the key and value pointers, 12 bytes for every ENV.
+ * 0: the transaction is not used */
+#ifndef EF_TXN_ENV_MAX
+#define EF_TXN_ENV_MAX                           8
+#endif
+
+#if EF_TXN_ENV_MAX > 0
+#define EF_ENV_USING_TXN
+#endif
+
+/* the static wear leveling threshold. The least worn sector which has the cold ENV will be collected when its erase
+ * count is less than the most worn sector by this threshold. 0: the static wear leveling is not used */
+#ifndef EF_ENV_WEAR_LEVEL_THRESHOLD
+#define EF_ENV_WEAR_LEVEL_THRESHOLD              32
+#endif
+
+#if EF_ENV_WEAR_LEVEL_THRESHOLD > 0
+#define EF_ENV_USING_WEAR_LEVEL
+#endif
+
+/* the ENV checkpoint area (one sector) address. The checkpoint saves the sector state when the ENV is clean, so the
+ * ENV loading trusts it and skips the CRC check of every ENV. It's not defined: the checkpoint is not used */
+#ifdef EF_ENV_CHECKPOINT_ADDR
+#define EF_ENV_USING_CHECKPOINT
+#endif
+
 #if EF_ENV_CACHE_TABLE_SIZE > 0xFFFF
 #error "The ENV cache table size must less than 0xFFFF"
 #endif
@@ -110,6 +183,7 @@
 #define STORE_STATUS_TABLE_SIZE                  STATUS_TABLE_SIZE(SECTOR_STORE_STATUS_NUM)
 #define DIRTY_STATUS_TABLE_SIZE                  STATUS_TABLE_SIZE(SECTOR_DIRTY_STATUS_NUM)
 #define ENV_STATUS_TABLE_SIZE                    STATUS_TABLE_SIZE(ENV_STATUS_NUM)
+#define CHECKPOINT_STATUS_TABLE_SIZE             STATUS_TABLE_SIZE(CHECKPOINT_STATUS_NUM)
 
 #define SECTOR_SIZE                              EF_ERASE_MIN_SIZE
 #define SECTOR_NUM                               (ENV_AREA_SIZE / (EF_ERASE_MIN_SIZE))
@@ -122,14 +196,27 @@
 #error "There is at least one empty sector for GC."
 #endif
 
+#if (EF_GC_EMPTY_SEC_TARGET <= EF_GC_EMPTY_SEC_THRESHOLD || EF_GC_EMPTY_SEC_TARGET > SECTOR_NUM)
+#error "The GC empty sector target must be larger than the GC threshold and not larger than the sector number"
+#endif
+
+#if (EF_GC_ERASE_COST == 0)
+#error "The GC erase cost must be larger than 0"
+#endif
+
 #define SECTOR_HDR_DATA_SIZE                     (EF_WG_ALIGN(sizeof(struct sector_hdr_data)))
 #define SECTOR_DIRTY_OFFSET                      ((unsigned long)(&((struct sector_hdr_data *)0)->status_table.dirty))
+#define SECTOR_COMBINED_OFFSET                   ((unsigned long)(&((struct sector_hdr_data *)0)->combined))
 #define ENV_HDR_DATA_SIZE                        (EF_WG_ALIGN(sizeof(struct env_hdr_data)))
 #define ENV_MAGIC_OFFSET                         ((unsigned long)(&((struct env_hdr_data *)0)->magic))
 #define ENV_LEN_OFFSET                           ((unsigned long)(&((struct env_hdr_data *)0)->len))
 #define ENV_NAME_LEN_OFFSET                      ((unsigned long)(&((struct env_hdr_data *)0)->name_len))
+#define CHECKPOINT_SIZE                          (EF_WG_ALIGN(sizeof(struct env_checkpoint)))
+#define CHECKPOINT_MAGIC_OFFSET                  ((unsigned long)(&((struct env_checkpoint *)0)->magic))
+#define CHECKPOINT_SEQ_OFFSET                    ((unsigned long)(&((struct env_checkpoint *)0)->seq))
 
 #define VER_NUM_ENV_NAME                         "__ver_num__"
+#define TXN_ENV_NAME                             "__txn__"
 
 enum sector_store_status {
     SECTOR_STORE_UNUSED,
@@ -149,6 +236,14 @@ enum sector_dirty_status {
 };
 typedef enum sector_dirty_status sector_dirty_status_t;
 
+enum checkpoint_status {
+    CHECKPOINT_UNUSED,
+    CHECKPOINT_VALID,
+    CHECKPOINT_STALE,
+    CHECKPOINT_STATUS_NUM,
+};
+typedef enum checkpoint_status checkpoint_status_t;
+
 struct sector_hdr_data {
     struct {
         uint8_t store[STORE_STATUS_TABLE_SIZE];  /**< sector store status @see sector_store_status_t */
@@ -156,7 +251,7 @@ struct sector_hdr_data {
     } status_table;
     uint32_t magic;                              /**< magic word(`E`, `F`, `4`, `0`) */
     uint32_t combined;                           /**< the combined next sector number, 0xFFFFFFFF: not combined */
-    uint32_t reserved;
+    uint32_t erase_count;                        /**< sector erase count, 0xFFFFFFFF: never counted */
 };
 typedef struct sector_hdr_data *sector_hdr_data_t;
 
@@ -169,11 +264,28 @@ struct sector_meta_data {
     uint32_t addr;                               /**< sector start address */
     uint32_t magic;                              /**< magic word(`E`, `F`, `4`, `0`) */
     uint32_t combined;                           /**< the combined next sector number, 0xFFFFFFFF: not combined */
+    uint32_t erase_count;                        /**< sector erase count */
     size_t remain;                               /**< remain size */
     uint32_t empty_env;                          /**< the next empty ENV node start address */
 };
 typedef struct sector_meta_data *sector_meta_data_t;
 
+/* the GC statistics of the sector, it's built on loading then updated by the ENV write, delete and sector format */
+struct sector_stat {
+    uint32_t live;                               /**< the valid ENV size */
+    uint32_t dead;                               /**< the deleted and broken ENV size */
+    uint32_t write_seq;                          /**< the ENV write sequence number of the last written ENV */
+    bool gc_failed;                              /**< moving the ENV failed on the current GC, so it's skipped */
+};
+typedef struct sector_stat *sector_stat_t;
+
+/* the GC victim sector */
+struct gc_victim {
+    uint32_t addr;                               /**< sector start address, FAILED_ADDR: not found */
+    uint64_t score;                              /**< the GC score by the GC policy */
+    uint32_t erase_count;                        /**< sector erase count */
+};
+
 struct env_hdr_data {
     uint8_t status_table[ENV_STATUS_TABLE_SIZE]; /**< ENV node status, @see node_status_t */
     uint32_t magic;                              /**< magic word(`K`, `V`, `4`, `0`) */
@@ -197,7 +309,42 @@ struct sector_cache_node {
 };
 typedef struct sector_cache_node *sector_cache_node_t;
 
+struct env_index_node {
+    uint32_t name_hash;                          /**< ENV name's CRC32 value */
+    uint32_t addr;                               /**< ENV node address, FAILED_ADDR: unused */
+};
+typedef struct env_index_node *env_index_node_t;
+
+struct txn_env_node {
+    const char *key;                             /**< ENV name */
+    const void *value;                           /**< ENV value, it's kept by user until committed */
+    size_t value_len;                            /**< value length */
+};
+typedef struct txn_env_node *txn_env_node_t;
+
+struct txn_data {
+    uint32_t env_addr;                           /**< the first transaction ENV address */
+    uint32_t env_num;                            /**< the transaction ENV number, they are continuous */
+};
+
+/* the ENV sector state when the ENV is clean, the combined sector is on the first sector */
+struct env_checkpoint {
+    uint8_t status_table[CHECKPOINT_STATUS_TABLE_SIZE]; /**< checkpoint status @see checkpoint_status_t */
+    uint32_t magic;                              /**< magic word(`E`, `F`, `C`, `P`) */
+    uint32_t crc32;                              /**< checkpoint crc32(seq + sector_num + sector) */
+    uint32_t seq;                                /**< sequence number, it's increased by every checkpoint */
+    uint32_t sector_num;                         /**< ENV sector number */
+    struct {
+        uint32_t erase_count;                    /**< sector erase count */
+        uint32_t empty_env;                      /**< the empty ENV address (the data end) of the sector */
+    } sector[SECTOR_NUM];
+};
+
 static void gc_collect(void);
+static EfErrCode read_env(env_node_obj_t env);
+#ifdef EF_ENV_USING_CHECKPOINT
+static void checkpoint_stale(void);
+#endif
 
 /* ENV start address in flash */
 static uint32_t env_start_addr = 0;
@@ -211,6 +358,40 @@ static bool init_ok = false;
 static bool gc_request = false;
 /* is in recovery check status when first reboot */
 static bool in_recovery_check = false;
+/* is in GC collecting, the empty sectors which are kept for GC can be used */
+static bool in_gc_collect = false;
+/* the sector number of the combined ENV which is failed to alloc, the GC collects until it has enough empty sectors */
+static size_t gc_combined_sec_num = 0;
+/* the last moved ENV address on the sector which is collecting by incremental GC, FAILED_ADDR: not collecting */
+static uint32_t gc_step_env_addr = FAILED_ADDR;
+/* the sectors which are compacted for the combined ENV, the moved ENV are not allocated on them */
+static uint32_t gc_reserve_addr = FAILED_ADDR;
+static size_t gc_reserve_sec_num = 0;
+/* the GC victim sector selection policy */
+static EfGcPolicy gc_policy = EF_GC_POLICY;
+/* the GC statistics of all sectors, the combined sector is on the first sector */
+static struct sector_stat sector_stat_table[SECTOR_NUM];
+/* the ENV write sequence number, it's the age of the sector for the age-weighted GC policy */
+static uint32_t env_write_seq = 0;
+/* the ENV size which is written by user and moved by GC since loading, it's for the write amplification */
+static uint32_t env_user_write_size = 0, env_gc_write_size = 0;
+
+#ifdef EF_ENV_USING_CHECKPOINT
+/* the valid checkpoint address, FAILED_ADDR: the ENV is changed since the last checkpoint or no checkpoint */
+static uint32_t checkpoint_addr = FAILED_ADDR;
+/* the address for the next checkpoint */
+static uint32_t checkpoint_next_addr = EF_ENV_CHECKPOINT_ADDR;
+/* the last checkpoint sequence number */
+static uint32_t checkpoint_seq = 0;
+#endif
+
+#ifdef EF_ENV_USING_TXN
+/* the ENV of the current transaction */
+static struct txn_env_node txn_env_table[EF_TXN_ENV_MAX];
+static size_t txn_env_num = 0;
+/* the transaction is began */
+static bool txn_is_began = false;
+#endif
 
 #ifdef EF_ENV_USING_CACHE
 /* ENV cache table */
@@ -219,6 +400,24 @@ struct env_cache_node env_cache_table[EF_ENV_CACHE_TABLE_SIZE] = { 0 };
 struct sector_cache_node sector_cache_table[EF_SECTOR_CACHE_TABLE_SIZE] = { 0 };
 #endif /* EF_ENV_USING_CACHE */
 
+#ifdef EF_ENV_USING_INDEX
+/* ENV hash index table, it's using open addressing with linear probing */
+static struct env_index_node env_index_table[EF_ENV_INDEX_TABLE_SIZE];
+/* the used node number */
+static size_t env_index_used = 0;
+/* the index is usable, it's built on loading */
+static bool env_index_ok = false;
+/* the index has all of the ENV, the ENV which is not on index is absent */
+static bool env_index_all = false;
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_BLOOM
+/* ENV name Bloom filter, the ENV is not on flash when any bit of its name is 0. The bits are not cleared on delete. */
+static uint8_t env_bloom[EF_ENV_BLOOM_BITS / 8];
+/* the Bloom filter has all of the ENV, it's built on loading */
+static bool env_bloom_ok = false;
+#endif /* EF_ENV_USING_BLOOM */
+
 static size_t set_status(uint8_t status_table[], size_t status_num, size_t status_index)
 {
     size_t byte_index = ~0UL;
@@ -279,12 +478,16 @@ static EfErrCode write_status(uint32_t addr, uint8_t status_table[], size_t stat
     if (byte_index == ~0UL) {
         return EF_NO_ERR;
     }
+#ifdef EF_ENV_USING_CHECKPOINT
+    /* the ENV is changed by every status writing */
+    checkpoint_stale();
+#endif
 #if (EF_WRITE_GRAN == 1)
-    result = ef_port_write(addr + byte_index, (uint32_t *)&status_table[byte_index], 1);
+    result = ef_port_write_status(addr + byte_index, (uint32_t *)&status_table[byte_index], 1);
 #else /*  (EF_WRITE_GRAN == 8) ||  (EF_WRITE_GRAN == 32) ||  (EF_WRITE_GRAN == 64) */
     /* write the status by write granularity
      * some flash (like stm32 onchip) NOT supported repeated write before erase */
-    result = ef_port_write(addr + byte_index, (uint32_t *) &status_table[byte_index], EF_WRITE_GRAN / 8);
+    result = ef_port_write_status(addr + byte_index, (uint32_t *) &status_table[byte_index], EF_WRITE_GRAN / 8);
 #endif /* EF_WRITE_GRAN == 1 */
 
     return result;
@@ -419,31 +622,200 @@ static bool get_env_from_cache(const char *name, size_t name_len, uint32_t *addr
 }
 #endif /* EF_ENV_USING_CACHE */
 
+#ifdef EF_ENV_USING_INDEX
+static void reset_env_index(void)
+{
+    size_t i;
+
+    for (i = 0; i < EF_ENV_INDEX_TABLE_SIZE; i++) {
+        env_index_table[i].addr = FAILED_ADDR;
+    }
+    env_index_used = 0;
+    env_index_all = true;
+}
+
+/*
+ * Add the ENV address to index. The ENV is not added when the table is too full, then the ENV which is not on index
+ * is found by traversal.
+ */
+static void add_env_index(const char *name, size_t name_len, uint32_t addr)
+{
+    uint32_t name_hash;
+    size_t i;
+
+    if (!env_index_ok) {
+        return;
+    }
+    /* keep 1/4 table empty, so the probing is short */
+    if (env_index_used >= EF_ENV_INDEX_TABLE_SIZE / 4 * 3) {
+        if (env_index_all) {
+            EF_INFO("Warning: The ENV index table (%d) is full, please increase EF_ENV_INDEX_TABLE_SIZE.\n",
+                    EF_ENV_INDEX_TABLE_SIZE);
+            env_index_all = false;
+        }
+        return;
+    }
+
+    name_hash = ef_calc_crc32(0, name, name_len);
+    for (i = name_hash & (EF_ENV_INDEX_TABLE_SIZE - 1); env_index_table[i].addr != FAILED_ADDR;
+            i = (i + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1)) {
+        /* the moved ENV may be added again on loading */
+        if (env_index_table[i].name_hash == name_hash && env_index_table[i].addr == addr) {
+            return;
+        }
+    }
+    env_index_table[i].name_hash = name_hash;
+    env_index_table[i].addr = addr;
+    env_index_used++;
+}
+
+/*
+ * Delete the ENV address on index. The following nodes on the probing chain are moved back, so the deleted
+ * node is not needed to be marked.
+ */
+static void del_env_index(const char *name, size_t name_len, uint32_t addr)
+{
+    uint32_t name_hash;
+    size_t i, j, home;
+
+    if (!env_index_ok) {
+        return;
+    }
+
+    name_hash = ef_calc_crc32(0, name, name_len);
+    for (i = name_hash & (EF_ENV_INDEX_TABLE_SIZE - 1); env_index_table[i].addr != FAILED_ADDR;
+            i = (i + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1)) {
+        if (env_index_table[i].name_hash == name_hash && env_index_table[i].addr == addr) {
+            break;
+        }
+    }
+    if (env_index_table[i].addr == FAILED_ADDR) {
+        return;
+    }
+    for (j = (i + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1); env_index_table[j].addr != FAILED_ADDR;
+            j = (j + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1)) {
+        home = env_index_table[j].name_hash & (EF_ENV_INDEX_TABLE_SIZE - 1);
+        /* the node is kept when its home is in (i, j] */
+        if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) {
+            continue;
+        }
+        env_index_table[i] = env_index_table[j];
+        i = j;
+    }
+    env_index_table[i].addr = FAILED_ADDR;
+    env_index_used--;
+}
+
+/*
+ * Find the ENV by index, the ENV on flash is read for checking. It's only used when the index is OK.
+ */
+static bool find_env_by_index(const char *key, size_t key_len, env_node_obj_t env)
+{
+    uint32_t name_hash = ef_calc_crc32(0, key, key_len);
+    size_t i;
+
+    for (i = name_hash & (EF_ENV_INDEX_TABLE_SIZE - 1); env_index_table[i].addr != FAILED_ADDR;
+            i = (i + 1) & (EF_ENV_INDEX_TABLE_SIZE - 1)) {
+        if (env_index_table[i].name_hash == name_hash) {
+            env->addr.start = env_index_table[i].addr;
+            read_env(env);
+            /* the hash may be conflicted, and the old ENV is kept until the new one is written */
+            if (env->crc_is_ok && env->status == ENV_WRITE && env->name_len == key_len
+                    && !strncmp(env->name, key, key_len)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+#endif /* EF_ENV_USING_INDEX */
+
+#ifdef EF_ENV_USING_BLOOM
+/*
+ * Set or check the Bloom filter bits of ENV name. The bit positions are made by double hashing on name CRC32.
+ * It's return false when any bit is 0 on checking.
+ */
+static bool env_bloom_bits(const char *name, size_t name_len, bool set)
+{
+    uint32_t hash = ef_calc_crc32(0, name, name_len), step = ((hash >> 17) | (hash << 15)) | 1, bit;
+    size_t i;
+
+    for (i = 0; i < EF_ENV_BLOOM_HASH_NUM; i++, hash += step) {
+        bit = hash & (EF_ENV_BLOOM_BITS - 1);
+        if (set) {
+            env_bloom[bit / 8] |= 1 << (bit % 8);
+        } else if (!(env_bloom[bit / 8] & (1 << (bit % 8)))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif /* EF_ENV_USING_BLOOM */
+
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+/*
+ * Reset the ENV index and Bloom filter for building.
+ */
+static void reset_env_lookup(void)
+{
+#ifdef EF_ENV_USING_INDEX
+    reset_env_index();
+    env_index_ok = true;
+#endif
+#ifdef EF_ENV_USING_BLOOM
+    memset(env_bloom, 0, sizeof(env_bloom));
+#endif
+}
+
+static bool build_env_lookup_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    if (env->crc_is_ok && env->status == ENV_WRITE) {
+#ifdef EF_ENV_USING_INDEX
+        add_env_index(env->name, env->name_len, env->addr.start);
+#endif
+#ifdef EF_ENV_USING_BLOOM
+        env_bloom_bits(env->name, env->name_len, true);
+#endif
+    }
+
+    return false;
+}
+#endif /* defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM) */
+
 #define EF_READ_BUF_SIZE 32
+/* the read buffer size for scanning the flash, it must be multiple of 4 */
+#define EF_SCAN_BUF_SIZE 128
 /*
  * find the continue 0xFF flash address to end address
  */
 static uint32_t continue_ff_addr(uint32_t start, uint32_t end)
 {
-    uint8_t buf[EF_READ_BUF_SIZE], last_data = 0x00;
+    uint32_t buf[EF_SCAN_BUF_SIZE / sizeof(uint32_t)];
+    uint8_t *buf8 = (uint8_t *) buf;
     size_t i, addr = start, read_size;
 
-    for (; start < end; start += sizeof(buf)) {
+    for (; start < end; start += read_size) {
         if (start + sizeof(buf) < end) {
             read_size = sizeof(buf);
         } else {
             read_size = end - start;
         }
-        ef_port_read(start, (uint32_t *) buf, read_size);
-        for (i = 0; i < read_size; i++) {
-            if (last_data != 0xFF && buf[i] == 0xFF) {
-                addr = start + i;
-            }
-            last_data = buf[i];
+        ef_port_read(start, buf, read_size);
+        /* find the last non-0xFF byte on buffer, the whole words are checked by word */
+        for (i = read_size; i % sizeof(uint32_t) && buf8[i - 1] == 0xFF; i--);
+        if (i % sizeof(uint32_t) == 0) {
+            for (; i > 0 && buf[i / sizeof(uint32_t) - 1] == 0xFFFFFFFF; i -= sizeof(uint32_t));
+            for (; i > 0 && buf8[i - 1] == 0xFF; i--);
+        }
+        if (i > 0) {
+            addr = start + i;
         }
     }
 
-    if (last_data == 0xFF) {
+    if (addr < end) {
         return EF_WG_ALIGN(addr);
     } else {
         return end;
@@ -455,30 +827,46 @@ static uint32_t continue_ff_addr(uint32_t start, uint32_t end)
  */
 static uint32_t find_next_env_addr(uint32_t start, uint32_t end)
 {
-    uint8_t buf[32];
-    uint32_t start_bak = start, i;
-    uint32_t magic;
+    uint32_t buf[EF_SCAN_BUF_SIZE / sizeof(uint32_t)];
+    uint32_t magic_addr, magic, read_size, i, window = sizeof(uint32_t);
 
 #ifdef EF_ENV_USING_CACHE
     uint32_t empty_env;
 
-    if (get_sector_from_cache(EF_ALIGN_DOWN(start, SECTOR_SIZE), &empty_env) && start == empty_env) {
-        return FAILED_ADDR;
+    if (get_sector_from_cache(EF_ALIGN_DOWN(start, SECTOR_SIZE), &empty_env)) {
+        /* there is no ENV after the sector empty address */
+        if (start >= empty_env) {
+            return FAILED_ADDR;
+        } else if (end > empty_env) {
+            end = empty_env;
+        }
     }
 #endif /* EF_ENV_USING_CACHE */
 
-    for (; start < end; start += (sizeof(buf) - sizeof(uint32_t))) {
-        ef_port_read(start, (uint32_t *) buf, sizeof(buf));
-        for (i = 0; i < sizeof(buf) - sizeof(uint32_t) && start + i < end; i++) {
-#ifndef EF_BIG_ENDIAN            /* Little Endian Order */
-            magic = buf[i] + (buf[i + 1] << 8) + (buf[i + 2] << 16) + (buf[i + 3] << 24);
-#else                       /* Big Endian Order */
-            magic = buf[i + 3] + (buf[i + 2] << 8) + (buf[i + 1] << 16) + (buf[i] << 24);
-#endif
-            if (magic == ENV_MAGIC_WORD && (start + i - ENV_MAGIC_OFFSET) >= start_bak) {
-                return start + i - ENV_MAGIC_OFFSET;
+    /* The ENV address is aligned by write granularity, so only the aligned addresses are checked. The next ENV is
+     * usually on the start address, so only one word is read at first and the read window is doubled on every read. */
+    while (start + ENV_MAGIC_OFFSET < end) {
+        magic_addr = start + ENV_MAGIC_OFFSET;
+        read_size = end - magic_addr + sizeof(uint32_t) - 1;
+        if (read_size > window) {
+            read_size = window;
+        }
+        if (window < sizeof(buf)) {
+            window *= 2;
+        }
+        ef_port_read(magic_addr, buf, read_size);
+        for (i = 0; i + sizeof(uint32_t) <= read_size && magic_addr + i < end; i += EF_WG_ALIGN(1)) {
+            /* the magic word has no 0xFF byte, so it's not on the erased word */
+            if (i % sizeof(uint32_t) == 0 && buf[i / sizeof(uint32_t)] == 0xFFFFFFFF) {
+                i += EF_ALIGN(sizeof(uint32_t), EF_WG_ALIGN(1)) - EF_WG_ALIGN(1);
+                continue;
+            }
+            memcpy(&magic, (uint8_t *) buf + i, sizeof(uint32_t));
+            if (magic == ENV_MAGIC_WORD) {
+                return magic_addr + i - ENV_MAGIC_OFFSET;
             }
         }
+        start += i;
     }
 
     return FAILED_ADDR;
@@ -495,6 +883,9 @@ static uint32_t get_next_env_addr(sector_meta_data_t sector, env_node_obj_t pre_
     if (pre_env->addr.start == FAILED_ADDR) {
         /* the first ENV address */
         addr = sector->addr + SECTOR_HDR_DATA_SIZE;
+    } else if (sector->combined != SECTOR_NOT_COMBINED) {
+        /* the combined sector only has one ENV */
+        return FAILED_ADDR;
     } else {
         if (pre_env->addr.start <= sector->addr + SECTOR_SIZE) {
             if (pre_env->crc_is_ok) {
@@ -508,7 +899,6 @@ static uint32_t get_next_env_addr(sector_meta_data_t sector, env_node_obj_t pre_
             addr = find_next_env_addr(addr, sector->addr + SECTOR_SIZE - SECTOR_HDR_DATA_SIZE);
 
             if (addr > sector->addr + SECTOR_SIZE || pre_env->len == 0) {
-                //TODO ÉÈÇøÁ¬ÐøÄ£Ê½
                 return FAILED_ADDR;
             }
         } else {
@@ -523,7 +913,7 @@ static uint32_t get_next_env_addr(sector_meta_data_t sector, env_node_obj_t pre_
 static EfErrCode read_env(env_node_obj_t env)
 {
     struct env_hdr_data env_hdr;
-    uint8_t buf[EF_READ_BUF_SIZE];
+    uint8_t buf[EF_SCAN_BUF_SIZE];
     uint32_t calc_crc32 = 0, crc_data_len, env_name_addr;
     EfErrCode result = EF_NO_ERR;
     size_t len, size;
@@ -532,7 +922,8 @@ static EfErrCode read_env(env_node_obj_t env)
     env->status = (env_status_t) get_status(env_hdr.status_table, ENV_STATUS_NUM);
     env->len = env_hdr.len;
 
-    if (env->len == ~0UL || env->len > ENV_AREA_SIZE || env->len < ENV_NAME_LEN_OFFSET) {
+    if (env->len == 0xFFFFFFFF || env->len > ENV_AREA_SIZE || env->len < ENV_NAME_LEN_OFFSET
+            || env->addr.start + env->len > env_start_addr + ENV_AREA_SIZE) {
         /* the ENV length was not write, so reserved the meta data for current ENV */
         env->len = ENV_HDR_DATA_SIZE;
         if (env->status != ENV_ERR_HDR) {
@@ -542,9 +933,6 @@ static EfErrCode read_env(env_node_obj_t env)
         }
         env->crc_is_ok = false;
         return EF_READ_ERR;
-    } else if (env->len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE && env->len < ENV_AREA_SIZE) {
-        //TODO ÉÈÇøÁ¬ÐøÄ£Ê½£¬»òÕßÐ´Èë³¤¶ÈÃ»ÓÐÐ´ÈëÍêÕû
-        EF_ASSERT(0);
     }
 
     /* CRC32 data len(header.name_len + header.value_len + name + value) */
@@ -599,9 +987,16 @@ static EfErrCode read_sector_meta_data(uint32_t addr, sector_meta_data_t sector,
     }
     sector->check_ok = true;
     /* get other sector meta data */
-    sector->combined = sec_hdr.combined;
+    sector->erase_count = sec_hdr.erase_count == 0xFFFFFFFF ? 0 : sec_hdr.erase_count;
     sector->status.store = (sector_store_status_t) get_status(sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM);
     sector->status.dirty = (sector_dirty_status_t) get_status(sec_hdr.status_table.dirty, SECTOR_DIRTY_STATUS_NUM);
+    /* the combined value is committed by the full status after it's written, so it's only valid on the full sector.
+     * The sector which has the uncommitted or broken value is one sector, its following sectors are formatted. */
+    sector->combined = sec_hdr.combined;
+    if (sector->combined != SECTOR_NOT_COMBINED && (sector->status.store != SECTOR_STORE_FULL || sector->combined == 0
+            || sector->combined > (env_start_addr + ENV_AREA_SIZE - addr) / SECTOR_SIZE)) {
+        sector->combined = SECTOR_NOT_COMBINED;
+    }
     /* traversal all ENV and calculate the remain space size */
     if (traversal) {
         sector->remain = 0;
@@ -738,6 +1133,24 @@ static bool find_env(const char *key, env_node_obj_t env)
 {
     bool find_ok = false;
 
+#ifdef EF_ENV_USING_BLOOM
+    /* the ENV is absent when it's rejected by Bloom filter */
+    if (env_bloom_ok && !env_bloom_bits(key, strlen(key), false)) {
+        return false;
+    }
+#endif /* EF_ENV_USING_BLOOM */
+
+#ifdef EF_ENV_USING_INDEX
+    /* the ENV is not found when it's not on index and the index has all of the ENV. It's building on recovery. */
+    if (env_index_ok && !in_recovery_check) {
+        if (find_env_by_index(key, strlen(key), env)) {
+            return true;
+        } else if (env_index_all) {
+            return false;
+        }
+    }
+#endif /* EF_ENV_USING_INDEX */
+
 #ifdef EF_ENV_USING_CACHE
     size_t key_len = strlen(key);
 
@@ -882,6 +1295,86 @@ char *ef_get_env(const char *key)
     return NULL;
 }
 
+/*
+ * Get the fixed length ENV value by one flash read. The ENV which value length is not same is NOT found.
+ */
+static bool get_env_fixed(const char *key, void *value, size_t len)
+{
+    struct env_node_obj env;
+    uint32_t buf[2];
+    bool find_ok = false;
+
+    EF_ASSERT(value);
+    EF_ASSERT(len <= sizeof(buf));
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return false;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    if (find_env(key, &env) && env.value_len == len) {
+        ef_port_read(env.addr.value, buf, len);
+        memcpy(value, buf, len);
+        find_ok = true;
+    }
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return find_ok;
+}
+
+/**
+ * Get an uint32_t ENV value by key name. The value is saved as 4 bytes binary by ef_set_env_u32.
+ *
+ * @note this function is supported reentrant, the value is NOT changed when the ENV is NOT found
+ *
+ * @param key ENV name
+ * @param value the ENV value
+ *
+ * @return TRUE: find the ENV and the value length is 4 bytes
+ */
+bool ef_get_env_u32(const char *key, uint32_t *value)
+{
+    return get_env_fixed(key, value, sizeof(uint32_t));
+}
+
+/**
+ * The same to ef_get_env_u32 for the int32_t ENV value.
+ */
+bool ef_get_env_i32(const char *key, int32_t *value)
+{
+    return get_env_fixed(key, value, sizeof(int32_t));
+}
+
+/**
+ * The same to ef_get_env_u32 for the uint64_t ENV value.
+ */
+bool ef_get_env_u64(const char *key, uint64_t *value)
+{
+    return get_env_fixed(key, value, sizeof(uint64_t));
+}
+
+/**
+ * The same to ef_get_env_u32 for the bool ENV value, it's saved as 1 byte.
+ */
+bool ef_get_env_bool(const char *key, bool *value)
+{
+    uint8_t byte;
+
+    EF_ASSERT(value);
+
+    if (get_env_fixed(key, &byte, sizeof(byte))) {
+        *value = byte != 0;
+        return true;
+    }
+
+    return false;
+}
+
 /**
  * read the ENV value by ENV object
  *
@@ -892,6 +1385,21 @@ char *ef_get_env(const char *key)
  * @return the actually read size on successful
  */
 size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len)
+{
+    return ef_read_env_value_at(env, 0, value_buf, buf_len);
+}
+
+/**
+ * read the ENV value from the offset by ENV object. The value before the offset is not read.
+ *
+ * @param env ENV object
+ * @param offset the value offset
+ * @param value_buf the buffer for store ENV value
+ * @param buf_len buffer length
+ *
+ * @return the actually read size on successful, it's 0 when the offset is out of the value
+ */
+size_t ef_read_env_value_at(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len)
 {
     size_t read_len = 0;
 
@@ -903,60 +1411,340 @@ size_t ef_read_env_value(env_node_obj_t env, uint8_t *value_buf, size_t buf_len)
         return 0;
     }
 
-    if (env->crc_is_ok) {
-        /* lock the ENV cache */
-        ef_port_env_lock();
+    /* lock the ENV cache */
+    ef_port_env_lock();
 
-        if (buf_len > env->value_len) {
-            read_len = env->value_len;
-        } else {
-            read_len = buf_len;
-        }
+    read_len = ef_read_iterated_env_value(env, offset, value_buf, buf_len);
 
-        ef_port_read(env->addr.value, (uint32_t *) value_buf, read_len);
-        /* unlock the ENV cache */
-        ef_port_env_unlock();
-    }
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
 
     return read_len;
 }
 
-static EfErrCode write_env_hdr(uint32_t addr, env_hdr_data_t env_hdr) {
-    EfErrCode result = EF_NO_ERR;
-    /* write the status will by write granularity */
-    result = write_status(addr, env_hdr->status_table, ENV_STATUS_NUM, ENV_PRE_WRITE);
-    if (result != EF_NO_ERR) {
-        return result;
+/**
+ * read the ENV value from the offset by ENV object without lock. It's used on the ef_env_iterate callback, the ENV
+ * lock is held by the iterator.
+ *
+ * @param env ENV object
+ * @param offset the value offset
+ * @param value_buf the buffer for store ENV value
+ * @param buf_len buffer length
+ *
+ * @return the actually read size on successful, it's 0 when the offset is out of the value
+ */
+size_t ef_read_iterated_env_value(env_node_obj_t env, size_t offset, uint8_t *value_buf, size_t buf_len)
+{
+    size_t read_len = 0;
+
+    EF_ASSERT(env);
+    EF_ASSERT(value_buf);
+
+    if (env->crc_is_ok && offset < env->value_len) {
+        if (buf_len > env->value_len - offset) {
+            read_len = env->value_len - offset;
+        } else {
+            read_len = buf_len;
+        }
+
+        ef_port_read(env->addr.value + offset, (uint32_t *) value_buf, read_len);
     }
-    /* write other header data */
-    result = ef_port_write(addr + ENV_MAGIC_OFFSET, &env_hdr->magic, sizeof(struct env_hdr_data) - ENV_MAGIC_OFFSET);
 
-    return result;
+    return read_len;
+}
+
+/**
+ * Get the ENV value flash address and length by key name. The value can be read by DMA or memory-mapped flash
+ * on this address without copy.
+ *
+ * @note The address is invalid after the ENV is changed, deleted or moved by GC.
+ *
+ * @param key ENV name
+ * @param addr the value flash address
+ * @param value_len the value length
+ *
+ * @return true: find the ENV is OK, else return false
+ */
+bool ef_get_env_value_addr(const char *key, uint32_t *addr, size_t *value_len)
+{
+    struct env_node_obj env;
+
+    EF_ASSERT(addr);
+    EF_ASSERT(value_len);
+
+    if (!ef_get_env_obj(key, &env) || !env.crc_is_ok) {
+        return false;
+    }
+    *addr = env.addr.value;
+    *value_len = env.value_len;
+
+    return true;
+}
+
+/*
+ * Read the ENV header and name by one read, the value is not read. The ENV length is set for the next ENV address.
+ * The broken header is checked by read_env.
+ *
+ * @return true: the ENV is written and its name starts with the prefix
+ */
+static bool env_prefix_match(env_node_obj_t env, const char *prefix, size_t prefix_len)
+{
+    uint32_t buf[(ENV_HDR_DATA_SIZE + EF_WG_ALIGN(EF_ENV_NAME_MAX) + 3) / 4];
+    env_hdr_data_t env_hdr = (env_hdr_data_t) buf;
+    size_t read_size = sizeof(buf);
+
+    if (read_size > env_start_addr + ENV_AREA_SIZE - env->addr.start) {
+        read_size = env_start_addr + ENV_AREA_SIZE - env->addr.start;
+    }
+    if (read_size < ENV_HDR_DATA_SIZE) {
+        read_env(env);
+        return false;
+    }
+    ef_port_read(env->addr.start, buf, read_size);
+    env->status = (env_status_t) get_status(env_hdr->status_table, ENV_STATUS_NUM);
+    env->len = env_hdr->len;
+    if (env_hdr->magic != ENV_MAGIC_WORD || env->len == 0xFFFFFFFF || env->len > ENV_AREA_SIZE
+            || env->len < ENV_NAME_LEN_OFFSET || env->addr.start + env->len > env_start_addr + ENV_AREA_SIZE) {
+        read_env(env);
+        return false;
+    }
+    /* the length is OK, so the next ENV is behind it */
+    env->crc_is_ok = true;
+
+    return env->status == ENV_WRITE && env_hdr->name_len >= prefix_len && env_hdr->name_len <= EF_ENV_NAME_MAX
+            && ENV_HDR_DATA_SIZE + prefix_len <= read_size
+            && (prefix_len == 0 || !memcmp((uint8_t *) buf + ENV_HDR_DATA_SIZE, prefix, prefix_len));
+}
+
+/*
+ * Read the matched ENV and call the user callback. The lock is held, so the ENV which is iterating can't be changed
+ * by the other thread or interrupt.
+ *
+ * @return true: the iterator is interrupted by the callback
+ */
+static bool env_iterate_call(env_node_obj_t env, bool (*callback)(env_node_obj_t env, void *arg), void *arg,
+        size_t *env_num)
+{
+    if (read_env(env) != EF_NO_ERR) {
+        return false;
+    }
+    (*env_num)++;
+
+    return callback(env, arg);
+}
+
+/**
+ * Iterate the ENV which name starts with the prefix. The ENV name is checked before the value is read, and the ENV
+ * index is used when it's OK, so the other ENV value is not read. The iterating order is not the saved order.
+ *
+ * @note The callback runs with the ENV lock held, so it must be short and must not call the other ENV functions. The
+ *       value is read by ef_read_iterated_env_value.
+ *
+ * @param prefix ENV name prefix, NULL or "": all ENV
+ * @param callback the callback for every matched ENV, the iterator is interrupted when it returns true
+ * @param arg the callback argument
+ *
+ * @return the matched ENV number
+ */
+size_t ef_env_iterate(const char *prefix, bool (*callback)(env_node_obj_t env, void *arg), void *arg)
+{
+    struct env_node_obj env;
+    struct sector_meta_data sector;
+    size_t prefix_len = prefix ? strlen(prefix) : 0, env_num = 0;
+    uint32_t sec_addr;
+
+    EF_ASSERT(callback);
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return 0;
+    }
+    if (prefix_len > EF_ENV_NAME_MAX) {
+        return 0;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+#ifdef EF_ENV_USING_INDEX
+    if (env_index_ok && env_index_all) {
+        size_t i;
+        /* all of the written ENV are on the index */
+        for (i = 0; i < EF_ENV_INDEX_TABLE_SIZE; i++) {
+            if (env_index_table[i].addr == FAILED_ADDR) {
+                continue;
+            }
+            env.addr.start = env_index_table[i].addr;
+            if (env_prefix_match(&env, prefix, prefix_len) && env_iterate_call(&env, callback, arg, &env_num)) {
+                break;
+            }
+        }
+        goto __exit;
+    }
+#endif /* EF_ENV_USING_INDEX */
+
+    sector.addr = FAILED_ADDR;
+    while ((sec_addr = get_next_sector_addr(&sector)) != FAILED_ADDR) {
+        if (read_sector_meta_data(sec_addr, &sector, false) != EF_NO_ERR) {
+            continue;
+        }
+        if (sector.status.store != SECTOR_STORE_USING && sector.status.store != SECTOR_STORE_FULL) {
+            continue;
+        }
+        env.addr.start = FAILED_ADDR;
+        while ((env.addr.start = get_next_env_addr(&sector, &env)) != FAILED_ADDR) {
+            if (env_prefix_match(&env, prefix, prefix_len) && env_iterate_call(&env, callback, arg, &env_num)) {
+                goto __exit;
+            }
+        }
+    }
+
+__exit:
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return env_num;
+}
+
+static EfErrCode write_env_hdr(uint32_t addr, env_hdr_data_t env_hdr) {
+    EfErrCode result = EF_NO_ERR;
+    /* write the status will by write granularity */
+    result = write_status(addr, env_hdr->status_table, ENV_STATUS_NUM, ENV_PRE_WRITE);
+    if (result != EF_NO_ERR) {
+        return result;
+    }
+    /* write other header data */
+    result = ef_port_write(addr + ENV_MAGIC_OFFSET, &env_hdr->magic, sizeof(struct env_hdr_data) - ENV_MAGIC_OFFSET);
+
+    return result;
+}
+
+static sector_stat_t get_sector_stat(uint32_t addr)
+{
+    return &sector_stat_table[(EF_ALIGN_DOWN(addr, SECTOR_SIZE) - env_start_addr) / SECTOR_SIZE];
+}
+
+/*
+ * Update the GC statistics of the sector which has the ENV. The live ENV is added when it's written, and it's
+ * changed to dead when it's deleted.
+ */
+static void update_sector_stat(uint32_t env_addr, size_t env_len, bool is_live)
+{
+    sector_stat_t stat = get_sector_stat(env_addr);
+
+    if (is_live) {
+        stat->live += env_len;
+        stat->write_seq = ++env_write_seq;
+    } else {
+        stat->live = stat->live > env_len ? stat->live - env_len : 0;
+        stat->dead += env_len;
+    }
+}
+
+static void reset_sector_stat(void)
+{
+    memset(sector_stat_table, 0, sizeof(sector_stat_table));
+    env_write_seq = 0;
+}
+
+static bool build_sector_stat_cb(env_node_obj_t env, void *arg1, void *arg2)
+{
+    sector_stat_t stat;
+
+    if (env->crc_is_ok && (env->status == ENV_WRITE || env->status == ENV_PRE_DELETE)) {
+        update_sector_stat(env->addr.start, env->len, true);
+    } else if (env->len < ENV_AREA_SIZE) {
+        stat = get_sector_stat(env->addr.start);
+        stat->dead += env->len;
+    }
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+    build_env_lookup_cb(env, NULL, NULL);
+#endif
+
+    return false;
+}
+
+/*
+ * Get the erase count of the sector. The sector which is combined by the previous sector has no header, so the count
+ * of the combined sector is used.
+ */
+static uint32_t get_sector_erase_count(uint32_t addr)
+{
+    struct sector_meta_data sector;
+    uint32_t sec_addr = addr;
+
+    while (read_sector_meta_data(sec_addr, &sector, false) != EF_NO_ERR) {
+        if (sec_addr == env_start_addr) {
+            return 0;
+        }
+        sec_addr -= SECTOR_SIZE;
+    }
+    if (sec_addr == addr || (sector.combined != SECTOR_NOT_COMBINED && sec_addr + sector.combined * SECTOR_SIZE > addr)) {
+        return sector.erase_count;
+    }
+
+    return 0;
 }
 
 static EfErrCode format_sector(uint32_t addr, uint32_t combined_value)
 {
     EfErrCode result = EF_NO_ERR;
     struct sector_hdr_data sec_hdr;
+    uint32_t erase_count = 0, count, i;
 
     EF_ASSERT(addr % SECTOR_SIZE == 0);
 
-    result = ef_port_erase(addr, SECTOR_SIZE);
+    /* the new erase count is the most worn sector count of the erased area add 1 */
+    for (i = 0; i < (combined_value == SECTOR_NOT_COMBINED ? 1 : combined_value); i++) {
+        count = get_sector_erase_count(addr + i * SECTOR_SIZE);
+        if (count > erase_count) {
+            erase_count = count;
+        }
+    }
+    if (erase_count < 0xFFFFFFFE) {
+        erase_count++;
+    }
+
+#ifdef EF_ENV_USING_CHECKPOINT
+    checkpoint_stale();
+#endif
+    if (combined_value == SECTOR_NOT_COMBINED) {
+        result = ef_port_erase(addr, SECTOR_SIZE);
+    } else {
+        /* erase all of the combined sectors by one burst */
+        result = ef_port_erase(addr, combined_value * SECTOR_SIZE);
+    }
     if (result == EF_NO_ERR) {
         /* initialize the header data */
         memset(&sec_hdr, 0xFF, sizeof(struct sector_hdr_data));
         set_status(sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM, SECTOR_STORE_EMPTY);
         set_status(sec_hdr.status_table.dirty, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_FALSE);
         sec_hdr.magic = SECTOR_MAGIC_WORD;
-        sec_hdr.combined = combined_value;
-        sec_hdr.reserved = 0xFFFFFFFF;
+        sec_hdr.erase_count = erase_count;
         /* save the header */
         result = ef_port_write(addr, (uint32_t *)&sec_hdr, sizeof(struct sector_hdr_data));
+        /* The combined value is written after the header, then the full status commits it, the combined sector is
+         * only for one ENV. It's an empty sector when the power is lost before the commit. */
+        if (result == EF_NO_ERR && combined_value != SECTOR_NOT_COMBINED) {
+            result = ef_port_write(addr + SECTOR_COMBINED_OFFSET, &combined_value, sizeof(combined_value));
+            if (result == EF_NO_ERR) {
+                result = write_status(addr, sec_hdr.status_table.store, SECTOR_STORE_STATUS_NUM, SECTOR_STORE_FULL);
+            }
+        }
 
 #ifdef EF_ENV_USING_CACHE
         /* delete the sector cache */
         update_sector_cache(addr, addr + SECTOR_SIZE);
 #endif /* EF_ENV_USING_CACHE */
+
+        /* the GC statistics of the erased sectors are reset */
+        memset(get_sector_stat(addr), 0, (combined_value == SECTOR_NOT_COMBINED ? 1 : combined_value)
+                * sizeof(struct sector_stat));
+
+        /* the incremental GC sector is collected */
+        if (EF_ALIGN_DOWN(gc_step_env_addr, SECTOR_SIZE) == addr) {
+            gc_step_env_addr = FAILED_ADDR;
+        }
     }
 
     return result;
@@ -967,7 +1755,13 @@ static EfErrCode update_sec_status(sector_meta_data_t sector, size_t new_env_len
     uint8_t status_table[STORE_STATUS_TABLE_SIZE];
     EfErrCode result = EF_NO_ERR;
     /* change the current sector status */
-    if (sector->status.store == SECTOR_STORE_EMPTY) {
+    if (sector->status.store == SECTOR_STORE_EMPTY && sector->combined != SECTOR_NOT_COMBINED) {
+        /* combine the empty sectors which are allocated for the new ENV */
+        result = format_sector(sector->addr, sector->combined);
+        if (is_full) {
+            *is_full = true;
+        }
+    } else if (sector->status.store == SECTOR_STORE_EMPTY) {
         /* change the sector status to using */
         result = write_status(sector->addr, status_table, SECTOR_STORE_STATUS_NUM, SECTOR_STORE_USING);
     } else if (sector->status.store == SECTOR_STORE_USING) {
@@ -1025,6 +1819,15 @@ static bool sector_statistics_cb(sector_meta_data_t sector, void *arg1, void *ar
     return false;
 }
 
+/*
+ * The sector is compacted for the combined ENV, so the moved ENV are not allocated on it.
+ */
+static bool in_gc_reserve(uint32_t addr)
+{
+    return gc_reserve_addr != FAILED_ADDR && addr >= gc_reserve_addr
+            && addr < gc_reserve_addr + gc_reserve_sec_num * SECTOR_SIZE;
+}
+
 static bool alloc_env_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     size_t *env_size = arg1;
@@ -1033,7 +1836,7 @@ static bool alloc_env_cb(sector_meta_data_t sector, void *arg1, void *arg2)
     /* 1. sector has space
      * 2. the NO dirty sector
      * 3. the dirty sector only when the gc_request is false */
-    if (sector->check_ok && sector->remain > *env_size
+    if (sector->check_ok && sector->remain > *env_size && !in_gc_reserve(sector->addr)
             && ((sector->status.dirty == SECTOR_DIRTY_FALSE)
                     || (sector->status.dirty == SECTOR_DIRTY_TRUE && !gc_request))) {
         *empty_env = sector->empty_env;
@@ -1043,6 +1846,64 @@ static bool alloc_env_cb(sector_meta_data_t sector, void *arg1, void *arg2)
     return false;
 }
 
+/*
+ * Alloc the ENV which is larger than one sector on the continuous empty sectors. The sectors will be combined as one
+ * sector when the ENV is written. The GC is requested when the empty sectors are not enough or split, it collects
+ * and compacts the sectors for the combined ENV.
+ */
+static uint32_t alloc_combined_env(sector_meta_data_t sector, size_t env_size, size_t empty_sector)
+{
+    size_t sec_num = (SECTOR_HDR_DATA_SIZE + env_size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    uint32_t sec_addr, start = FAILED_ADDR;
+
+    /* keep the empty sectors for GC, the combined ENV uses more than one sector. The ENV which is recovered on
+     * loading can use them, its old sectors are collected without moving. */
+    if (empty_sector < sec_num + EF_GC_EMPTY_SEC_THRESHOLD && !in_gc_collect && !in_recovery_check) {
+        EF_DEBUG("Trigger a GC check after alloc combined ENV failed.\n");
+        gc_request = true;
+        gc_combined_sec_num = sec_num;
+        return FAILED_ADDR;
+    }
+    /* find the continuous empty sectors */
+    sector->addr = FAILED_ADDR;
+    while ((sec_addr = get_next_sector_addr(sector)) != FAILED_ADDR) {
+        read_sector_meta_data(sec_addr, sector, false);
+        if (sector->check_ok && sector->status.store == SECTOR_STORE_EMPTY) {
+            if (start == FAILED_ADDR) {
+                start = sec_addr;
+            }
+            if (sec_addr + SECTOR_SIZE - start == sec_num * SECTOR_SIZE) {
+                read_sector_meta_data(start, sector, false);
+                sector->combined = sec_num;
+                sector->remain = sec_num * SECTOR_SIZE - SECTOR_HDR_DATA_SIZE;
+                sector->empty_env = start + SECTOR_HDR_DATA_SIZE;
+                return sector->empty_env;
+            }
+        } else {
+            start = FAILED_ADDR;
+        }
+    }
+    EF_DEBUG("Trigger a GC check after the empty sectors are split for combined ENV.\n");
+    gc_request = true;
+    gc_combined_sec_num = sec_num;
+
+    return FAILED_ADDR;
+}
+
+static bool alloc_empty_sector_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    uint32_t *empty_addr = arg1, *min_count = arg2;
+
+    /* the least worn empty sector */
+    if (sector->check_ok && !in_gc_reserve(sector->addr)
+            && (*empty_addr == FAILED_ADDR || sector->erase_count < *min_count)) {
+        *empty_addr = sector->addr;
+        *min_count = sector->erase_count;
+    }
+
+    return false;
+}
+
 static uint32_t alloc_env(sector_meta_data_t sector, size_t env_size)
 {
     uint32_t empty_env = FAILED_ADDR;
@@ -1050,13 +1911,24 @@ static uint32_t alloc_env(sector_meta_data_t sector, size_t env_size)
 
     /* sector status statistics */
     sector_iterator(sector, SECTOR_STORE_UNUSED, &empty_sector, &using_sector, sector_statistics_cb, false);
+    if (env_size > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
+        return alloc_combined_env(sector, env_size, empty_sector);
+    }
     if (using_sector > 0) {
         /* alloc the ENV from the using status sector first */
         sector_iterator(sector, SECTOR_STORE_USING, &env_size, &empty_env, alloc_env_cb, true);
     }
     if (empty_sector > 0 && empty_env == FAILED_ADDR) {
         if (empty_sector > EF_GC_EMPTY_SEC_THRESHOLD || gc_request) {
-            sector_iterator(sector, SECTOR_STORE_EMPTY, &env_size, &empty_env, alloc_env_cb, true);
+            uint32_t empty_addr = FAILED_ADDR, min_count = 0;
+            /* alloc the ENV from the least worn empty sector */
+            sector_iterator(sector, SECTOR_STORE_EMPTY, &empty_addr, &min_count, alloc_empty_sector_cb, false);
+            if (empty_addr != FAILED_ADDR) {
+                read_sector_meta_data(empty_addr, sector, true);
+                if (sector->remain > env_size) {
+                    empty_env = sector->empty_env;
+                }
+            }
         } else {
             /* no space for new ENV now will GC and retry */
             EF_DEBUG("Trigger a GC check after alloc ENV failed.\n");
@@ -1110,6 +1982,14 @@ static EfErrCode del_env(const char *key, env_node_obj_t old_env, bool complete_
         }
 
         last_is_complete_del = false;
+#ifdef EF_ENV_USING_INDEX
+        if (result == EF_NO_ERR) {
+            del_env_index(old_env->name, old_env->name_len, old_env->addr.start);
+        }
+#endif /* EF_ENV_USING_INDEX */
+        if (result == EF_NO_ERR) {
+            update_sector_stat(old_env->addr.start, old_env->len, false);
+        }
     }
 
     dirty_status_addr = EF_ALIGN_DOWN(old_env->addr.start, SECTOR_SIZE) + SECTOR_DIRTY_OFFSET;
@@ -1132,18 +2012,13 @@ static EfErrCode move_env(env_node_obj_t env)
     uint32_t env_addr;
     struct sector_meta_data sector;
 
-    /* prepare to delete the current ENV */
-    if (env->status == ENV_WRITE) {
-        del_env(NULL, env, false);
-    }
-
     if ((env_addr = alloc_env(&sector, env->len)) != FAILED_ADDR) {
         if (in_recovery_check) {
             struct env_node_obj env_bak;
             char name[EF_ENV_NAME_MAX + 1] = { 0 };
             strncpy(name, env->name, env->name_len);
-            /* check the ENV in flash is already create success */
-            if (find_env_no_cache(name, &env_bak)) {
+            /* check the ENV in flash is already create success, the GC on loading may find the moving ENV itself */
+            if (find_env_no_cache(name, &env_bak) && env_bak.addr.start != env->addr.start) {
                 /* already create success, don't need to duplicate */
                 result = EF_NO_ERR;
                 goto __exit;
@@ -1152,9 +2027,13 @@ static EfErrCode move_env(env_node_obj_t env)
     } else {
         return EF_ENV_FULL;
     }
+    /* prepare to delete the current ENV, it's after the space is allocated, so the ENV is kept when alloc failed */
+    if (env->status == ENV_WRITE) {
+        del_env(NULL, env, false);
+    }
     /* start move the ENV */
     {
-        uint8_t buf[32];
+        uint32_t buf[EF_SCAN_BUF_SIZE / sizeof(uint32_t)];
         size_t len, size, env_len = env->len;
 
         /* update the new ENV sector status first */
@@ -1162,22 +2041,34 @@ static EfErrCode move_env(env_node_obj_t env)
 
         write_status(env_addr, status_table, ENV_STATUS_NUM, ENV_PRE_WRITE);
         env_len -= ENV_MAGIC_OFFSET;
-        for (len = 0, size = 0; len < env_len; len += size) {
+        for (len = 0, size = 0; len < env_len && result == EF_NO_ERR; len += size) {
             if (len + sizeof(buf) < env_len) {
                 size = sizeof(buf);
             } else {
                 size = env_len - len;
             }
-            ef_port_read(env->addr.start + ENV_MAGIC_OFFSET + len, (uint32_t *) buf, EF_WG_ALIGN(size));
-            result = ef_port_write(env_addr + ENV_MAGIC_OFFSET + len, (uint32_t *) buf, size);
+            ef_port_read(env->addr.start + ENV_MAGIC_OFFSET + len, buf, EF_WG_ALIGN(size));
+            result = ef_port_write(env_addr + ENV_MAGIC_OFFSET + len, buf, size);
+        }
+        /* the old ENV is kept when the new one is not written, it's recovered on loading */
+        if (result != EF_NO_ERR) {
+            return result;
         }
         write_status(env_addr, status_table, ENV_STATUS_NUM, ENV_WRITE);
+        update_sector_stat(env_addr, env->len, true);
+        env_gc_write_size += env->len;
 
 #ifdef EF_ENV_USING_CACHE
         update_sector_cache(EF_ALIGN_DOWN(env_addr, SECTOR_SIZE),
                 env_addr + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env->name_len) + EF_WG_ALIGN(env->value_len));
         update_env_cache(env->name, env->name_len, env_addr);
 #endif /* EF_ENV_USING_CACHE */
+#ifdef EF_ENV_USING_INDEX
+        add_env_index(env->name, env->name_len, env_addr);
+#endif
+#ifdef EF_ENV_USING_BLOOM
+        env_bloom_bits(env->name, env->name_len, true);
+#endif
     }
 
     EF_DEBUG("Moved the ENV (%.*s) from 0x%08X to 0x%08X.\n", env->name_len, env->name, env->addr.start, env_addr);
@@ -1224,9 +2115,27 @@ static bool gc_check_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 
 }
 
+/*
+ * Format the collected sector. The combined sector is split from the last sector, so the erase count of the following
+ * sectors is got from the combined sector header, and they are hidden by it until the first sector is formatted.
+ */
+static void format_collected_sector(sector_meta_data_t sector)
+{
+    uint32_t i;
+
+    if (sector->combined == SECTOR_NOT_COMBINED) {
+        format_sector(sector->addr, SECTOR_NOT_COMBINED);
+    } else {
+        for (i = sector->combined; i > 0; i--) {
+            format_sector(sector->addr + (i - 1) * SECTOR_SIZE, SECTOR_NOT_COMBINED);
+        }
+    }
+}
+
 static bool do_gc(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     struct env_node_obj env;
+    bool move_failed = false;
 
     if (sector->check_ok && (sector->status.dirty == SECTOR_DIRTY_TRUE || sector->status.dirty == SECTOR_DIRTY_GC)) {
         uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
@@ -1240,60 +2149,334 @@ static bool do_gc(sector_meta_data_t sector, void *arg1, void *arg2)
                 /* move the ENV to new space */
                 if (move_env(&env) != EF_NO_ERR) {
                     EF_DEBUG("Error: Moved the ENV (%.*s) for GC failed.\n", env.name_len, env.name);
+                    move_failed = true;
                 }
             }
         }
-        format_sector(sector->addr, SECTOR_NOT_COMBINED);
-        EF_DEBUG("Collect a sector @0x%08X\n", sector->addr);
+        /* the sector which has the ENV is kept on GC status, it's collected by the next GC */
+        if (move_failed) {
+            get_sector_stat(sector->addr)->gc_failed = true;
+        } else {
+            format_collected_sector(sector);
+            EF_DEBUG("Collect a sector @0x%08X\n", sector->addr);
+        }
+    }
+
+    return false;
+}
+
+#ifdef EF_ENV_USING_WEAR_LEVEL
+static bool wear_level_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    sector_meta_data_t coldest = arg1;
+    uint32_t *max_count = arg2;
+
+    if (sector->check_ok) {
+        if (sector->erase_count > *max_count) {
+            *max_count = sector->erase_count;
+        }
+        /* the full sector which is least worn has the cold ENV */
+        if (sector->status.store == SECTOR_STORE_FULL && sector->status.dirty != SECTOR_DIRTY_GC
+                && sector->combined == SECTOR_NOT_COMBINED
+                && (coldest->addr == FAILED_ADDR || sector->erase_count < coldest->erase_count)) {
+            *coldest = *sector;
+        }
     }
 
     return false;
 }
 
 /*
- * The GC will be triggered on the following scene:
- * 1. alloc an ENV when the flash not has enough space
- * 2. write an ENV then the flash not has enough space
+ * Static wear leveling. The cold ENV stay on the least worn sector, so this sector is set to dirty when it's less worn
+ * than the most worn sector by EF_ENV_WEAR_LEVEL_THRESHOLD. The cold ENV will be moved by GC then the sector is used
+ * by the hot ENV. The sector has few deleted ENV, so it has the low GC score and it must be collected by the caller.
+ *
+ * @return the sector address which need to be collected, FAILED_ADDR: no sector
  */
-static void gc_collect(void)
+static uint32_t wear_level_check(void)
 {
-    struct sector_meta_data sector;
-    size_t empty_sec = 0;
-
-    /* GC check the empty sector number */
-    sector_iterator(&sector, SECTOR_STORE_EMPTY, &empty_sec, NULL, gc_check_cb, false);
+    struct sector_meta_data sector, coldest;
+    uint32_t max_count = 0;
+    uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
 
-    /* do GC collect */
-    EF_DEBUG("The remain empty sector is %d, GC threshold is %d.\n", empty_sec, EF_GC_EMPTY_SEC_THRESHOLD);
-    if (empty_sec <= EF_GC_EMPTY_SEC_THRESHOLD) {
-        sector_iterator(&sector, SECTOR_STORE_UNUSED, NULL, NULL, do_gc, false);
+    coldest.addr = FAILED_ADDR;
+    sector_iterator(&sector, SECTOR_STORE_UNUSED, &coldest, &max_count, wear_level_cb, false);
+    if (coldest.addr != FAILED_ADDR && coldest.erase_count + EF_ENV_WEAR_LEVEL_THRESHOLD < max_count) {
+        EF_DEBUG("Collect the sector @0x%08X (erase count %lu, max %lu) for wear leveling.\n", coldest.addr,
+                coldest.erase_count, max_count);
+        if (coldest.status.dirty == SECTOR_DIRTY_FALSE) {
+            write_status(coldest.addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_TRUE);
+        }
+        return coldest.addr;
     }
 
-    gc_request = false;
+    return FAILED_ADDR;
 }
+#endif /* EF_ENV_USING_WEAR_LEVEL */
 
-static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size)
+/*
+ * Calculate the GC score of the dirty sector by the GC policy. The reclaimed space is the sector size without the
+ * live ENV, and the copy cost is the live ENV size and the sector erase cost. The ratio of them falls as the live ENV
+ * rises like the reclaimed space, so it's only useful with the age.
+ */
+static uint64_t calc_gc_score(sector_meta_data_t sector)
 {
-    EfErrCode result = EF_NO_ERR;
-    size_t align_remain;
+    sector_stat_t stat = get_sector_stat(sector->addr);
+    uint32_t sec_num = sector->combined == SECTOR_NOT_COMBINED ? 1 : sector->combined;
+    uint32_t reclaim = sec_num * SECTOR_SIZE - SECTOR_HDR_DATA_SIZE, cost, age;
 
-#if (EF_WRITE_GRAN / 8 > 0)
-    uint8_t align_data[EF_WRITE_GRAN / 8];
-    size_t align_data_size = sizeof(align_data);
-#else
-    /* For compatibility with C89 */
-    uint8_t align_data_u8, *align_data = &align_data_u8;
-    size_t align_data_size = 1;
-#endif
+    reclaim = stat->live < reclaim ? reclaim - stat->live : 0;
+    if (gc_policy == EF_GC_POLICY_GREEDY) {
+        return reclaim;
+    }
+    cost = stat->live + sec_num * EF_GC_ERASE_COST;
+    /* the sector which is not written for a long time has the cold ENV, it's not dirtier later */
+    age = env_write_seq - stat->write_seq;
+    if (age > 0xFFFF) {
+        age = 0xFFFF;
+    }
 
-    memset(align_data, 0xFF, align_data_size);
-    align_remain = EF_WG_ALIGN_DOWN(size);//use align_remain temporary to save aligned size.
+    return (((uint64_t) reclaim << 16) / cost) * (age + 1);
+}
 
-    if(align_remain > 0){//it may be 0 in this function.
-        result = ef_port_write(addr, buf, align_remain);
-    }
+static bool gc_victim_cb(sector_meta_data_t sector, void *arg1, void *arg2)
+{
+    struct gc_victim *victim = arg1;
+    bool *full_only = arg2;
+    uint64_t score;
 
-    align_remain = size - align_remain;
+    if (sector->check_ok && get_sector_stat(sector->addr)->gc_failed) {
+        /* its ENV can't be moved now */
+        return false;
+    } else if (sector->check_ok && sector->status.dirty == SECTOR_DIRTY_GC) {
+        /* resume the collecting sector first */
+        victim->addr = sector->addr;
+        return true;
+    } else if (sector->check_ok && sector->status.dirty == SECTOR_DIRTY_TRUE
+            && (!*full_only || sector->status.store == SECTOR_STORE_FULL)) {
+        score = calc_gc_score(sector);
+        /* the least worn sector is collected first when the score is same */
+        if (victim->addr == FAILED_ADDR || score > victim->score
+                || (score == victim->score && sector->erase_count < victim->erase_count)) {
+            victim->addr = sector->addr;
+            victim->score = score;
+            victim->erase_count = sector->erase_count;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Make the continuous empty sectors for the combined ENV when the empty sectors are split. The sectors which have the
+ * least live ENV are collected, and their ENV are moved out of them. The combined sectors which have the live ENV are
+ * not moved, the dead combined sectors are collected together.
+ *
+ * @return true: the continuous empty sectors are made
+ */
+static bool compact_sectors(size_t sec_num)
+{
+    struct sector_meta_data sector;
+    uint32_t start = FAILED_ADDR, addr, end, live, min_live = 0, area_end = env_start_addr + ENV_AREA_SIZE, n;
+    uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+    size_t empty;
+
+    /* find the sectors which have the least live ENV */
+    for (addr = env_start_addr; addr + sec_num * SECTOR_SIZE <= area_end; addr += SECTOR_SIZE) {
+        for (end = addr, live = 0, empty = 0; end < addr + sec_num * SECTOR_SIZE; end += n * SECTOR_SIZE) {
+            read_sector_meta_data(end, &sector, false);
+            /* the following sectors of combined sector have no header */
+            if (!sector.check_ok || (sector.combined != SECTOR_NOT_COMBINED && get_sector_stat(end)->live)) {
+                break;
+            }
+            n = sector.combined == SECTOR_NOT_COMBINED ? 1 : sector.combined;
+            live += get_sector_stat(end)->live;
+            empty += sector.status.store == SECTOR_STORE_EMPTY;
+        }
+        if (empty == sec_num) {
+            /* the continuous empty sectors are already made by GC */
+            return true;
+        } else if (end >= addr + sec_num * SECTOR_SIZE && end <= area_end
+                && (start == FAILED_ADDR || live < min_live)) {
+            start = addr;
+            min_live = live;
+        }
+    }
+    if (start == FAILED_ADDR) {
+        return false;
+    }
+    EF_DEBUG("Compact %d sectors @0x%08X for the combined ENV.\n", sec_num, start);
+    gc_reserve_addr = start;
+    gc_reserve_sec_num = sec_num;
+    for (addr = start; addr < start + sec_num * SECTOR_SIZE; addr += n * SECTOR_SIZE) {
+        read_sector_meta_data(addr, &sector, false);
+        n = sector.combined == SECTOR_NOT_COMBINED ? 1 : sector.combined;
+        if (sector.status.store == SECTOR_STORE_EMPTY) {
+            continue;
+        }
+        if (sector.status.dirty == SECTOR_DIRTY_FALSE) {
+            write_status(addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_TRUE);
+            read_sector_meta_data(addr, &sector, false);
+        }
+        do_gc(&sector, NULL, NULL);
+        read_sector_meta_data(addr, &sector, false);
+        if (sector.status.store != SECTOR_STORE_EMPTY) {
+            break;
+        }
+    }
+    gc_reserve_addr = FAILED_ADDR;
+
+    return addr >= start + sec_num * SECTOR_SIZE;
+}
+
+/*
+ * The GC will be triggered on the following scene:
+ * 1. alloc an ENV when the flash not has enough space
+ * 2. write an ENV then the flash not has enough space
+ * 3. alloc the combined ENV when the continuous empty sectors are not enough
+ */
+static void gc_collect(void)
+{
+    struct sector_meta_data sector;
+    size_t empty_sec = 0;
+
+    /* GC check the empty sector number */
+    sector_iterator(&sector, SECTOR_STORE_EMPTY, &empty_sec, NULL, gc_check_cb, false);
+
+    /* do GC collect */
+    EF_DEBUG("The remain empty sector is %d, GC threshold is %d.\n", empty_sec, EF_GC_EMPTY_SEC_THRESHOLD);
+    /* the empty sectors may be split, so the combined ENV always needs the collecting */
+    if (empty_sec <= EF_GC_EMPTY_SEC_THRESHOLD || gc_combined_sec_num) {
+        struct gc_victim victim;
+        bool full_only = false;
+        size_t i;
+
+        in_gc_collect = true;
+        for (i = 0; i < SECTOR_NUM; i++) {
+            sector_stat_table[i].gc_failed = false;
+        }
+#ifdef EF_ENV_USING_WEAR_LEVEL
+        /* the cold ENV sector has the low GC score, so it's collected first */
+        if ((victim.addr = wear_level_check()) != FAILED_ADDR) {
+            read_sector_meta_data(victim.addr, &sector, false);
+            do_gc(&sector, NULL, NULL);
+        }
+#endif
+        /* collect the best sector by the GC policy one by one until the empty sectors are enough. The combined ENV
+         * needs the continuous empty sectors, so all of the dirty sectors are collected for it. The sector is still
+         * dirty when it's formatted failed, so the sector number limits the collecting times. */
+        for (i = 0; i < SECTOR_NUM; i++) {
+            victim.addr = FAILED_ADDR;
+            sector_iterator(&sector, SECTOR_STORE_UNUSED, &victim, &full_only, gc_victim_cb, false);
+            if (victim.addr == FAILED_ADDR) {
+                break;
+            }
+            read_sector_meta_data(victim.addr, &sector, false);
+            do_gc(&sector, NULL, NULL);
+            empty_sec = 0;
+            sector_iterator(&sector, SECTOR_STORE_EMPTY, &empty_sec, NULL, gc_check_cb, false);
+            if (empty_sec >= EF_GC_EMPTY_SEC_TARGET && gc_combined_sec_num == 0) {
+                break;
+            }
+        }
+        /* the combined ENV is written on the continuous empty sectors, so the split empty sectors are compacted */
+        if (gc_combined_sec_num && !compact_sectors(gc_combined_sec_num)) {
+            EF_DEBUG("Warning: Compact %d sectors for the combined ENV failed.\n", gc_combined_sec_num);
+        }
+        in_gc_collect = false;
+    }
+
+    gc_request = false;
+    gc_combined_sec_num = 0;
+}
+
+
+/*
+ * Move one ENV out of the collecting sector, or format the sector when all of the ENV are moved.
+ * The collecting sector is in SECTOR_DIRTY_GC status, so it's resumed by the GC on loading after power failure.
+ *
+ * @return true: the GC has more work, false: nothing to collect or move the ENV failed
+ */
+static bool gc_step(bool *moved)
+{
+    struct sector_meta_data sector;
+    struct env_node_obj env;
+    struct gc_victim victim;
+    uint32_t gc_addr = FAILED_ADDR;
+    /* the using sector is not collected, it's still used by new ENV */
+    bool full_only = true;
+
+    *moved = false;
+    if (gc_step_env_addr != FAILED_ADDR) {
+        gc_addr = EF_ALIGN_DOWN(gc_step_env_addr, SECTOR_SIZE);
+    } else {
+        victim.addr = FAILED_ADDR;
+        sector_iterator(&sector, SECTOR_STORE_UNUSED, &victim, &full_only, gc_victim_cb, false);
+#ifdef EF_ENV_USING_WEAR_LEVEL
+        /* collect the cold ENV sector when no dirty sector */
+        if (victim.addr == FAILED_ADDR) {
+            victim.addr = wear_level_check();
+        }
+#endif
+        if (victim.addr == FAILED_ADDR) {
+            return false;
+        }
+        gc_addr = victim.addr;
+    }
+    read_sector_meta_data(gc_addr, &sector, false);
+    if (sector.status.dirty == SECTOR_DIRTY_TRUE) {
+        uint8_t status_table[DIRTY_STATUS_TABLE_SIZE];
+        /* change the sector status to GC */
+        write_status(gc_addr + SECTOR_DIRTY_OFFSET, status_table, SECTOR_DIRTY_STATUS_NUM, SECTOR_DIRTY_GC);
+    }
+    /* search the ENV after the last moved ENV */
+    env.addr.start = gc_step_env_addr;
+    if (env.addr.start != FAILED_ADDR) {
+        read_env(&env);
+    }
+    while ((env.addr.start = get_next_env_addr(&sector, &env)) != FAILED_ADDR) {
+        read_env(&env);
+        if (env.crc_is_ok && (env.status == ENV_WRITE || env.status == ENV_PRE_DELETE)) {
+            if (move_env(&env) != EF_NO_ERR) {
+                EF_DEBUG("Moved the ENV (%.*s) for incremental GC failed. It's collected on next ENV set.\n",
+                        env.name_len, env.name);
+                return false;
+            }
+            gc_step_env_addr = env.addr.start;
+            *moved = true;
+            return true;
+        }
+    }
+    /* all of the ENV are moved */
+    format_collected_sector(&sector);
+    gc_step_env_addr = FAILED_ADDR;
+    EF_DEBUG("Collect a sector @0x%08X by incremental GC\n", sector.addr);
+
+    return true;
+}
+
+static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t align_remain;
+
+#if (EF_WRITE_GRAN / 8 > 0)
+    uint8_t align_data[EF_WRITE_GRAN / 8];
+    size_t align_data_size = sizeof(align_data);
+#else
+    /* For compatibility with C89 */
+    uint8_t align_data_u8, *align_data = &align_data_u8;
+    size_t align_data_size = 1;
+#endif
+
+    memset(align_data, 0xFF, align_data_size);
+    align_remain = EF_WG_ALIGN_DOWN(size);//use align_remain temporary to save aligned size.
+
+    if(align_remain > 0){//it may be 0 in this function.
+        result = ef_port_write(addr, buf, align_remain);
+    }
+
+    align_remain = size - align_remain;
     if (result == EF_NO_ERR && align_remain) {
         memcpy(align_data, (uint8_t *)buf + EF_WG_ALIGN_DOWN(size), align_remain);
         result = ef_port_write(addr + EF_WG_ALIGN_DOWN(size), (uint32_t *) align_data, align_data_size);
@@ -1302,6 +2485,30 @@ static EfErrCode align_write(uint32_t addr, const uint32_t *buf, size_t size)
     return result;
 }
 
+/*
+ * calculate the ENV CRC32 (header.name_len + header.value_len + name + value), the name and value are aligned by 0xFF
+ */
+static uint32_t calc_env_crc32(env_hdr_data_t env_hdr, const char *key, const void *value)
+{
+    uint8_t ff = 0xFF;
+    size_t align_remain;
+    uint32_t crc32;
+
+    crc32 = ef_calc_crc32(0, &env_hdr->name_len, ENV_HDR_DATA_SIZE - ENV_NAME_LEN_OFFSET);
+    crc32 = ef_calc_crc32(crc32, key, env_hdr->name_len);
+    align_remain = EF_WG_ALIGN(env_hdr->name_len) - env_hdr->name_len;
+    while (align_remain--) {
+        crc32 = ef_calc_crc32(crc32, &ff, 1);
+    }
+    crc32 = ef_calc_crc32(crc32, value, env_hdr->value_len);
+    align_remain = EF_WG_ALIGN(env_hdr->value_len) - env_hdr->value_len;
+    while (align_remain--) {
+        crc32 = ef_calc_crc32(crc32, &ff, 1);
+    }
+
+    return crc32;
+}
+
 static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, const void *value, size_t len)
 {
     EfErrCode result = EF_NO_ERR;
@@ -1320,31 +2527,20 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
     env_hdr.value_len = len;
     env_hdr.len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr.name_len) + EF_WG_ALIGN(env_hdr.value_len);
 
-    if (env_hdr.len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
+    /* the ENV which is larger than one sector is saved on the combined sector */
+    if (env_hdr.len > (SECTOR_NUM - EF_GC_EMPTY_SEC_THRESHOLD) * SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
         EF_INFO("Error: The ENV size is too big\n");
         return EF_ENV_FULL;
     }
 
     if (env_addr != FAILED_ADDR || (env_addr = new_env(sector, env_hdr.len)) != FAILED_ADDR) {
-        size_t align_remain;
         /* update the sector status */
         if (result == EF_NO_ERR) {
             result = update_sec_status(sector, env_hdr.len, &is_full);
         }
         if (result == EF_NO_ERR) {
-            uint8_t ff = 0xFF;
             /* start calculate CRC32 */
-            env_hdr.crc32 = ef_calc_crc32(0, &env_hdr.name_len, ENV_HDR_DATA_SIZE - ENV_NAME_LEN_OFFSET);
-            env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, key, env_hdr.name_len);
-            align_remain = EF_WG_ALIGN(env_hdr.name_len) - env_hdr.name_len;
-            while (align_remain--) {
-                env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, &ff, 1);
-            }
-            env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, value, env_hdr.value_len);
-            align_remain = EF_WG_ALIGN(env_hdr.value_len) - env_hdr.value_len;
-            while (align_remain--) {
-                env_hdr.crc32 = ef_calc_crc32(env_hdr.crc32, &ff, 1);
-            }
+            env_hdr.crc32 = calc_env_crc32(&env_hdr, key, value);
             /* write ENV header data */
             result = write_env_hdr(env_addr, &env_hdr);
 
@@ -1360,6 +2556,12 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
             }
             update_env_cache(key, env_hdr.name_len, env_addr);
 #endif /* EF_ENV_USING_CACHE */
+#ifdef EF_ENV_USING_INDEX
+            add_env_index(key, env_hdr.name_len, env_addr);
+#endif
+#ifdef EF_ENV_USING_BLOOM
+            env_bloom_bits(key, env_hdr.name_len, true);
+#endif
         }
         /* write value */
         if (result == EF_NO_ERR) {
@@ -1370,6 +2572,10 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
         if (result == EF_NO_ERR) {
             result = write_status(env_addr, env_hdr.status_table, ENV_STATUS_NUM, ENV_WRITE);
         }
+        if (result == EF_NO_ERR) {
+            update_sector_stat(env_addr, env_hdr.len, true);
+            env_user_write_size += env_hdr.len;
+        }
         /* trigger GC collect when current sector is full */
         if (result == EF_NO_ERR && is_full) {
             EF_DEBUG("Trigger a GC check after created ENV.\n");
@@ -1382,6 +2588,220 @@ static EfErrCode create_env_blob(sector_meta_data_t sector, const char *key, con
     return result;
 }
 
+#ifdef EF_ENV_USING_TXN
+/*
+ * Write the whole transaction ENV node in PRE_WRITE status, the small ENV is written by one burst. Then the status is
+ * changed to the final status when it's not PRE_WRITE, so the torn ENV is always found by recovery.
+ */
+static EfErrCode write_txn_env(uint32_t addr, const char *key, const void *value, size_t len, env_status_t status)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct env_hdr_data env_hdr;
+    uint32_t buf[EF_SCAN_BUF_SIZE / sizeof(uint32_t)];
+    uint8_t *buf8 = (uint8_t *) buf;
+
+    memset(&env_hdr, 0xFF, sizeof(struct env_hdr_data));
+    set_status(env_hdr.status_table, ENV_STATUS_NUM, ENV_PRE_WRITE);
+    env_hdr.magic = ENV_MAGIC_WORD;
+    env_hdr.name_len = strlen(key);
+    env_hdr.value_len = len;
+    env_hdr.len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr.name_len) + EF_WG_ALIGN(env_hdr.value_len);
+    env_hdr.crc32 = calc_env_crc32(&env_hdr, key, value);
+
+#ifdef EF_ENV_USING_CHECKPOINT
+    checkpoint_stale();
+#endif
+    if (env_hdr.len <= sizeof(buf)) {
+        memset(buf, 0xFF, sizeof(buf));
+        memcpy(buf8, &env_hdr, sizeof(struct env_hdr_data));
+        memcpy(buf8 + ENV_HDR_DATA_SIZE, key, env_hdr.name_len);
+        memcpy(buf8 + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr.name_len), value, env_hdr.value_len);
+        result = ef_port_write(addr, buf, env_hdr.len);
+    } else {
+        result = ef_port_write(addr, (uint32_t *) &env_hdr, sizeof(struct env_hdr_data));
+        if (result == EF_NO_ERR) {
+            result = align_write(addr + ENV_HDR_DATA_SIZE, (uint32_t *) key, env_hdr.name_len);
+        }
+        if (result == EF_NO_ERR) {
+            result = align_write(addr + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env_hdr.name_len), value, env_hdr.value_len);
+        }
+    }
+    if (result == EF_NO_ERR && status != ENV_PRE_WRITE) {
+        result = write_status(addr, env_hdr.status_table, ENV_STATUS_NUM, status);
+    }
+    /* the transaction ENV is live after committed, the marker is dead after finished */
+    if (result == EF_NO_ERR) {
+        update_sector_stat(addr, env_hdr.len, true);
+        if (status == ENV_PRE_WRITE) {
+            env_user_write_size += env_hdr.len;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Finish the committed transaction by the marker ENV. The old ENV are deleted, then the new ENV status is changed
+ * from PRE_WRITE to WRITE. It's also used for recovery, so the finished ENV are skipped.
+ */
+static EfErrCode txn_finish(env_node_obj_t marker)
+{
+    EfErrCode result = EF_NO_ERR;
+    uint8_t status_table[ENV_STATUS_TABLE_SIZE];
+    struct env_node_obj env, old_env;
+    struct txn_data txn;
+    char name[EF_ENV_NAME_MAX + 1];
+    size_t i;
+
+    ef_port_read(marker->addr.value, (uint32_t *) &txn, sizeof(struct txn_data));
+    env.addr.start = txn.env_addr;
+    for (i = 0; i < txn.env_num && result == EF_NO_ERR; i++, env.addr.start += env.len) {
+        read_env(&env);
+        if (!env.crc_is_ok) {
+            EF_INFO("Error: The ENV (@0x%08X) of transaction CRC32 check failed!\n", env.addr.start);
+            result = EF_READ_ERR;
+            break;
+        }
+        if (env.status != ENV_PRE_WRITE) {
+            continue;
+        }
+        memcpy(name, env.name, env.name_len);
+        name[env.name_len] = '\0';
+        /* delete the old ENV */
+        if (find_env(name, &old_env)) {
+            result = del_env(name, &old_env, true);
+        }
+        /* the new ENV is valid now */
+        if (result == EF_NO_ERR) {
+            result = write_status(env.addr.start, status_table, ENV_STATUS_NUM, ENV_WRITE);
+        }
+        if (result == EF_NO_ERR) {
+#ifdef EF_ENV_USING_CACHE
+            update_env_cache(env.name, env.name_len, env.addr.start);
+#endif
+#ifdef EF_ENV_USING_INDEX
+            add_env_index(env.name, env.name_len, env.addr.start);
+#endif
+#ifdef EF_ENV_USING_BLOOM
+            env_bloom_bits(env.name, env.name_len, true);
+#endif
+        }
+    }
+    /* the transaction is finished */
+    if (result == EF_NO_ERR) {
+        result = del_env(NULL, marker, true);
+    }
+
+    return result;
+}
+
+/*
+ * Write all of the transaction ENV continuously on one sector in PRE_WRITE status, then commit them by the marker ENV.
+ */
+static EfErrCode txn_commit(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct sector_meta_data sector;
+    struct env_node_obj marker;
+    struct txn_data txn;
+    size_t i, txn_len;
+    uint32_t env_addr;
+    bool is_full = false;
+
+    /* the ENV and marker total length */
+    txn_len = ENV_HDR_DATA_SIZE + EF_WG_ALIGN(strlen(TXN_ENV_NAME)) + EF_WG_ALIGN(sizeof(struct txn_data));
+    for (i = 0; i < txn_env_num; i++) {
+        txn_len += ENV_HDR_DATA_SIZE + EF_WG_ALIGN(strlen(txn_env_table[i].key))
+                + EF_WG_ALIGN(txn_env_table[i].value_len);
+    }
+    if (txn_len > SECTOR_SIZE - SECTOR_HDR_DATA_SIZE) {
+        EF_INFO("Error: The ENV transaction size is too big\n");
+        return EF_ENV_FULL;
+    }
+
+    if ((env_addr = new_env(&sector, txn_len)) == FAILED_ADDR) {
+        return EF_ENV_FULL;
+    }
+    result = update_sec_status(&sector, txn_len, &is_full);
+    /* write the ENV, they are not valid until the marker is written */
+    txn.env_addr = env_addr;
+    txn.env_num = txn_env_num;
+    for (i = 0; i < txn_env_num && result == EF_NO_ERR; i++) {
+        result = write_txn_env(env_addr, txn_env_table[i].key, txn_env_table[i].value, txn_env_table[i].value_len,
+                ENV_PRE_WRITE);
+        env_addr += ENV_HDR_DATA_SIZE + EF_WG_ALIGN(strlen(txn_env_table[i].key))
+                + EF_WG_ALIGN(txn_env_table[i].value_len);
+    }
+    /* commit the transaction by the marker */
+    if (result == EF_NO_ERR) {
+        result = write_txn_env(env_addr, TXN_ENV_NAME, &txn, sizeof(struct txn_data), ENV_WRITE);
+    }
+    if (result == EF_NO_ERR) {
+#ifdef EF_ENV_USING_CACHE
+        if (!is_full) {
+            update_sector_cache(sector.addr, txn.env_addr + txn_len);
+        }
+#endif /* EF_ENV_USING_CACHE */
+        marker.addr.start = env_addr;
+        read_env(&marker);
+        result = txn_finish(&marker);
+    }
+    /* trigger GC collect when current sector is full */
+    if (result == EF_NO_ERR && is_full) {
+        EF_DEBUG("Trigger a GC check after committed ENV transaction.\n");
+        gc_request = true;
+    }
+    if (gc_request) {
+        gc_collect();
+    }
+
+    return result;
+}
+
+/*
+ * Finish the committed transaction which is interrupted by power failure. The transaction ENV are continuous,
+ * so the marker is found behind the prepare written ENV.
+ *
+ * @return true: the transaction is committed
+ */
+static bool txn_recovery(env_node_obj_t env)
+{
+    struct env_node_obj marker;
+    struct env_hdr_data env_hdr;
+    struct txn_data txn;
+    uint32_t sec_end = EF_ALIGN_DOWN(env->addr.start, SECTOR_SIZE) + SECTOR_SIZE;
+
+    if (!env->crc_is_ok) {
+        return false;
+    }
+    for (marker.addr.start = env->addr.start + env->len; marker.addr.start + ENV_HDR_DATA_SIZE <= sec_end;
+            marker.addr.start += marker.len) {
+        ef_port_read(marker.addr.start, (uint32_t *) &env_hdr, sizeof(struct env_hdr_data));
+        if (env_hdr.magic != ENV_MAGIC_WORD || read_env(&marker) != EF_NO_ERR) {
+            return false;
+        }
+        if (marker.status != ENV_PRE_WRITE) {
+            break;
+        }
+    }
+    if (marker.addr.start + ENV_HDR_DATA_SIZE > sec_end || marker.status != ENV_WRITE
+            || marker.name_len != strlen(TXN_ENV_NAME) || strncmp(marker.name, TXN_ENV_NAME, marker.name_len)) {
+        return false;
+    }
+    ef_port_read(marker.addr.value, (uint32_t *) &txn, sizeof(struct txn_data));
+    if (txn.env_addr > env->addr.start) {
+        return false;
+    }
+
+    EF_INFO("Found an ENV transaction which has committed. Now will finish it.\n");
+    if (txn_finish(&marker) == EF_NO_ERR) {
+        EF_DEBUG("Recovery the ENV transaction successful.\n");
+    }
+
+    return true;
+}
+#endif /* EF_ENV_USING_TXN */
+
 /**
  * Delete an ENV.
  *
@@ -1505,6 +2925,80 @@ EfErrCode ef_set_env(const char *key, const char *value)
     return ef_set_env_blob(key, value, strlen(value));
 }
 
+/*
+ * Set the fixed length ENV value. It's NOT written when the value on flash is same, so the unchanged value costs no
+ * flash program and GC.
+ */
+static EfErrCode set_env_fixed(const char *key, const void *value, size_t len)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct env_node_obj env;
+    uint32_t buf[2];
+    bool is_same = false;
+
+    EF_ASSERT(len <= sizeof(buf));
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    if (find_env(key, &env) && env.value_len == len) {
+        ef_port_read(env.addr.value, buf, len);
+        is_same = !memcmp(buf, value, len);
+    }
+    if (!is_same) {
+        result = set_env(key, value, len);
+    }
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Set an uint32_t ENV. The value is saved as 4 bytes binary (CPU byte order), it's NOT written when it's unchanged.
+ *
+ * @param key ENV name
+ * @param value ENV value
+ *
+ * @return result
+ */
+EfErrCode ef_set_env_u32(const char *key, uint32_t value)
+{
+    return set_env_fixed(key, &value, sizeof(value));
+}
+
+/**
+ * The same to ef_set_env_u32 for the int32_t ENV value.
+ */
+EfErrCode ef_set_env_i32(const char *key, int32_t value)
+{
+    return set_env_fixed(key, &value, sizeof(value));
+}
+
+/**
+ * The same to ef_set_env_u32 for the uint64_t ENV value.
+ */
+EfErrCode ef_set_env_u64(const char *key, uint64_t value)
+{
+    return set_env_fixed(key, &value, sizeof(value));
+}
+
+/**
+ * The same to ef_set_env_u32 for the bool ENV value, it's saved as 1 byte.
+ */
+EfErrCode ef_set_env_bool(const char *key, bool value)
+{
+    uint8_t byte = value ? 1 : 0;
+
+    return set_env_fixed(key, &byte, sizeof(byte));
+}
+
 /**
  * The same to ef_set_env on this mode.
  * It's compatibility with older versions (less then V4.0).
@@ -1516,24 +3010,294 @@ EfErrCode ef_set_env(const char *key, const char *value)
  *
  * @return result
  */
-EfErrCode ef_set_and_save_env(const char *key, const char *value)
+EfErrCode ef_set_and_save_env(const char *key, const char *value)
+{
+    return ef_set_env_blob(key, value, strlen(value));
+}
+
+/**
+ * Save ENV to flash.
+ *
+ * @note this function is DEPRECATED
+ */
+EfErrCode ef_save_env(void)
+{
+    /* do nothing not cur mode */
+    return EF_NO_ERR;
+}
+
+/**
+ * Do one step of the incremental GC. It moves the ENV out of the full dirty sectors and formats them, so the GC
+ * is rarely run on ENV set. It should be called on the idle loop.
+ *
+ * @note The ENV is locked for every moved ENV, not for the whole step.
+ *
+ * @param env_num the max moved ENV number of this step, 0: not limited
+ * @param time_us the max time (microsecond) of this step, 0: not limited. It's checked after every moved ENV, so
+ *        the step may be longer by one ENV move or one sector erase.
+ *
+ * @return true: the GC has more work, false: nothing to collect or the space is not enough for moving ENV
+ */
+bool ef_env_gc_step(size_t env_num, uint32_t time_us)
+{
+    uint32_t start_time = ef_port_get_us();
+    size_t moved_num = 0;
+    bool more, moved;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return false;
+    }
+
+    do {
+        /* lock the ENV cache */
+        ef_port_env_lock();
+
+        more = gc_step(&moved);
+
+        /* unlock the ENV cache */
+        ef_port_env_unlock();
+
+        if (moved) {
+            moved_num++;
+        }
+        /* the step is finished after a sector is formatted */
+    } while (more && moved && (env_num == 0 || moved_num < env_num)
+            && (time_us == 0 || ef_port_get_us() - start_time < time_us));
+
+    return more;
+}
+
+#ifdef EF_ENV_USING_TXN
+/**
+ * Begin an ENV transaction. The ENV which are set by ef_txn_set are saved together on ef_txn_commit.
+ * The uncommitted transaction is discarded.
+ *
+ * @return result
+ */
+EfErrCode ef_txn_begin(void)
+{
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    txn_env_num = 0;
+    txn_is_began = true;
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Set a blob ENV on the current transaction. The ENV is saved on ef_txn_commit.
+ *
+ * @note The key and value buffer must be kept until ef_txn_commit.
+ *
+ * @param key ENV name
+ * @param value_buf ENV value, it can't be NULL
+ * @param buf_len ENV value length
+ *
+ * @return result
+ */
+EfErrCode ef_txn_set(const char *key, const void *value_buf, size_t buf_len)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t i;
+
+    EF_ASSERT(key);
+    EF_ASSERT(value_buf);
+
+    if (strlen(key) > EF_ENV_NAME_MAX || !strcmp(key, TXN_ENV_NAME)) {
+        EF_INFO("Error: The ENV name (%s) can't be set on transaction\n", key);
+        return EF_ENV_NAME_ERR;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    if (!txn_is_began) {
+        EF_INFO("Error: The ENV transaction isn't began.\n");
+        result = EF_WRITE_ERR;
+        goto __exit;
+    }
+    /* the same ENV is replaced */
+    for (i = 0; i < txn_env_num && strcmp(txn_env_table[i].key, key); i++);
+    if (i == EF_TXN_ENV_MAX) {
+        EF_INFO("Error: The ENV transaction is more than %d ENV.\n", EF_TXN_ENV_MAX);
+        result = EF_ENV_FULL;
+        goto __exit;
+    }
+    txn_env_table[i].key = key;
+    txn_env_table[i].value = value_buf;
+    txn_env_table[i].value_len = buf_len;
+    if (i == txn_env_num) {
+        txn_env_num++;
+    }
+
+__exit:
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Commit the current transaction. All of the ENV are saved, or none of them are saved after power failure.
+ *
+ * @return result
+ */
+EfErrCode ef_txn_commit(void)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    if (!txn_is_began) {
+        EF_INFO("Error: The ENV transaction isn't began.\n");
+        result = EF_WRITE_ERR;
+    } else if (txn_env_num > 0) {
+        result = txn_commit();
+    }
+    txn_is_began = false;
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Discard the current transaction.
+ */
+void ef_txn_abort(void)
 {
-    return ef_set_env_blob(key, value, strlen(value));
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    txn_is_began = false;
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
 }
+#endif /* EF_ENV_USING_TXN */
 
-/**
- * Save ENV to flash.
- *
- * @note this function is DEPRECATED
+#ifdef EF_ENV_DEFAULT_IMAGE_ADDR
+/*
+ * Restore the ENV area by copying the default ENV image (built by tools/ef_image). The image is checked by the CRC32
+ * on its trailer before the ENV area is erased. The sector erase counts on flash are kept, so the counts on the image
+ * headers are replaced by them.
  */
-EfErrCode ef_save_env(void)
+static EfErrCode restore_default_image(void)
 {
-    /* do nothing not cur mode */
-    return EF_NO_ERR;
+    EfErrCode result = EF_NO_ERR;
+    struct sector_hdr_data sec_hdr;
+    struct ef_env_image_trailer trailer;
+    struct env_node_obj env;
+    uint32_t erase_count[SECTOR_NUM], buf[32], sec_num, offset, size, i, j, crc = 0;
+
+    /* check the image CRC32 */
+    for (offset = 0; offset < ENV_AREA_SIZE; offset += sizeof(buf)) {
+        ef_port_read(EF_ENV_DEFAULT_IMAGE_ADDR + offset, buf, sizeof(buf));
+        crc = ef_calc_crc32(crc, buf, sizeof(buf));
+    }
+    ef_port_read(EF_ENV_DEFAULT_IMAGE_ADDR + ENV_AREA_SIZE, (uint32_t *) &trailer, sizeof(struct ef_env_image_trailer));
+    if (trailer.magic != EF_ENV_IMAGE_MAGIC_WORD || trailer.crc32 != crc) {
+        EF_INFO("Warning: The default ENV image CRC32 check failed. Create the default ENV.\n");
+        return EF_READ_ERR;
+    }
+    /* check all sector headers of the image, the combined sectors have no header */
+    for (i = 0; i < SECTOR_NUM; i += sec_num) {
+        ef_port_read(EF_ENV_DEFAULT_IMAGE_ADDR + i * SECTOR_SIZE, (uint32_t *) &sec_hdr, sizeof(struct sector_hdr_data));
+        if (sec_hdr.magic != SECTOR_MAGIC_WORD) {
+            EF_INFO("Warning: The default ENV image is invalid. Create the default ENV.\n");
+            return EF_READ_ERR;
+        }
+        sec_num = sec_hdr.combined == SECTOR_NOT_COMBINED ? 1 : sec_hdr.combined;
+        if (sec_num == 0 || sec_num > SECTOR_NUM - i) {
+            EF_INFO("Warning: The default ENV image is invalid. Create the default ENV.\n");
+            return EF_READ_ERR;
+        }
+    }
+    /* the new erase count is the sector count add 1, it must be got before the ENV area is erased */
+    for (i = 0; i < SECTOR_NUM; i++) {
+        erase_count[i] = get_sector_erase_count(env_start_addr + i * SECTOR_SIZE);
+        if (erase_count[i] < 0xFFFFFFFE) {
+            erase_count[i]++;
+        }
+    }
+#ifdef EF_ENV_USING_CHECKPOINT
+    checkpoint_stale();
+#endif
+    result = ef_port_erase(env_start_addr, ENV_AREA_SIZE);
+    if (result != EF_NO_ERR) {
+        return result;
+    }
+    for (i = 0; i < SECTOR_NUM; i += sec_num) {
+        ef_port_read(EF_ENV_DEFAULT_IMAGE_ADDR + i * SECTOR_SIZE, (uint32_t *) &sec_hdr, sizeof(struct sector_hdr_data));
+        sec_num = sec_hdr.combined == SECTOR_NOT_COMBINED ? 1 : sec_hdr.combined;
+        /* the combined sector uses the most worn sector count of the combined area */
+        sec_hdr.erase_count = 0;
+        for (j = i; j < i + sec_num; j++) {
+            if (erase_count[j] > sec_hdr.erase_count) {
+                sec_hdr.erase_count = erase_count[j];
+            }
+        }
+        result = ef_port_write(env_start_addr + i * SECTOR_SIZE, (uint32_t *) &sec_hdr, sizeof(struct sector_hdr_data));
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+        /* copy the ENV data, the erased (0xFF) data is skipped */
+        for (offset = i * SECTOR_SIZE + SECTOR_HDR_DATA_SIZE; offset < (i + sec_num) * SECTOR_SIZE; offset += size) {
+            size = (i + sec_num) * SECTOR_SIZE - offset;
+            if (size > sizeof(buf)) {
+                size = sizeof(buf);
+            }
+            ef_port_read(EF_ENV_DEFAULT_IMAGE_ADDR + offset, buf, size);
+            for (j = 0; j < size && ((uint8_t *) buf)[j] == 0xFF; j++);
+            if (j < size) {
+                result = ef_port_write(env_start_addr + offset, buf, size);
+                if (result != EF_NO_ERR) {
+                    return result;
+                }
+            }
+        }
+    }
+
+#ifdef EF_ENV_USING_CACHE
+    for (i = 0; i < EF_SECTOR_CACHE_TABLE_SIZE; i++) {
+        sector_cache_table[i].addr = FAILED_ADDR;
+    }
+    for (i = 0; i < EF_ENV_CACHE_TABLE_SIZE; i++) {
+        env_cache_table[i].addr = FAILED_ADDR;
+    }
+#endif /* EF_ENV_USING_CACHE */
+    gc_step_env_addr = FAILED_ADDR;
+    /* the ENV on the image are not created by this library, so build the lookup and GC statistics for them */
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+    reset_env_lookup();
+#endif
+    reset_sector_stat();
+    env_iterator(&env, NULL, NULL, build_sector_stat_cb);
+
+    return result;
 }
+#endif /* EF_ENV_DEFAULT_IMAGE_ADDR */
 
 /**
- * ENV set default.
+ * ENV set default. The default ENV image is copied when EF_ENV_DEFAULT_IMAGE_ADDR is defined, otherwise (or the image
+ * is invalid) the default ENV set is created one by one.
  *
  * @return result
  */
@@ -1548,6 +3312,17 @@ EfErrCode ef_env_set_default(void)
 
     /* lock the ENV cache */
     ef_port_env_lock();
+#ifdef EF_ENV_USING_INDEX
+    reset_env_index();
+#endif
+#ifdef EF_ENV_USING_BLOOM
+    memset(env_bloom, 0, sizeof(env_bloom));
+#endif
+#ifdef EF_ENV_DEFAULT_IMAGE_ADDR
+    if (restore_default_image() == EF_NO_ERR) {
+        goto __exit;
+    }
+#endif
     /* format all sectors */
     for (addr = env_start_addr; addr < env_start_addr + ENV_AREA_SIZE; addr += SECTOR_SIZE) {
         result = format_sector(addr, SECTOR_NOT_COMBINED);
@@ -1652,6 +3427,86 @@ void ef_print_env(void)
     ef_port_env_unlock();
 }
 
+/**
+ * Print the erase count of all ENV sectors. It's used for the wear leveling diagnostic.
+ */
+void ef_print_env_wear(void)
+{
+    uint32_t sec_addr, erase_count, min_count = FAILED_ADDR, max_count = 0, total_count = 0, sec_num = 0;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    for (sec_addr = env_start_addr; sec_addr < env_start_addr + ENV_AREA_SIZE; sec_addr += SECTOR_SIZE) {
+        erase_count = get_sector_erase_count(sec_addr);
+        ef_print("sector @0x%08lX: erase count %lu\n", sec_addr, erase_count);
+        if (erase_count < min_count) {
+            min_count = erase_count;
+        }
+        if (erase_count > max_count) {
+            max_count = erase_count;
+        }
+        total_count += erase_count;
+        sec_num++;
+    }
+    ef_print("\nerase count: min %lu, max %lu, average %lu.\n", min_count, max_count, total_count / sec_num);
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+}
+
+/**
+ * Set the GC victim sector selection policy.
+ *
+ * @param policy GC policy @see EfGcPolicy
+ */
+void ef_env_set_gc_policy(EfGcPolicy policy)
+{
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    gc_policy = policy;
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+}
+
+/**
+ * Print the GC statistics of all ENV sectors and the write amplification since loading.
+ */
+void ef_print_env_gc(void)
+{
+    static const char * const policy_name[] = { "greedy", "age-weighted" };
+    uint32_t sec_addr, total_size;
+    sector_stat_t stat;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    for (sec_addr = env_start_addr; sec_addr < env_start_addr + ENV_AREA_SIZE; sec_addr += SECTOR_SIZE) {
+        stat = get_sector_stat(sec_addr);
+        ef_print("sector @0x%08lX: live %lu, dead %lu bytes.\n", sec_addr, stat->live, stat->dead);
+    }
+    total_size = env_user_write_size + env_gc_write_size;
+    ef_print("\nGC policy: %s, user write %lu bytes, GC write %lu bytes, write amplification %lu.%02lu.\n",
+            policy_name[gc_policy], env_user_write_size, env_gc_write_size,
+            env_user_write_size ? total_size / env_user_write_size : 0,
+            env_user_write_size ? (uint32_t) ((uint64_t) total_size * 100 / env_user_write_size % 100) : 0);
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+}
+
 #ifdef EF_ENV_AUTO_UPDATE
 /*
  * Auto update ENV to latest default when current EF_ENV_VER_NUM is changed.
@@ -1691,6 +3546,285 @@ static void env_auto_update(void)
 }
 #endif /* EF_ENV_AUTO_UPDATE */
 
+#ifdef EF_ENV_USING_CHECKPOINT
+/*
+ * Make the valid checkpoint stale, it must be called before the ENV is changed.
+ */
+static void checkpoint_stale(void)
+{
+    uint8_t status_table[CHECKPOINT_STATUS_TABLE_SIZE];
+    uint32_t addr = checkpoint_addr;
+
+    if (addr != FAILED_ADDR) {
+        /* it's cleared first, so the status writing will not make it stale again */
+        checkpoint_addr = FAILED_ADDR;
+        write_status(addr, status_table, CHECKPOINT_STATUS_NUM, CHECKPOINT_STALE);
+    }
+}
+
+/*
+ * Find the last checkpoint on the checkpoint sector. The checkpoints are written in order, so the first empty one is
+ * found by binary search.
+ */
+static void find_checkpoint(void)
+{
+    struct env_checkpoint checkpoint;
+    uint32_t low = 0, high = SECTOR_SIZE / CHECKPOINT_SIZE, mid;
+
+    checkpoint_addr = FAILED_ADDR;
+    while (low < high) {
+        mid = (low + high) / 2;
+        ef_port_read(EF_ENV_CHECKPOINT_ADDR + mid * CHECKPOINT_SIZE + CHECKPOINT_MAGIC_OFFSET, &checkpoint.magic,
+                sizeof(uint32_t));
+        if (checkpoint.magic == 0xFFFFFFFF) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    checkpoint_next_addr = EF_ENV_CHECKPOINT_ADDR + low * CHECKPOINT_SIZE;
+    if (low == 0) {
+        return;
+    }
+    ef_port_read(checkpoint_next_addr - CHECKPOINT_SIZE, (uint32_t *) &checkpoint, sizeof(struct env_checkpoint));
+    if (checkpoint.magic == CHECKPOINT_MAGIC_WORD && checkpoint.crc32 == ef_calc_crc32(0, &checkpoint.seq,
+            sizeof(struct env_checkpoint) - CHECKPOINT_SEQ_OFFSET)) {
+        checkpoint_seq = checkpoint.seq;
+        if (get_status(checkpoint.status_table, CHECKPOINT_STATUS_NUM) == CHECKPOINT_VALID
+                && checkpoint.sector_num == SECTOR_NUM) {
+            checkpoint_addr = checkpoint_next_addr - CHECKPOINT_SIZE;
+        }
+    }
+}
+
+/*
+ * Check every ENV of the sector on flash, the sector cache is not used. The written and deleted ENV must pass the CRC
+ * check, and the prepared ENV is not clean. The empty ENV address of the using sector is got by this check.
+ */
+static EfErrCode check_sector_env(sector_meta_data_t sector)
+{
+    struct env_node_obj env;
+
+    sector->empty_env = sector->addr + SECTOR_HDR_DATA_SIZE;
+    env.addr.start = FAILED_ADDR;
+    while ((env.addr.start = get_next_env_addr(sector, &env)) != FAILED_ADDR) {
+        read_env(&env);
+        if (env.status == ENV_PRE_WRITE || env.status == ENV_PRE_DELETE
+                || ((env.status == ENV_WRITE || env.status == ENV_DELETED) && !env.crc_is_ok)) {
+            EF_DEBUG("Error: The ENV (@0x%08X) is not clean for the checkpoint.\n", env.addr.start);
+            return EF_READ_ERR;
+        }
+        sector->empty_env = env.addr.start + env.len;
+    }
+    if (sector->status.store == SECTOR_STORE_USING) {
+        sector->empty_env = continue_ff_addr(sector->empty_env, sector->addr + SECTOR_SIZE);
+#ifdef EF_ENV_USING_CACHE
+        update_sector_cache(sector->addr, sector->empty_env);
+#endif
+    }
+
+    return EF_NO_ERR;
+}
+
+/*
+ * Save the checkpoint of all sectors. The ENV must be clean, it has no writing, deleting and collecting ENV.
+ */
+static EfErrCode save_checkpoint(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct env_checkpoint checkpoint;
+    struct sector_meta_data sector;
+    uint32_t sec_addr, sec_num, i;
+
+    memset(&checkpoint, 0xFF, sizeof(struct env_checkpoint));
+    sector.addr = FAILED_ADDR;
+    while ((sec_addr = get_next_sector_addr(&sector)) != FAILED_ADDR) {
+        /* the checkpoint is not saved when any ENV check is failed */
+        if (read_sector_meta_data(sec_addr, &sector, false) != EF_NO_ERR || sector.status.dirty == SECTOR_DIRTY_GC
+                || check_sector_env(&sector) != EF_NO_ERR) {
+            return EF_READ_ERR;
+        }
+        i = (sec_addr - env_start_addr) / SECTOR_SIZE;
+        sec_num = sector.combined == SECTOR_NOT_COMBINED ? 1 : sector.combined;
+        checkpoint.sector[i].erase_count = sector.erase_count;
+        if (sector.status.store == SECTOR_STORE_USING) {
+            checkpoint.sector[i].empty_env = sector.empty_env;
+        } else if (sector.status.store == SECTOR_STORE_FULL) {
+            checkpoint.sector[i].empty_env = sec_addr + sec_num * SECTOR_SIZE;
+        } else {
+            checkpoint.sector[i].empty_env = sec_addr + SECTOR_HDR_DATA_SIZE;
+        }
+    }
+    checkpoint.magic = CHECKPOINT_MAGIC_WORD;
+    checkpoint.seq = checkpoint_seq + 1;
+    checkpoint.sector_num = SECTOR_NUM;
+    checkpoint.crc32 = ef_calc_crc32(0, &checkpoint.seq, sizeof(struct env_checkpoint) - CHECKPOINT_SEQ_OFFSET);
+
+    /* the checkpoint sector is erased when it's full */
+    if (checkpoint_next_addr + CHECKPOINT_SIZE > EF_ENV_CHECKPOINT_ADDR + SECTOR_SIZE) {
+        result = ef_port_erase(EF_ENV_CHECKPOINT_ADDR, SECTOR_SIZE);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+        checkpoint_next_addr = EF_ENV_CHECKPOINT_ADDR;
+    }
+    /* the status is written at last, so the checkpoint is valid only when it's written finish */
+    result = ef_port_write(checkpoint_next_addr + CHECKPOINT_MAGIC_OFFSET, &checkpoint.magic,
+            sizeof(struct env_checkpoint) - CHECKPOINT_MAGIC_OFFSET);
+    if (result == EF_NO_ERR) {
+        result = write_status(checkpoint_next_addr, checkpoint.status_table, CHECKPOINT_STATUS_NUM, CHECKPOINT_VALID);
+    }
+    if (result == EF_NO_ERR) {
+        checkpoint_addr = checkpoint_next_addr;
+        checkpoint_seq = checkpoint.seq;
+    }
+    checkpoint_next_addr += CHECKPOINT_SIZE;
+
+    return result;
+}
+
+/*
+ * Load the ENV by the valid checkpoint. The ENV is clean, so only the header and name of every ENV are read by one
+ * read without CRC check, then the ENV index, Bloom filter and GC statistics are built. The ENV length is checked by
+ * the name and value length and by the magic word of the next ENV instead. The empty ENV address of the using sector
+ * is got from the checkpoint.
+ *
+ * @return false: the checkpoint is not same as the flash, so the ENV must be loaded by the full check
+ */
+static bool load_env_by_checkpoint(void)
+{
+    struct env_checkpoint checkpoint;
+    struct sector_meta_data sector;
+    struct env_node_obj env;
+    uint32_t buf[(ENV_HDR_DATA_SIZE + EF_WG_ALIGN(EF_ENV_NAME_MAX) + 3) / 4];
+    env_hdr_data_t env_hdr = (env_hdr_data_t) buf;
+    uint32_t sec_addr, sec_end, end, next, magic, read_size, i;
+
+    if (checkpoint_addr == FAILED_ADDR) {
+        return false;
+    }
+    ef_port_read(checkpoint_addr, (uint32_t *) &checkpoint, sizeof(struct env_checkpoint));
+
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+    reset_env_lookup();
+#endif
+    reset_sector_stat();
+    sector.addr = FAILED_ADDR;
+    while ((sec_addr = get_next_sector_addr(&sector)) != FAILED_ADDR) {
+        i = (sec_addr - env_start_addr) / SECTOR_SIZE;
+        if (read_sector_meta_data(sec_addr, &sector, false) != EF_NO_ERR
+                || sector.erase_count != checkpoint.sector[i].erase_count || sector.status.dirty == SECTOR_DIRTY_GC) {
+            return false;
+        }
+        if (sector.status.store != SECTOR_STORE_USING && sector.status.store != SECTOR_STORE_FULL) {
+            continue;
+        }
+        sec_end = sec_addr + (sector.combined == SECTOR_NOT_COMBINED ? 1 : sector.combined) * SECTOR_SIZE;
+        end = checkpoint.sector[i].empty_env;
+        if (end < sec_addr + SECTOR_HDR_DATA_SIZE || end > sec_end) {
+            return false;
+        }
+        /* the ENV which is written after the checkpoint is on the empty ENV address */
+        if (end + sizeof(uint32_t) <= sec_end) {
+            ef_port_read(end, buf, sizeof(uint32_t));
+            if (buf[0] != 0xFFFFFFFF) {
+                return false;
+            }
+        }
+        env.addr.start = sec_addr + SECTOR_HDR_DATA_SIZE;
+        while (env.addr.start + ENV_HDR_DATA_SIZE <= end) {
+            read_size = sizeof(buf) < end - env.addr.start ? sizeof(buf) : end - env.addr.start;
+            ef_port_read(env.addr.start, buf, read_size);
+            if (env_hdr->magic != ENV_MAGIC_WORD) {
+                /* it's the data of broken ENV, the full check skips it too */
+                env.addr.start = find_next_env_addr(env.addr.start + EF_WG_ALIGN(1), end);
+                if (env.addr.start == FAILED_ADDR) {
+                    break;
+                }
+                continue;
+            }
+            env.status = (env_status_t) get_status(env_hdr->status_table, ENV_STATUS_NUM);
+            env.len = env_hdr->len;
+            if (env.status == ENV_PRE_WRITE || env.status == ENV_PRE_DELETE) {
+                return false;
+            } else if (env.status == ENV_WRITE || env.status == ENV_DELETED) {
+                if (env.len < ENV_HDR_DATA_SIZE || env.len > end - env.addr.start || env_hdr->name_len > EF_ENV_NAME_MAX
+                        || ENV_HDR_DATA_SIZE + env_hdr->name_len > read_size || env.len != ENV_HDR_DATA_SIZE
+                        + EF_WG_ALIGN(env_hdr->name_len) + EF_WG_ALIGN(env_hdr->value_len)) {
+                    return false;
+                }
+                /* the length is not checked by CRC, so the next ENV or the empty space must be behind it. Otherwise
+                 * the wrong length may skip the next ENV, which the full check finds by the magic word. */
+                next = env.addr.start + env.len;
+                if (next + ENV_HDR_DATA_SIZE <= end) {
+                    ef_port_read(next + ENV_MAGIC_OFFSET, &magic, sizeof(uint32_t));
+                    if (magic != ENV_MAGIC_WORD && continue_ff_addr(next, end) != next) {
+                        return false;
+                    }
+                }
+                env.crc_is_ok = true;
+                env.name_len = env_hdr->name_len;
+                env.value_len = env_hdr->value_len;
+                memcpy(env.name, (uint8_t *) buf + ENV_HDR_DATA_SIZE, env.name_len);
+                env.addr.value = env.addr.start + ENV_HDR_DATA_SIZE + EF_WG_ALIGN(env.name_len);
+            } else {
+                /* the error ENV is rare, it's checked like the full check */
+                read_env(&env);
+            }
+            build_sector_stat_cb(&env, NULL, NULL);
+            /* the combined sector only has one ENV */
+            if (sector.combined != SECTOR_NOT_COMBINED) {
+                break;
+            }
+            if (env.crc_is_ok) {
+                env.addr.start += env.len;
+            } else {
+                env.addr.start = find_next_env_addr(env.addr.start + EF_WG_ALIGN(1), end);
+                if (env.addr.start == FAILED_ADDR) {
+                    break;
+                }
+            }
+        }
+#ifdef EF_ENV_USING_CACHE
+        if (sector.status.store == SECTOR_STORE_USING) {
+            update_sector_cache(sec_addr, end);
+        }
+#endif
+    }
+
+    return true;
+}
+
+/**
+ * Save the ENV checkpoint if the ENV is changed since the last checkpoint. The next ENV loading trusts the checkpoint
+ * and skips the CRC check of every ENV, so it should be called when the ENV is idle, e.g. on the idle loop.
+ *
+ * @return result
+ */
+EfErrCode ef_env_checkpoint(void)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("ENV isn't initialize OK.\n");
+        return EF_ENV_INIT_FAILED;
+    }
+
+    /* lock the ENV cache */
+    ef_port_env_lock();
+
+    /* the ENV is not clean when the incremental GC is collecting a sector */
+    if (checkpoint_addr == FAILED_ADDR && gc_step_env_addr == FAILED_ADDR) {
+        result = save_checkpoint();
+    }
+
+    /* unlock the ENV cache */
+    ef_port_env_unlock();
+
+    return result;
+}
+#endif /* EF_ENV_USING_CHECKPOINT */
+
 static bool check_sec_hdr_cb(sector_meta_data_t sector, void *arg1, void *arg2)
 {
     if (!sector->check_ok) {
@@ -1699,6 +3833,15 @@ static bool check_sec_hdr_cb(sector_meta_data_t sector, void *arg1, void *arg2)
         EF_INFO("Warning: Sector header check failed. Format this sector (0x%08x).\n", sector->addr);
         (*failed_count) ++;
         format_sector(sector->addr, SECTOR_NOT_COMBINED);
+    } else if (sector->combined != SECTOR_NOT_COMBINED && sector->status.dirty == SECTOR_DIRTY_FALSE) {
+        uint8_t env_status_table[ENV_STATUS_TABLE_SIZE], dirty_status_table[DIRTY_STATUS_TABLE_SIZE];
+        size_t status;
+        /* the combined sector has no ENV when the power is lost on writing or deleting, so make it dirty for GC */
+        status = read_status(sector->addr + SECTOR_HDR_DATA_SIZE, env_status_table, ENV_STATUS_NUM);
+        if (status != ENV_WRITE && status != ENV_PRE_DELETE) {
+            write_status(sector->addr + SECTOR_DIRTY_OFFSET, dirty_status_table, SECTOR_DIRTY_STATUS_NUM,
+                    SECTOR_DIRTY_TRUE);
+        }
     }
 
     return false;
@@ -1718,22 +3861,39 @@ static bool check_and_recovery_gc_cb(sector_meta_data_t sector, void *arg1, void
 
 static bool check_and_recovery_env_cb(env_node_obj_t env, void *arg1, void *arg2)
 {
+    bool *traversed = arg1;
+    EfErrCode *recovery_result = arg2;
+
+    /* the ENV index, Bloom filter and GC statistics are built on the recovery traversal */
+    build_sector_stat_cb(env, NULL, NULL);
+
     /* recovery the prepare deleted ENV */
     if (env->crc_is_ok && env->status == ENV_PRE_DELETE) {
         EF_INFO("Found an ENV (%.*s) which has changed value failed. Now will recovery it.\n", env->name_len, env->name);
         /* recovery the old ENV */
         if (move_env(env) == EF_NO_ERR) {
             EF_DEBUG("Recovery the ENV successful.\n");
+            /* the moved ENV may be counted again by the traversal, so build them again after recovery */
+            *traversed = false;
         } else {
             EF_DEBUG("Warning: Moved an ENV (size %d) failed when recovery. Now will GC then retry.\n", env->len);
+            *recovery_result = EF_ENV_FULL;
+            *traversed = false;
             return true;
         }
     } else if (env->status == ENV_PRE_WRITE) {
         uint8_t status_table[ENV_STATUS_TABLE_SIZE];
-        /* the ENV has not write finish, change the status to error */
+#ifdef EF_ENV_USING_TXN
+        /* the ENV of committed transaction, the index is updated when it's finished */
+        if (txn_recovery(env)) {
+            *traversed = false;
+            return false;
+        }
+#endif
+        /* the ENV has not write finish, change the status to error. The uncommitted transaction has more than one
+         * ENV, so go on to check the next ENV. */
         //TODO »æÖÆÒì³£´¦ÀíµÄ×´Ì¬×°»»Í¼
         write_status(env->addr.start, status_table, ENV_STATUS_NUM, ENV_ERR_HDR);
-        return true;
     }
 
     return false;
@@ -1749,9 +3909,23 @@ EfErrCode ef_load_env(void)
     EfErrCode result = EF_NO_ERR;
     struct env_node_obj env;
     struct sector_meta_data sector;
-    size_t check_failed_count = 0;
+    size_t check_failed_count = 0, recovery_retry = 0;
+    EfErrCode recovery_result;
+    bool traversed;
 
     in_recovery_check = true;
+    gc_step_env_addr = FAILED_ADDR;
+#ifdef EF_ENV_USING_CHECKPOINT
+    /* it's found first, so the sector format and GC recovery on loading make it stale */
+    find_checkpoint();
+#endif
+#ifdef EF_ENV_USING_INDEX
+    /* the ENV is found by traversal until the index is built */
+    env_index_ok = false;
+#endif
+#ifdef EF_ENV_USING_BLOOM
+    env_bloom_ok = false;
+#endif
     /* check all sector header */
     sector_iterator(&sector, SECTOR_STORE_UNUSED, &check_failed_count, NULL, check_sec_hdr_cb, false);
     /* all sector header check failed */
@@ -1765,16 +3939,63 @@ EfErrCode ef_load_env(void)
     /* check all sector header for recovery GC */
     sector_iterator(&sector, SECTOR_STORE_UNUSED, NULL, NULL, check_and_recovery_gc_cb, false);
 
+#ifdef EF_ENV_USING_CHECKPOINT
+    if (load_env_by_checkpoint()) {
+        EF_DEBUG("The ENV is loaded by the checkpoint (sequence number %lu).\n", (unsigned long) checkpoint_seq);
+        in_recovery_check = false;
+        goto __loaded;
+    }
+    /* the checkpoint is not same as the flash, so it's never used */
+    checkpoint_stale();
+#endif
+
 __retry:
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+    /* the ENV index and Bloom filter are built on the recovery traversal, the index is disabled when the table is
+     * too full */
+    reset_env_lookup();
+#endif
+    reset_sector_stat();
     /* check all ENV for recovery */
-    env_iterator(&env, NULL, NULL, check_and_recovery_env_cb);
-    if (gc_request) {
+    traversed = true;
+    recovery_result = EF_NO_ERR;
+    env_iterator(&env, &traversed, &recovery_result, check_and_recovery_env_cb);
+    /* the GC makes the space for the ENV which is failed to recovery, it's retried until the GC can't help */
+    if (gc_request && (recovery_result == EF_NO_ERR || recovery_retry++ < SECTOR_NUM)) {
         gc_collect();
         goto __retry;
     }
+    if (recovery_result != EF_NO_ERR) {
+        EF_INFO("Error: The ENV recovery failed, the flash has no space for the prepare deleted ENV.\n");
+        result = recovery_result;
+    }
 
     in_recovery_check = false;
 
+    /* the recovery traversal is interrupted or the ENV is changed by recovery, so build them again */
+    if (!traversed) {
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+        reset_env_lookup();
+#endif
+        reset_sector_stat();
+        env_iterator(&env, NULL, NULL, build_sector_stat_cb);
+    }
+
+#ifdef EF_ENV_USING_CHECKPOINT
+    /* The checkpoint is not saved here, it checks every ENV again and doubles the loading time. It's saved by
+     * ef_env_checkpoint on the idle time, then the next loading uses it. */
+__loaded:
+#endif
+#if defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM)
+#ifdef EF_ENV_USING_INDEX
+    EF_DEBUG("The ENV index is %s, %d nodes are used.\n", env_index_ok ? (env_index_all ? "OK" : "partial")
+            : "disabled", env_index_used);
+#endif
+#ifdef EF_ENV_USING_BLOOM
+    env_bloom_ok = true;
+#endif
+#endif /* defined(EF_ENV_USING_INDEX) || defined(EF_ENV_USING_BLOOM) */
+
     /* unlock the ENV cache */
     ef_port_env_unlock();
 
@@ -1804,6 +4025,18 @@ EfErrCode ef_env_init(ef_env const *default_env, size_t default_env_size) {
     EF_ASSERT(SECTOR_NUM >= 2);
     /* must be aligned with write granularity */
     EF_ASSERT((EF_STR_ENV_VALUE_MAX_SIZE * 8) % EF_WRITE_GRAN == 0);
+#ifdef EF_ENV_USING_CHECKPOINT
+    /* the checkpoint is saved on one sector out of the ENV area */
+    EF_ASSERT(CHECKPOINT_SIZE <= SECTOR_SIZE);
+    EF_ASSERT(EF_ENV_CHECKPOINT_ADDR % EF_ERASE_MIN_SIZE == 0);
+    EF_ASSERT(EF_ENV_CHECKPOINT_ADDR + SECTOR_SIZE <= EF_START_ADDR
+            || EF_ENV_CHECKPOINT_ADDR >= EF_START_ADDR + ENV_AREA_SIZE);
+#endif
+#ifdef EF_ENV_DEFAULT_IMAGE_ADDR
+    /* the default ENV image and its trailer must not be on the ENV area */
+    EF_ASSERT(EF_ENV_DEFAULT_IMAGE_ADDR + ENV_AREA_SIZE + sizeof(struct ef_env_image_trailer) <= EF_START_ADDR
+            || EF_ENV_DEFAULT_IMAGE_ADDR >= EF_START_ADDR + ENV_AREA_SIZE);
+#endif
 
     if (init_ok) {
         return EF_NO_ERR;
@@ -0,0 +1,446 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Save logs to flash.
+ * Created on: 2026-10-19
+ */
+
+/*
+ * The log area is a circular buffer of sectors behind the ENV area.
+ *
+ * Every used sector has a header with a sequence number, it's increased by one on every new sector. The log
+ * always starts at the first sector after clean, so the sectors from the first sector to the newest sector
+ * have the continuous sequence numbers, and the newest sector is found by binary search of the sector headers.
+ * All of the sectors before the newest sector are full, so the log is continuous on them.
+ *
+ * The log is programmed by the page aligned buffer, and the oldest sector is erased when the log area is full.
+ * So all of the sectors are erased by turns.
+ */
+
+#include <easyflash.h>
+#include <string.h>
+
+#ifdef EF_USING_LOG
+
+#if !defined(LOG_AREA_SIZE)
+#error "Please configure log area size (in ef_cfg.h)"
+#endif
+
+/* the log write buffer size, it's the flash page size. The log is programmed by page. */
+#ifndef EF_LOG_BUF_SIZE
+#define EF_LOG_BUF_SIZE                          256
+#endif
+
+/* magic word(`E`, `F`, `L`, `0`) */
+#define LOG_SECTOR_MAGIC_WORD                    0x304C4645
+
+#define LOG_SECTOR_SIZE                          EF_ERASE_MIN_SIZE
+#define LOG_SECTOR_NUM                           (LOG_AREA_SIZE / LOG_SECTOR_SIZE)
+#define LOG_SECTOR_HDR_SIZE                      (sizeof(struct log_sector_hdr))
+#define LOG_SECTOR_DATA_SIZE                     (LOG_SECTOR_SIZE - LOG_SECTOR_HDR_SIZE)
+#define LOG_SECTOR_ADDR(index)                   (log_area_start_addr + (index) * LOG_SECTOR_SIZE)
+
+#define LOG_ERASED_WORD                          0xFFFFFFFF
+
+struct log_sector_hdr {
+    uint32_t magic;                              /**< magic word(`E`, `F`, `L`, `0`) */
+    uint32_t seq;                                /**< sector sequence number */
+};
+typedef struct log_sector_hdr *log_sector_hdr_t;
+
+/* log area start address */
+static uint32_t log_area_start_addr = 0;
+/* the oldest and the newest sector index */
+static size_t log_start_sec = 0, log_end_sec = 0;
+/* the newest sector sequence number */
+static uint32_t log_end_seq = LOG_ERASED_WORD;
+/* the log end address, the log between the buffer flushed address and it is on the buffer */
+static uint32_t log_end_addr = 0;
+static bool log_is_empty = true;
+/* the page aligned write buffer */
+static uint32_t log_buf[EF_LOG_BUF_SIZE / sizeof(uint32_t)];
+static uint32_t log_buf_addr = 0;
+static size_t log_buf_flushed = 0;
+/* initialize OK flag */
+static bool init_ok = false;
+
+static bool read_sector_hdr(size_t index, log_sector_hdr_t hdr)
+{
+    ef_port_read(LOG_SECTOR_ADDR(index), (uint32_t *) hdr, LOG_SECTOR_HDR_SIZE);
+
+    return hdr->magic == LOG_SECTOR_MAGIC_WORD;
+}
+
+/*
+ * The sector is used on current round when its sequence number is continuous with the first sector.
+ */
+static bool sector_is_current(size_t index, uint32_t first_seq)
+{
+    struct log_sector_hdr hdr;
+
+    return read_sector_hdr(index, &hdr) && hdr.seq == first_seq + index;
+}
+
+/*
+ * Find the log end address on the newest sector. The written log is found from the sector end backward.
+ */
+static uint32_t find_sec_end_addr(uint32_t sec_addr)
+{
+    uint32_t addr = sec_addr + LOG_SECTOR_SIZE;
+    size_t i;
+
+    while (addr > sec_addr + LOG_SECTOR_HDR_SIZE) {
+        addr -= EF_LOG_BUF_SIZE;
+        ef_port_read(addr, log_buf, EF_LOG_BUF_SIZE);
+        for (i = EF_LOG_BUF_SIZE / sizeof(uint32_t); i > 0; i--) {
+            if (log_buf[i - 1] != LOG_ERASED_WORD) {
+                return addr + i * sizeof(uint32_t);
+            }
+        }
+    }
+
+    return sec_addr + LOG_SECTOR_HDR_SIZE;
+}
+
+/*
+ * The sector is blank when all of it is erased. The sector which is erased partly by power failure has the blank
+ * header, so the whole sector is checked. The write buffer is used for reading, it's reset by caller.
+ */
+static bool sector_is_blank(size_t index)
+{
+    uint32_t addr;
+    size_t i;
+
+    for (addr = LOG_SECTOR_ADDR(index); addr < LOG_SECTOR_ADDR(index) + LOG_SECTOR_SIZE; addr += EF_LOG_BUF_SIZE) {
+        ef_port_read(addr, log_buf, EF_LOG_BUF_SIZE);
+        for (i = 0; i < EF_LOG_BUF_SIZE / sizeof(uint32_t); i++) {
+            if (log_buf[i] != LOG_ERASED_WORD) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Program the log which is on the buffer. The buffer is moved to the next page when the page is full.
+ */
+static EfErrCode log_flush(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t size = log_end_addr - log_buf_addr - log_buf_flushed;
+
+    if (size > 0) {
+        result = ef_port_write(log_buf_addr + log_buf_flushed, log_buf + log_buf_flushed / sizeof(uint32_t), size);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+        log_buf_flushed += size;
+    }
+    if (log_buf_flushed == EF_LOG_BUF_SIZE) {
+        log_buf_addr += EF_LOG_BUF_SIZE;
+        log_buf_flushed = 0;
+        memset(log_buf, 0xFF, sizeof(log_buf));
+    }
+
+    return result;
+}
+
+/*
+ * Start the log on the next sector. The oldest sector is erased when the log area is full.
+ */
+static EfErrCode log_next_sector(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct log_sector_hdr hdr;
+    size_t next = log_is_empty ? log_start_sec : (log_end_sec + 1) % LOG_SECTOR_NUM;
+
+    if (!log_is_empty && next == log_start_sec) {
+        /* the log area is full, drop the oldest sector */
+        log_start_sec = (log_start_sec + 1) % LOG_SECTOR_NUM;
+    }
+    if (!sector_is_blank(next)) {
+        result = ef_port_erase(LOG_SECTOR_ADDR(next), LOG_SECTOR_SIZE);
+        if (result != EF_NO_ERR) {
+            return result;
+        }
+    }
+    /* the header is programmed with the first log page */
+    hdr.magic = LOG_SECTOR_MAGIC_WORD;
+    hdr.seq = ++log_end_seq;
+    memset(log_buf, 0xFF, sizeof(log_buf));
+    memcpy(log_buf, &hdr, LOG_SECTOR_HDR_SIZE);
+    log_buf_addr = LOG_SECTOR_ADDR(next);
+    log_buf_flushed = 0;
+    log_end_addr = log_buf_addr + LOG_SECTOR_HDR_SIZE;
+    log_end_sec = next;
+    log_is_empty = false;
+
+    return result;
+}
+
+/**
+ * The flash save log function initialize.
+ *
+ * @return result
+ */
+EfErrCode ef_log_init(void)
+{
+    EfErrCode result = EF_NO_ERR;
+    struct log_sector_hdr hdr;
+    size_t low, high, mid;
+    uint32_t first_seq;
+
+    EF_ASSERT(LOG_AREA_SIZE);
+    /* must be aligned with erase_min_size */
+    EF_ASSERT(LOG_AREA_SIZE % EF_ERASE_MIN_SIZE == 0);
+    /* sector number must be greater than or equal to 2 */
+    EF_ASSERT(LOG_SECTOR_NUM >= 2);
+    /* the buffer is aligned with the page in sector */
+    EF_ASSERT(LOG_SECTOR_SIZE % EF_LOG_BUF_SIZE == 0);
+
+    if (init_ok) {
+        return EF_NO_ERR;
+    }
+
+#ifdef EF_USING_ENV
+    log_area_start_addr = EF_START_ADDR + ENV_AREA_SIZE;
+#else
+    log_area_start_addr = EF_START_ADDR;
+#endif
+
+    log_is_empty = false;
+    if (read_sector_hdr(0, &hdr)) {
+        /* binary search the newest sector, the sequence number is continuous from the first sector to it */
+        first_seq = hdr.seq;
+        for (low = 0, high = LOG_SECTOR_NUM - 1; low < high;) {
+            mid = (low + high + 1) / 2;
+            if (sector_is_current(mid, first_seq)) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        log_end_sec = low;
+        log_end_seq = first_seq + low;
+        /* the oldest sector is behind the newest sector when the log has rolled back, it may be behind an erased
+         * sector when the power is lost after erase */
+        if (log_end_sec + 1 < LOG_SECTOR_NUM && read_sector_hdr(log_end_sec + 1, &hdr)) {
+            log_start_sec = log_end_sec + 1;
+        } else if (log_end_sec + 2 < LOG_SECTOR_NUM && read_sector_hdr(log_end_sec + 2, &hdr)) {
+            log_start_sec = log_end_sec + 2;
+        } else {
+            log_start_sec = 0;
+        }
+    } else if (hdr.magic == LOG_ERASED_WORD && hdr.seq == LOG_ERASED_WORD) {
+        if (read_sector_hdr(1, &hdr)) {
+            /* the first sector is erased for rolling back, but the power is lost before it's used */
+            log_start_sec = 1;
+            log_end_sec = LOG_SECTOR_NUM - 1;
+            read_sector_hdr(log_end_sec, &hdr);
+            log_end_seq = hdr.seq;
+        } else {
+            log_start_sec = 0;
+            log_is_empty = true;
+        }
+    } else {
+        EF_INFO("Warning: The log area header check failed. Now will clean it.\n");
+        log_is_empty = true;
+        result = ef_port_erase(log_area_start_addr, LOG_AREA_SIZE);
+        log_start_sec = 0;
+    }
+
+    if (!log_is_empty) {
+        log_end_addr = find_sec_end_addr(LOG_SECTOR_ADDR(log_end_sec));
+        log_buf_addr = log_end_addr / EF_LOG_BUF_SIZE * EF_LOG_BUF_SIZE;
+        log_buf_flushed = log_end_addr - log_buf_addr;
+        memset(log_buf, 0xFF, sizeof(log_buf));
+    }
+
+    EF_DEBUG("Log start sector is %d, end sector is %d, end address is 0x%08X.\n", log_start_sec, log_end_sec,
+            log_end_addr);
+
+    if (result == EF_NO_ERR) {
+        init_ok = true;
+    }
+
+    return result;
+}
+
+/**
+ * Get log used flash total size.
+ *
+ * @return log used flash total size. @note NOT contain sector headers
+ */
+size_t ef_log_get_used_size(void)
+{
+    if (!init_ok || log_is_empty) {
+        return 0;
+    }
+
+    return (log_end_sec + LOG_SECTOR_NUM - log_start_sec) % LOG_SECTOR_NUM * LOG_SECTOR_DATA_SIZE + log_end_addr
+            - LOG_SECTOR_ADDR(log_end_sec) - LOG_SECTOR_HDR_SIZE;
+}
+
+/**
+ * Read log from flash. The log on the write buffer is flushed first.
+ *
+ * @param index index for saved log. The oldest log index is 0.
+ *        Minimum index is 0.
+ *        Maximum index is ef_log_get_used_size() - 1.
+ * @param log the log which will read from flash
+ * @param size read bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_log_read(size_t index, uint32_t *log, size_t size)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t sec, offset, read_size;
+
+    EF_ASSERT(size % 4 == 0);
+    EF_ASSERT(index % 4 == 0);
+
+    if (!init_ok) {
+        EF_INFO("Log isn't initialize OK.\n");
+        return EF_READ_ERR;
+    }
+
+    /* lock the flash */
+    ef_port_env_lock();
+
+    result = log_flush();
+    if (result == EF_NO_ERR && index + size > ef_log_get_used_size()) {
+        EF_DEBUG("Error: Log index out of bound @%d, size is %d.\n", index, size);
+        result = EF_READ_ERR;
+    }
+    /* the log on one sector is read at once */
+    while (result == EF_NO_ERR && size > 0) {
+        sec = (log_start_sec + index / LOG_SECTOR_DATA_SIZE) % LOG_SECTOR_NUM;
+        offset = index % LOG_SECTOR_DATA_SIZE;
+        read_size = LOG_SECTOR_DATA_SIZE - offset;
+        if (read_size > size) {
+            read_size = size;
+        }
+        result = ef_port_read(LOG_SECTOR_ADDR(sec) + LOG_SECTOR_HDR_SIZE + offset, log, read_size);
+        log += read_size / sizeof(uint32_t);
+        index += read_size;
+        size -= read_size;
+    }
+
+    /* unlock the flash */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Write log to flash. The log is saved on the write buffer until the flash page is full,
+ * call ef_log_flush to program the remain log.
+ *
+ * @note The log which is all 0xFF on the end of log will be lost after reboot.
+ *
+ * @param log the log which will be write to flash
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_log_write(const uint32_t *log, size_t size)
+{
+    EfErrCode result = EF_NO_ERR;
+    size_t write_size;
+
+    EF_ASSERT(size % 4 == 0);
+
+    if (!init_ok) {
+        EF_INFO("Log isn't initialize OK.\n");
+        return EF_WRITE_ERR;
+    }
+
+    /* lock the flash */
+    ef_port_env_lock();
+
+    while (size > 0) {
+        /* the current sector is full */
+        if (log_is_empty || log_end_addr == LOG_SECTOR_ADDR(log_end_sec) + LOG_SECTOR_SIZE) {
+            if ((result = log_flush()) != EF_NO_ERR || (result = log_next_sector()) != EF_NO_ERR) {
+                break;
+            }
+        }
+        write_size = log_buf_addr + EF_LOG_BUF_SIZE - log_end_addr;
+        if (write_size > size) {
+            write_size = size;
+        }
+        memcpy((uint8_t *) log_buf + (log_end_addr - log_buf_addr), log, write_size);
+        log += write_size / sizeof(uint32_t);
+        log_end_addr += write_size;
+        size -= write_size;
+        /* the page is full */
+        if (log_end_addr == log_buf_addr + EF_LOG_BUF_SIZE && (result = log_flush()) != EF_NO_ERR) {
+            break;
+        }
+    }
+
+    /* unlock the flash */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Program the log on the write buffer to flash.
+ *
+ * @return result
+ */
+EfErrCode ef_log_flush(void)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("Log isn't initialize OK.\n");
+        return EF_WRITE_ERR;
+    }
+
+    /* lock the flash */
+    ef_port_env_lock();
+
+    result = log_flush();
+
+    /* unlock the flash */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+/**
+ * Clean all log which in flash.
+ *
+ * @return result
+ */
+EfErrCode ef_log_clean(void)
+{
+    EfErrCode result = EF_NO_ERR;
+
+    if (!init_ok) {
+        EF_INFO("Log isn't initialize OK.\n");
+        return EF_ERASE_ERR;
+    }
+
+    /* lock the flash */
+    ef_port_env_lock();
+
+    result = ef_port_erase(log_area_start_addr, LOG_AREA_SIZE);
+    /* all of the sectors are erased, so the log starts at the first sector again */
+    log_start_sec = 0;
+    log_is_empty = true;
+    /* drop the log on the write buffer */
+    log_end_addr = log_buf_addr + log_buf_flushed;
+
+    /* unlock the flash */
+    ef_port_env_unlock();
+
+    return result;
+}
+
+#endif /* EF_USING_LOG */
@@ -33,17 +33,25 @@
 #include <stm32f1xx_hal_conf.h>
 #include <sfud.h>
 
+/* the boot count is saved as uint32_t binary, @see ef_set_env_u32 */
+static const uint32_t default_boot_times = 0;
+
 /* default environment variables set for user */
 static const ef_env default_env_set[] = {
         {"iap_need_copy_app","0"},
         {"iap_copy_app_size","0"},
         {"stop_in_bootloader","0"},
         {"device_id","1"},
-        {"boot_times","0"},
+        {"boot_times",(void *)&default_boot_times,sizeof(default_boot_times)},
 };
 
 static char log_buf[128];
 
+#ifdef SFUD_USING_WRITE_BUFFER
+/* the small ENV header and data writes are merged by page, it's flushed when the ENV is unlocked */
+static sfud_write_buffer write_buf;
+#endif
+
 /**
  * Flash port for hardware initialize.
  *
@@ -57,8 +65,14 @@ EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size) {
 
     *default_env = default_env_set;
     *default_env_size = sizeof(default_env_set) / sizeof(default_env_set[0]);
+    /* enable the DWT cycle counter for ef_port_get_us, the SysTick interrupt is disabled by delay_init */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
     /* initialize SFUD library for SPI Flash */
     sfud_init();
+#ifdef SFUD_USING_WRITE_BUFFER
+    sfud_get_device(SFUD_XXXX_DEVICE_INDEX)->write_buf = &write_buf;
+#endif
 
     return result;
 }
@@ -124,6 +138,35 @@ EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size) {
     sfud_err sfud_result = SFUD_SUCCESS;
     const sfud_flash *flash = sfud_get_device_table() + SFUD_XXXX_DEVICE_INDEX;
 
+#ifdef SFUD_USING_WRITE_BUFFER
+    sfud_result = sfud_write_buffered(flash, addr, size, (const uint8_t *)buf);
+#else
+    sfud_result = sfud_write(flash, addr, size, (const uint8_t *)buf);
+#endif
+
+    if(sfud_result != SFUD_SUCCESS) {
+        result = EF_WRITE_ERR;
+    }
+
+    return result;
+}
+
+/**
+ * Write the ENV or sector status to flash.
+ * @note The status is the commit point of the data which is written before it, so it must NOT be merged with
+ *       the data. The unbuffered write programs the pending data first, then the status by its own page program.
+ *
+ * @param addr flash address
+ * @param buf the write status buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_write_status(uint32_t addr, const uint32_t *buf, size_t size) {
+    EfErrCode result = EF_NO_ERR;
+    sfud_err sfud_result = SFUD_SUCCESS;
+    const sfud_flash *flash = sfud_get_device_table() + SFUD_XXXX_DEVICE_INDEX;
+
     sfud_result = sfud_write(flash, addr, size, (const uint8_t *)buf);
 
     if(sfud_result != SFUD_SUCCESS) {
@@ -144,9 +187,31 @@ void ef_port_env_lock(void) {
  * unlock the ENV ram cache
  */
 void ef_port_env_unlock(void) {
+#ifdef SFUD_USING_WRITE_BUFFER
+    /* all of the ENV writes in this locked operate are on flash when it's unlocked */
+    sfud_write_buffer_flush(sfud_get_device_table() + SFUD_XXXX_DEVICE_INDEX);
+#endif
     __enable_irq();
 }
 
+/**
+ * Get the current time in microsecond, it's used for the incremental GC step time limit.
+ * @note Only the difference of two times is used, it's right when the times are less than 59 seconds (72MHz) apart.
+ *
+ * @return the current time (microsecond)
+ */
+uint32_t ef_port_get_us(void) {
+    static uint32_t last_cycles = 0, remain_cycles = 0, time_us = 0;
+    uint32_t cycles = DWT->CYCCNT, cycles_per_us = SystemCoreClock / 1000000;
+
+    remain_cycles += cycles - last_cycles;
+    last_cycles = cycles;
+    time_us += remain_cycles / cycles_per_us;
+    remain_cycles %= cycles_per_us;
+
+    return time_us;
+}
+
 
 /**
  * This function is print flash debug info.
@@ -4,19 +4,44 @@
 #define FAL_DEBUG 1
 #define FAL_PART_HAS_TABLE_CFG
 #define FAL_USING_SFUD_PORT
+/* the striped flash device on norflash0 and norflash1, it needs SFUD_USING_ASYNC_WRITE and SFUD_USING_NOR_FLASH1 */
+/* #define FAL_USING_STRIPE_PORT */
 
 /* ===================== Flash device Configuration ========================= */
 extern const struct fal_flash_dev stm32_onchip_flash;
 extern struct fal_flash_dev nor_flash0;
+#ifdef FAL_USING_STRIPE_PORT
+extern struct fal_flash_dev stripe_flash0;
 /* flash device table */
 #define FAL_FLASH_DEV_TABLE  \
     {                        \
         &stm32_onchip_flash, \
         &nor_flash0,         \
+        &stripe_flash0,      \
     }
+#else
+/* flash device table */
+#define FAL_FLASH_DEV_TABLE  \
+    {                        \
+        &stm32_onchip_flash, \
+        &nor_flash0,         \
+    }
+#endif /* FAL_USING_STRIPE_PORT */
 
 /* ====================== Partition Configuration ========================== */
 #ifdef FAL_PART_HAS_TABLE_CFG
+#ifdef FAL_USING_STRIPE_PORT
+/* partition table, the large images are on striped flash device, it starts from 1M of each SPI flash */
+#define FAL_PART_TABLE                                                                                    \
+    {                                                                                                     \
+        {FAL_PART_MAGIC_WORD, "bootloader", "stm32_onchip", 0                   , 64 * 1024        ,  0}, \
+        {FAL_PART_MAGIC_WORD, "app"       , "stm32_onchip", 64 * 1024           , (512 - 64) * 1024,  0}, \
+        {FAL_PART_MAGIC_WORD, "env"       , "norflash0"   , 0                   , 1024 * 1024      ,  0}, \
+        {FAL_PART_MAGIC_WORD, "download"  , "stripe0"     , 0                   , 1024 * 1024      ,  0}, \
+        {FAL_PART_MAGIC_WORD, "basesys"   , "stripe0"     , (1024) * 1024       , 1024 * 1024      ,  0}, \
+        {FAL_PART_MAGIC_WORD, "fonts"     , "stripe0"     , (1024 + 1024) * 1024, 5* 1024 * 1024   ,  0}, \
+    }
+#else
 /* partition table */
 #define FAL_PART_TABLE                                                                                    \
     {                                                                                                     \
@@ -27,6 +52,7 @@ extern struct fal_flash_dev nor_flash0;
         {FAL_PART_MAGIC_WORD, "basesys"   , "norflash0"   , (1024 + 1024) * 1024, 1024 * 1024      ,  0}, \
         {FAL_PART_MAGIC_WORD, "fonts"     , "norflash0"   , (1024 + 2048) * 1024, 5* 1024 * 1024   ,  0}, \
     }
+#endif /* FAL_USING_STRIPE_PORT */
 #endif /* FAL_PART_HAS_TABLE_CFG */
 
 #endif /* _FAL_CFG_H_ */
@@ -0,0 +1,279 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Function: The striped (RAID-0) flash device on two SFUD flash devices. The stripes are interleaved:
+ *           stripe 0 is on norflash0, stripe 1 is on norflash1, stripe 2 is on norflash0 ...
+ *
+ *           The page programs and erases are started on one flash while the other one is busy, so the
+ *           flash devices are programmed and erased concurrently. The read is sequential, the flash
+ *           devices are on the same SPI bus.
+ * Created on: 2026-10-19
+ */
+
+#include <fal.h>
+#include <sfud.h>
+
+#ifdef FAL_USING_STRIPE_PORT
+#if !defined(SFUD_USING_ASYNC_WRITE) || !defined(SFUD_USING_NOR_FLASH1)
+#error "The striped flash device needs SFUD_USING_ASYNC_WRITE and SFUD_USING_NOR_FLASH1 on 'sfud_cfg.h'"
+#endif
+
+#ifndef FAL_USING_STRIPE_DEV_NAME
+#define FAL_USING_STRIPE_DEV_NAME                "stripe0"
+#endif
+
+/* the stripe size, it must be multiple of SPI flash erase granularity */
+#ifndef FAL_STRIPE_SIZE
+#define FAL_STRIPE_SIZE                          4096
+#endif
+
+/* the start address on each SPI flash, the area before it is used by other flash device (like env on norflash0) */
+#ifndef FAL_STRIPE_DEV_OFFSET
+#define FAL_STRIPE_DEV_OFFSET                    (1024 * 1024)
+#endif
+
+/* the SPI flash page size */
+#define STRIPE_PAGE_SIZE                         256
+/* the number of SPI flash devices */
+#define STRIPE_DEV_NUM                           2
+
+static int init(void);
+static int read(long offset, uint8_t *buf, size_t size);
+static int write(long offset, const uint8_t *buf, size_t size);
+static int erase(long offset, size_t size);
+
+static sfud_flash_t sfud_dev[STRIPE_DEV_NUM] = { NULL };
+struct fal_flash_dev stripe_flash0 =
+{
+    .name       = FAL_USING_STRIPE_DEV_NAME,
+    .addr       = 0,
+    .len        = 2 * (8 * 1024 * 1024 - FAL_STRIPE_DEV_OFFSET),
+    .blk_size   = FAL_STRIPE_SIZE,
+    .ops        = {init, read, write, erase},
+    .write_gran = 1
+};
+
+/**
+ * get the SPI flash index of the offset
+ */
+static size_t dev_index(size_t offset)
+{
+    return (offset / FAL_STRIPE_SIZE) % STRIPE_DEV_NUM;
+}
+
+/**
+ * convert the striped device offset to SPI flash address
+ */
+static uint32_t dev_addr(size_t offset)
+{
+    return FAL_STRIPE_DEV_OFFSET + offset / FAL_STRIPE_SIZE / STRIPE_DEV_NUM * FAL_STRIPE_SIZE
+            + offset % FAL_STRIPE_SIZE;
+}
+
+/**
+ * get the first offset which is on the SPI flash from the given offset
+ */
+static size_t next_dev_offset(size_t offset, size_t index)
+{
+    size_t stripe = offset / FAL_STRIPE_SIZE;
+
+    if (stripe % STRIPE_DEV_NUM != index)
+    {
+        stripe += (index + STRIPE_DEV_NUM - stripe % STRIPE_DEV_NUM) % STRIPE_DEV_NUM;
+        offset = stripe * FAL_STRIPE_SIZE;
+    }
+
+    return offset;
+}
+
+static int init(void)
+{
+    /* bare metal platform */
+    extern sfud_flash sfud_norflash0;
+    extern sfud_flash sfud_norflash1;
+    size_t i;
+    uint32_t capacity;
+
+    sfud_dev[0] = &sfud_norflash0;
+    sfud_dev[1] = &sfud_norflash1;
+
+    capacity = sfud_dev[0]->chip.capacity;
+    for (i = 0; i < STRIPE_DEV_NUM; i++)
+    {
+        if (!sfud_dev[i]->init_ok || sfud_dev[i]->chip.erase_gran > FAL_STRIPE_SIZE
+                || FAL_STRIPE_SIZE % sfud_dev[i]->chip.erase_gran != 0)
+        {
+            log_e("The SPI flash %s is not supported by striped flash device.", sfud_dev[i]->name);
+            return -1;
+        }
+        if (sfud_dev[i]->chip.capacity < capacity)
+        {
+            capacity = sfud_dev[i]->chip.capacity;
+        }
+    }
+    /* update the flash chip information, the smaller SPI flash limits the length */
+    stripe_flash0.len = (capacity - FAL_STRIPE_DEV_OFFSET) / FAL_STRIPE_SIZE * FAL_STRIPE_SIZE * STRIPE_DEV_NUM;
+
+    return 0;
+}
+
+static int read(long offset, uint8_t *buf, size_t size)
+{
+    size_t cur = offset, end = offset + size, read_size;
+
+    assert(sfud_dev[0]);
+
+    while (cur < end)
+    {
+        read_size = FAL_STRIPE_SIZE - cur % FAL_STRIPE_SIZE;
+        if (read_size > end - cur)
+        {
+            read_size = end - cur;
+        }
+        if (sfud_read(sfud_dev[dev_index(cur)], dev_addr(cur), read_size, buf + (cur - offset)) != SFUD_SUCCESS)
+        {
+            return -1;
+        }
+        cur += read_size;
+    }
+
+    return size;
+}
+
+static int write(long offset, const uint8_t *buf, size_t size)
+{
+    size_t cur[STRIPE_DEV_NUM], end = offset + size, write_size, i, running;
+    uint32_t addr;
+    bool busy;
+    int result = size;
+
+    assert(sfud_dev[0]);
+
+    for (i = 0; i < STRIPE_DEV_NUM; i++)
+    {
+        cur[i] = next_dev_offset(offset, i);
+    }
+    /* start the page program on the idle SPI flash, until all of the data is programmed */
+    do
+    {
+        running = 0;
+        for (i = 0; i < STRIPE_DEV_NUM; i++)
+        {
+            if (cur[i] >= end)
+            {
+                continue;
+            }
+            running++;
+            if (sfud_is_busy(sfud_dev[i], &busy) != SFUD_SUCCESS)
+            {
+                result = -1;
+                break;
+            }
+            if (busy)
+            {
+                continue;
+            }
+            addr = dev_addr(cur[i]);
+            /* the program is in one page and one stripe */
+            write_size = STRIPE_PAGE_SIZE - addr % STRIPE_PAGE_SIZE;
+            if (write_size > FAL_STRIPE_SIZE - cur[i] % FAL_STRIPE_SIZE)
+            {
+                write_size = FAL_STRIPE_SIZE - cur[i] % FAL_STRIPE_SIZE;
+            }
+            if (write_size > end - cur[i])
+            {
+                write_size = end - cur[i];
+            }
+            if (sfud_program_start(sfud_dev[i], addr, write_size, buf + (cur[i] - offset)) != SFUD_SUCCESS)
+            {
+                result = -1;
+                break;
+            }
+            cur[i] = next_dev_offset(cur[i] + write_size, i);
+        }
+    } while (running && result >= 0);
+
+    /* wait for all of the SPI flash even if it's failed, so the next operation never overlaps a running one */
+    for (i = 0; i < STRIPE_DEV_NUM; i++)
+    {
+        if (sfud_wait_ready(sfud_dev[i]) != SFUD_SUCCESS)
+        {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+static int erase(long offset, size_t size)
+{
+    uint32_t addr[STRIPE_DEV_NUM], addr_end[STRIPE_DEV_NUM];
+    size_t end = offset + size, first, last, erase_size, i, running;
+    bool busy;
+    int result = size;
+
+    assert(sfud_dev[0]);
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    /* the stripes of one SPI flash are continuous on it, so they are erased as one area */
+    for (i = 0; i < STRIPE_DEV_NUM; i++)
+    {
+        addr[i] = addr_end[i] = 0;
+        first = next_dev_offset(offset, i);
+        if (first >= end)
+        {
+            continue;
+        }
+        last = (end - 1) / FAL_STRIPE_SIZE;
+        last -= (last + STRIPE_DEV_NUM - i) % STRIPE_DEV_NUM;
+        addr[i] = dev_addr(first);
+        addr_end[i] = dev_addr(last * FAL_STRIPE_SIZE) + FAL_STRIPE_SIZE;
+        if ((last + 1) * FAL_STRIPE_SIZE > end)
+        {
+            addr_end[i] -= (last + 1) * FAL_STRIPE_SIZE - end;
+        }
+    }
+    /* start the erase on the idle SPI flash, until all of the areas are erased */
+    do
+    {
+        running = 0;
+        for (i = 0; i < STRIPE_DEV_NUM; i++)
+        {
+            if (addr[i] >= addr_end[i])
+            {
+                continue;
+            }
+            running++;
+            if (sfud_is_busy(sfud_dev[i], &busy) != SFUD_SUCCESS)
+            {
+                result = -1;
+                break;
+            }
+            if (busy)
+            {
+                continue;
+            }
+            if (sfud_erase_start(sfud_dev[i], addr[i], addr_end[i] - addr[i], &erase_size) != SFUD_SUCCESS)
+            {
+                result = -1;
+                break;
+            }
+            addr[i] += erase_size;
+        }
+    } while (running && result >= 0);
+
+    /* wait for all of the SPI flash even if it's failed, so the next operation never overlaps a running one */
+    for (i = 0; i < STRIPE_DEV_NUM; i++)
+    {
+        if (sfud_wait_ready(sfud_dev[i]) != SFUD_SUCCESS)
+        {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+#endif /* FAL_USING_STRIPE_PORT */
@@ -0,0 +1,161 @@
+/*
+ * Function: The SPI bus arbiter. The devices on one SPI bus (SPI flash, display, sensors ...) share the bus
+ *           by transactions. Every device has its own configuration (mode, prescaler and CS pin), the bus is
+ *           reconfigured only when the next transaction is on a device with the different configuration.
+ *
+ *           There are two kinds of transactions:
+ *           1. Synchronous: spi_bus_acquire, spi_bus_transfer ..., spi_bus_release. It's used by the drivers
+ *              which need several transfers in one operation, like SFUD.
+ *           2. Asynchronous: spi_bus_submit. The transaction is queued by the device priority, and it's
+ *              transferred by DMA when the bus is idle. It's used by the bulk transfer, like display refresh.
+ *              The bulk transfer should be split into several transactions (e.g. one line for every
+ *              transaction), then the synchronous transactions of the other devices can run between them.
+ *
+ *           The waiting for the running DMA transfer doesn't depend on the DMA interrupt. The arbiter finishes it
+ *           by polling (port poll operation), so the bus can be acquired when the interrupts are disabled.
+ *
+ *           The other drivers on the bus (e.g. spi2_read_write_byte on BSP) must use it by the arbiter too.
+ *           The device which has no CS pin (cs_port is NULL) selects itself, it must hold the bus by
+ *           spi_bus_acquire while its CS is selected.
+ */
+
+#ifndef _SPI_BUS_H_
+#define _SPI_BUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "spi_bus_cfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* assert for developer. */
+#define SPI_BUS_ASSERT(EXPR)                                                   \
+if (!(EXPR))                                                                   \
+{                                                                              \
+    while (1);                                                                 \
+}
+
+#ifdef SPI_BUS_DEBUG_MODE
+#define SPI_BUS_DEBUG(...)                             printf("[SPI_BUS]" __VA_ARGS__)
+#else
+#define SPI_BUS_DEBUG(...)
+#endif
+
+/**
+ * error code
+ */
+typedef enum {
+    SPI_BUS_SUCCESS = 0,                         /**< success */
+    SPI_BUS_ERR_TRANSFER = 1,                    /**< SPI transfer error */
+    SPI_BUS_ERR_BUSY = 2,                        /**< the transaction has been submitted */
+} spi_bus_err;
+
+/**
+ * SPI mode, the clock polarity and phase
+ */
+enum {
+    SPI_BUS_MODE_0 = 0,                          /**< CPOL = 0, CPHA = 0 */
+    SPI_BUS_MODE_1 = 1,                          /**< CPOL = 0, CPHA = 1 */
+    SPI_BUS_MODE_2 = 2,                          /**< CPOL = 1, CPHA = 0 */
+    SPI_BUS_MODE_3 = 3,                          /**< CPOL = 1, CPHA = 1 */
+};
+
+struct spi_bus;
+
+/**
+ * the device on SPI bus
+ */
+typedef struct spi_bus_device {
+    const char *name;                            /**< device name */
+    struct spi_bus *bus;                         /**< the SPI bus */
+    uint8_t mode;                                /**< SPI mode, @see SPI_BUS_MODE_0 */
+    uint32_t prescaler;                          /**< SPI clock prescaler, it's defined by port */
+    void *cs_port;                               /**< CS pin port, it's defined by port. NULL: selected by user */
+    uint16_t cs_pin;                             /**< CS pin */
+    uint8_t priority;                            /**< priority of the asynchronous transaction, 0 is the highest */
+} spi_bus_device, *spi_bus_device_t;
+
+/**
+ * the asynchronous transaction
+ */
+typedef struct spi_bus_xfer {
+    spi_bus_device *dev;                         /**< the device */
+    const uint8_t *tx_buf;                       /**< send data, NULL: send dummy data */
+    uint8_t *rx_buf;                             /**< receive data buffer, NULL: the received data is dropped */
+    size_t size;                                 /**< transfer size */
+    /**
+     * the transaction finish callback, it may be called on interrupt
+     *
+     * @param xfer the transaction
+     * @param result transfer result
+     */
+    void (*done)(struct spi_bus_xfer *xfer, spi_bus_err result);
+    void *user_data;                             /**< user data for the callback */
+    /* the following fields are used by the arbiter */
+    struct spi_bus_xfer *next;
+    volatile bool pending;
+} spi_bus_xfer, *spi_bus_xfer_t;
+
+/**
+ * the SPI bus operations, they are implemented by port
+ */
+typedef struct {
+    /* configure the SPI mode and prescaler */
+    void (*configure)(struct spi_bus *bus, uint8_t mode, uint32_t prescaler);
+    /* select or deselect the device by CS pin */
+    void (*cs)(const spi_bus_device *dev, bool select);
+    /* blocking transfer, the tx_buf or rx_buf may be NULL */
+    spi_bus_err (*transfer)(struct spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size);
+    /* start the DMA transfer, spi_bus_dma_done must be called when it's finished. NULL: DMA is not supported */
+    spi_bus_err (*transfer_dma)(struct spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size);
+    /* process the DMA finish like the interrupt, spi_bus_dma_done is called when the running DMA transfer is
+     * finished. It's called with the lock by the waiting loops, so they don't depend on the DMA interrupt. */
+    void (*poll)(struct spi_bus *bus);
+    /* enter the critical section, the DMA finish interrupt must be disabled. It returns the previous state. */
+    uint32_t (*lock)(struct spi_bus *bus);
+    /* exit the critical section, the state is restored to the level which is returned by lock */
+    void (*unlock)(struct spi_bus *bus, uint32_t level);
+} spi_bus_ops;
+
+/**
+ * the SPI bus
+ */
+typedef struct spi_bus {
+    const char *name;                            /**< bus name */
+    const spi_bus_ops *ops;                      /**< port operations */
+    void *user_data;                             /**< port data, like SPI handle */
+    /* the following fields are used by the arbiter */
+    bool configured;                             /**< the mode and prescaler are valid */
+    uint8_t mode;                                /**< current SPI mode */
+    uint32_t prescaler;                          /**< current SPI clock prescaler */
+    spi_bus_device *owner;                       /**< the device which has acquired the bus */
+    spi_bus_device *waiting;                     /**< the device which is waiting to acquire the bus */
+    spi_bus_xfer *running;                       /**< the running asynchronous transaction */
+    spi_bus_xfer *queue;                         /**< the pending asynchronous transactions, sorted by priority */
+    bool dispatching;                            /**< the pending transactions are being started */
+    uint32_t reconfigure_count;                  /**< reconfigure times, it's used for the statistics */
+} spi_bus, *spi_bus_t;
+
+/* spi_bus.c */
+void spi_bus_init(spi_bus *bus);
+void spi_bus_attach(spi_bus *bus, spi_bus_device *dev);
+void spi_bus_acquire(spi_bus_device *dev);
+void spi_bus_release(spi_bus_device *dev);
+spi_bus_err spi_bus_transfer(spi_bus_device *dev, const uint8_t *tx_buf, size_t tx_size, uint8_t *rx_buf,
+        size_t rx_size);
+spi_bus_err spi_bus_exchange(spi_bus_device *dev, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size);
+spi_bus_err spi_bus_submit(spi_bus_xfer *xfer);
+void spi_bus_wait(spi_bus_xfer *xfer);
+void spi_bus_dma_done(spi_bus *bus, spi_bus_err result);
+
+/* spi_bus_port.c */
+spi_bus *spi_bus_port_get(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SPI_BUS_H_ */
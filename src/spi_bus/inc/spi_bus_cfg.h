@@ -0,0 +1,20 @@
+/*
+ * Function: It is the configure head file for the SPI bus arbiter.
+ */
+
+#ifndef _SPI_BUS_CFG_H_
+#define _SPI_BUS_CFG_H_
+
+/* SPI2 bus port (spi_bus_port.c) for STM32F1 HAL */
+/* #define SPI_BUS_USING_SPI2 */
+
+/* the asynchronous transactions are transferred by DMA, otherwise they are transferred by polling on submit */
+#define SPI_BUS_USING_DMA
+
+/* the transfer which is shorter than it uses polling, the DMA setup costs more than several bytes */
+#define SPI_BUS_DMA_MIN_SIZE                           16
+
+/* print the debug information */
+/* #define SPI_BUS_DEBUG_MODE */
+
+#endif /* _SPI_BUS_CFG_H_ */
@@ -0,0 +1,360 @@
+/*
+ * Function: The SPI bus arbiter, it's independent of platform. The bus operations are implemented by port.
+ */
+
+#include <spi_bus.h>
+#include <stdio.h>
+
+static void configure(spi_bus *bus, const spi_bus_device *dev);
+static void select_device(spi_bus *bus, const spi_bus_device *dev, bool selected);
+static void poll_dma(spi_bus *bus);
+static void finish(spi_bus *bus, spi_bus_err result);
+static void start_next(spi_bus *bus);
+
+/**
+ * initialize the SPI bus, the name, ops and user_data must be set before it
+ *
+ * @param bus SPI bus
+ */
+void spi_bus_init(spi_bus *bus) {
+    SPI_BUS_ASSERT(bus);
+    SPI_BUS_ASSERT(bus->ops);
+
+    bus->configured = false;
+    bus->owner = NULL;
+    bus->waiting = NULL;
+    bus->running = NULL;
+    bus->queue = NULL;
+    bus->dispatching = false;
+    bus->reconfigure_count = 0;
+}
+
+/**
+ * attach the device to SPI bus, the device is deselected
+ *
+ * @param bus SPI bus
+ * @param dev the device, its mode, prescaler, CS pin and priority must be set before it
+ */
+void spi_bus_attach(spi_bus *bus, spi_bus_device *dev) {
+    SPI_BUS_ASSERT(bus);
+    SPI_BUS_ASSERT(dev);
+
+    dev->bus = bus;
+    select_device(bus, dev, false);
+}
+
+/**
+ * acquire the SPI bus for the synchronous transaction, it will wait for the running asynchronous transaction.
+ * The pending asynchronous transactions which have lower priority will wait for the release.
+ * The running DMA transfer is finished by polling, so it can be called when the interrupts are disabled.
+ *
+ * @note It can't be called on interrupt. The bus must not be held by the other device on the same thread.
+ *
+ * @param dev the device
+ */
+void spi_bus_acquire(spi_bus_device *dev) {
+    spi_bus *bus;
+    bool acquired = false;
+    uint32_t level;
+
+    SPI_BUS_ASSERT(dev);
+    SPI_BUS_ASSERT(dev->bus);
+
+    bus = dev->bus;
+    while (!acquired) {
+        level = bus->ops->lock(bus);
+        if (!bus->owner && !bus->running) {
+            bus->owner = dev;
+            if (bus->waiting == dev) {
+                bus->waiting = NULL;
+            }
+            acquired = true;
+        } else {
+            if (!bus->waiting || bus->waiting->priority > dev->priority) {
+                /* stop the lower priority transactions starting after the running one */
+                bus->waiting = dev;
+            }
+            poll_dma(bus);
+        }
+        bus->ops->unlock(bus, level);
+    }
+}
+
+/**
+ * release the SPI bus, the pending asynchronous transactions will be started
+ *
+ * @param dev the device
+ */
+void spi_bus_release(spi_bus_device *dev) {
+    spi_bus *bus;
+    uint32_t level;
+
+    SPI_BUS_ASSERT(dev);
+    SPI_BUS_ASSERT(dev->bus);
+    SPI_BUS_ASSERT(dev->bus->owner == dev);
+
+    bus = dev->bus;
+    level = bus->ops->lock(bus);
+    bus->owner = NULL;
+    bus->ops->unlock(bus, level);
+
+    start_next(bus);
+}
+
+/**
+ * synchronous transfer, write data then read data in one CS cycle. The bus is acquired and released by this
+ * function when it's not acquired by the device.
+ *
+ * @param dev the device
+ * @param tx_buf write data
+ * @param tx_size write size
+ * @param rx_buf read data buffer
+ * @param rx_size read size
+ *
+ * @return result
+ */
+spi_bus_err spi_bus_transfer(spi_bus_device *dev, const uint8_t *tx_buf, size_t tx_size, uint8_t *rx_buf,
+        size_t rx_size) {
+    spi_bus_err result = SPI_BUS_SUCCESS;
+    spi_bus *bus;
+    bool acquired;
+
+    SPI_BUS_ASSERT(dev);
+    SPI_BUS_ASSERT(dev->bus);
+    if (tx_size) {
+        SPI_BUS_ASSERT(tx_buf);
+    }
+    if (rx_size) {
+        SPI_BUS_ASSERT(rx_buf);
+    }
+
+    bus = dev->bus;
+    acquired = bus->owner != dev;
+    if (acquired) {
+        spi_bus_acquire(dev);
+    }
+
+    configure(bus, dev);
+    select_device(bus, dev, true);
+    if (tx_size) {
+        result = bus->ops->transfer(bus, tx_buf, NULL, tx_size);
+    }
+    if (result == SPI_BUS_SUCCESS && rx_size) {
+        result = bus->ops->transfer(bus, NULL, rx_buf, rx_size);
+    }
+    select_device(bus, dev, false);
+
+    if (acquired) {
+        spi_bus_release(dev);
+    }
+
+    return result;
+}
+
+/**
+ * synchronous full-duplex transfer, the data is written and read at the same time in one CS cycle. The bus is
+ * acquired and released by this function when it's not acquired by the device.
+ *
+ * @param dev the device
+ * @param tx_buf write data
+ * @param rx_buf read data buffer, it has the same size as the write data
+ * @param size transfer size
+ *
+ * @return result
+ */
+spi_bus_err spi_bus_exchange(spi_bus_device *dev, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size) {
+    spi_bus_err result = SPI_BUS_SUCCESS;
+    spi_bus *bus;
+    bool acquired;
+
+    SPI_BUS_ASSERT(dev);
+    SPI_BUS_ASSERT(dev->bus);
+    SPI_BUS_ASSERT(tx_buf);
+    SPI_BUS_ASSERT(rx_buf);
+
+    bus = dev->bus;
+    acquired = bus->owner != dev;
+    if (acquired) {
+        spi_bus_acquire(dev);
+    }
+
+    configure(bus, dev);
+    select_device(bus, dev, true);
+    result = bus->ops->transfer(bus, tx_buf, rx_buf, size);
+    select_device(bus, dev, false);
+
+    if (acquired) {
+        spi_bus_release(dev);
+    }
+
+    return result;
+}
+
+/**
+ * submit the asynchronous transaction. It's queued after the transactions which have the same or higher priority,
+ * and the done callback will be called when it's finished.
+ *
+ * @param xfer the transaction, it must be kept until it's finished
+ *
+ * @return result, SPI_BUS_ERR_BUSY: the transaction has been submitted and it's not finished
+ */
+spi_bus_err spi_bus_submit(spi_bus_xfer *xfer) {
+    spi_bus *bus;
+    spi_bus_xfer **pos;
+    uint32_t level;
+
+    SPI_BUS_ASSERT(xfer);
+    SPI_BUS_ASSERT(xfer->dev);
+    SPI_BUS_ASSERT(xfer->dev->bus);
+    SPI_BUS_ASSERT(xfer->tx_buf || xfer->rx_buf);
+
+    bus = xfer->dev->bus;
+    level = bus->ops->lock(bus);
+    if (xfer->pending) {
+        bus->ops->unlock(bus, level);
+        return SPI_BUS_ERR_BUSY;
+    }
+    for (pos = &bus->queue; *pos && (*pos)->dev->priority <= xfer->dev->priority; pos = &(*pos)->next);
+    xfer->next = *pos;
+    *pos = xfer;
+    xfer->pending = true;
+    bus->ops->unlock(bus, level);
+
+    start_next(bus);
+
+    return SPI_BUS_SUCCESS;
+}
+
+/**
+ * wait for the asynchronous transaction finish. The running DMA transfer is finished by polling, so it can be called
+ * when the interrupts are disabled.
+ *
+ * @note It can't be called on interrupt.
+ *
+ * @param xfer the transaction
+ */
+void spi_bus_wait(spi_bus_xfer *xfer) {
+    spi_bus *bus;
+    uint32_t level;
+
+    SPI_BUS_ASSERT(xfer);
+    SPI_BUS_ASSERT(xfer->dev);
+    SPI_BUS_ASSERT(xfer->dev->bus);
+
+    bus = xfer->dev->bus;
+    while (xfer->pending) {
+        level = bus->ops->lock(bus);
+        poll_dma(bus);
+        bus->ops->unlock(bus, level);
+    }
+}
+
+/**
+ * It must be called by port when the DMA transfer is finished, it's usually called on DMA interrupt.
+ *
+ * @param bus SPI bus
+ * @param result transfer result
+ */
+void spi_bus_dma_done(spi_bus *bus, spi_bus_err result) {
+    SPI_BUS_ASSERT(bus);
+    SPI_BUS_ASSERT(bus->running);
+
+    finish(bus, result);
+    start_next(bus);
+}
+
+/**
+ * configure the SPI bus for the device, it's skipped when the mode and prescaler are not changed
+ */
+static void configure(spi_bus *bus, const spi_bus_device *dev) {
+    if (!bus->configured || bus->mode != dev->mode || bus->prescaler != dev->prescaler) {
+        bus->ops->configure(bus, dev->mode, dev->prescaler);
+        bus->configured = true;
+        bus->mode = dev->mode;
+        bus->prescaler = dev->prescaler;
+        bus->reconfigure_count++;
+        SPI_BUS_DEBUG("The bus %s is reconfigured for %s.\n", bus->name, dev->name);
+    }
+}
+
+/**
+ * select or deselect the device, the device which has no CS pin is selected by user
+ */
+static void select_device(spi_bus *bus, const spi_bus_device *dev, bool selected) {
+    if (dev->cs_port) {
+        bus->ops->cs(dev, selected);
+    }
+}
+
+/**
+ * finish the running DMA transfer by polling, it must be called with the lock
+ */
+static void poll_dma(spi_bus *bus) {
+    if (bus->running && bus->ops->poll) {
+        bus->ops->poll(bus);
+    }
+}
+
+/**
+ * finish the running asynchronous transaction
+ */
+static void finish(spi_bus *bus, spi_bus_err result) {
+    spi_bus_xfer *xfer = bus->running;
+    uint32_t level;
+
+    select_device(bus, xfer->dev, false);
+    level = bus->ops->lock(bus);
+    bus->running = NULL;
+    xfer->pending = false;
+    bus->ops->unlock(bus, level);
+
+    if (xfer->done) {
+        xfer->done(xfer, result);
+    }
+}
+
+/**
+ * start the pending asynchronous transactions until the bus is acquired or the DMA transfer is running
+ */
+static void start_next(spi_bus *bus) {
+    spi_bus_xfer *xfer;
+    spi_bus_err result;
+    uint32_t level;
+
+    level = bus->ops->lock(bus);
+    /* the transactions are started by the caller which is dispatching */
+    if (bus->dispatching) {
+        bus->ops->unlock(bus, level);
+        return;
+    }
+    bus->dispatching = true;
+    for (;;) {
+        xfer = bus->queue;
+        /* the waiting device has the higher or same priority, it takes the bus first */
+        if (bus->owner || bus->running || !xfer || (bus->waiting && bus->waiting->priority <= xfer->dev->priority)) {
+            break;
+        }
+        bus->queue = xfer->next;
+        bus->running = xfer;
+        bus->ops->unlock(bus, level);
+
+        configure(bus, xfer->dev);
+        select_device(bus, xfer->dev, true);
+#ifdef SPI_BUS_USING_DMA
+        if (bus->ops->transfer_dma && xfer->size >= SPI_BUS_DMA_MIN_SIZE) {
+            /* the running transaction will be finished by spi_bus_dma_done, the loop stops when it's running */
+            result = bus->ops->transfer_dma(bus, xfer->tx_buf, xfer->rx_buf, xfer->size);
+            if (result != SPI_BUS_SUCCESS) {
+                finish(bus, result);
+            }
+            level = bus->ops->lock(bus);
+            continue;
+        }
+#endif /* SPI_BUS_USING_DMA */
+        result = bus->ops->transfer(bus, xfer->tx_buf, xfer->rx_buf, xfer->size);
+        finish(bus, result);
+        level = bus->ops->lock(bus);
+    }
+    bus->dispatching = false;
+    bus->ops->unlock(bus, level);
+}
@@ -0,0 +1,259 @@
+/*
+ * Function: The SPI bus arbiter port for STM32F1 HAL. SPI2 is shared by SPI flash and the other devices,
+ *           the asynchronous transactions are transferred by DMA1 channel 4 (RX) and channel 5 (TX).
+ */
+
+#include <spi_bus.h>
+#include <string.h>
+#include <stm32f1xx_hal.h>
+
+#ifdef SPI_BUS_USING_SPI2
+
+/* the DMA interrupt priority, it must be same or lower than the other interrupts which use the bus */
+#ifndef SPI_BUS_DMA_IRQ_PRIORITY
+#define SPI_BUS_DMA_IRQ_PRIORITY                 2
+#endif
+
+typedef struct {
+    SPI_HandleTypeDef spi_handle;
+#ifdef SPI_BUS_USING_DMA
+    DMA_HandleTypeDef dma_tx;
+    DMA_HandleTypeDef dma_rx;
+#endif
+    bool init_ok;
+} spi_bus_port_data;
+
+static void bus_configure(spi_bus *bus, uint8_t mode, uint32_t prescaler);
+static void bus_cs(const spi_bus_device *dev, bool select);
+static spi_bus_err bus_transfer(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size);
+#ifdef SPI_BUS_USING_DMA
+static spi_bus_err bus_transfer_dma(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size);
+static void bus_poll(spi_bus *bus);
+#endif
+static uint32_t bus_lock(spi_bus *bus);
+static void bus_unlock(spi_bus *bus, uint32_t level);
+
+static const spi_bus_ops ops = {
+    bus_configure,
+    bus_cs,
+    bus_transfer,
+#ifdef SPI_BUS_USING_DMA
+    bus_transfer_dma,
+    bus_poll,
+#else
+    NULL,
+    NULL,
+#endif
+    bus_lock,
+    bus_unlock,
+};
+
+static spi_bus_port_data spi2_data;
+static spi_bus spi2_bus = { .name = "SPI2", .ops = &ops, .user_data = &spi2_data };
+
+static void spi2_init(void)
+{
+    SPI_HandleTypeDef *spi_handle = &spi2_data.spi_handle;
+
+    __HAL_RCC_SPI2_CLK_ENABLE();
+    spi_handle->Instance = SPI2;
+    spi_handle->Init.Mode = SPI_MODE_MASTER;
+    spi_handle->Init.Direction = SPI_DIRECTION_2LINES;
+    spi_handle->Init.DataSize = SPI_DATASIZE_8BIT;
+    spi_handle->Init.CLKPhase = SPI_PHASE_1EDGE;
+    spi_handle->Init.CLKPolarity = SPI_POLARITY_LOW;
+    spi_handle->Init.NSS = SPI_NSS_SOFT;
+    spi_handle->Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
+    spi_handle->Init.FirstBit = SPI_FIRSTBIT_MSB;
+    spi_handle->Init.TIMode = SPI_TIMODE_DISABLE;
+    spi_handle->Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+    spi_handle->State = HAL_SPI_STATE_RESET;
+    /* the SPI pins are configured by HAL_SPI_MspInit on BSP */
+    HAL_SPI_Init(spi_handle);
+    __HAL_SPI_ENABLE(spi_handle);
+
+#ifdef SPI_BUS_USING_DMA
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    spi2_data.dma_tx.Instance = DMA1_Channel5;
+    spi2_data.dma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    spi2_data.dma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    spi2_data.dma_tx.Init.MemInc = DMA_MINC_ENABLE;
+    spi2_data.dma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    spi2_data.dma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    spi2_data.dma_tx.Init.Mode = DMA_NORMAL;
+    spi2_data.dma_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    HAL_DMA_Init(&spi2_data.dma_tx);
+    __HAL_LINKDMA(spi_handle, hdmatx, spi2_data.dma_tx);
+
+    spi2_data.dma_rx.Instance = DMA1_Channel4;
+    spi2_data.dma_rx.Init = spi2_data.dma_tx.Init;
+    spi2_data.dma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    /* the RX channel must be served before the TX channel, otherwise the overrun will happen */
+    spi2_data.dma_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    HAL_DMA_Init(&spi2_data.dma_rx);
+    __HAL_LINKDMA(spi_handle, hdmarx, spi2_data.dma_rx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, SPI_BUS_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, SPI_BUS_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+#endif /* SPI_BUS_USING_DMA */
+}
+
+/**
+ * get the SPI bus by name, it will be initialized on the first time
+ *
+ * @param name bus name
+ *
+ * @return SPI bus, NULL: not found
+ */
+spi_bus *spi_bus_port_get(const char *name)
+{
+    if (strcmp(name, spi2_bus.name))
+    {
+        return NULL;
+    }
+    if (!spi2_data.init_ok)
+    {
+        spi2_init();
+        spi_bus_init(&spi2_bus);
+        spi2_data.init_ok = true;
+    }
+
+    return &spi2_bus;
+}
+
+static void bus_configure(spi_bus *bus, uint8_t mode, uint32_t prescaler)
+{
+    SPI_HandleTypeDef *spi_handle = &((spi_bus_port_data *) bus->user_data)->spi_handle;
+    uint32_t cr1 = prescaler;
+
+    if (mode & 0x02)
+    {
+        cr1 |= SPI_CR1_CPOL;
+    }
+    if (mode & 0x01)
+    {
+        cr1 |= SPI_CR1_CPHA;
+    }
+    /* the configuration can only be changed when SPI is disabled */
+    __HAL_SPI_DISABLE(spi_handle);
+    MODIFY_REG(spi_handle->Instance->CR1, SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA, cr1);
+    spi_handle->Init.BaudRatePrescaler = prescaler;
+    spi_handle->Init.CLKPolarity = (mode & 0x02) ? SPI_POLARITY_HIGH : SPI_POLARITY_LOW;
+    spi_handle->Init.CLKPhase = (mode & 0x01) ? SPI_PHASE_2EDGE : SPI_PHASE_1EDGE;
+    __HAL_SPI_ENABLE(spi_handle);
+}
+
+static void bus_cs(const spi_bus_device *dev, bool select)
+{
+    HAL_GPIO_WritePin((GPIO_TypeDef *) dev->cs_port, dev->cs_pin, select ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+static spi_bus_err bus_transfer(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size)
+{
+    SPI_HandleTypeDef *spi_handle = &((spi_bus_port_data *) bus->user_data)->spi_handle;
+    HAL_StatusTypeDef state;
+
+    if (tx_buf && rx_buf)
+    {
+        state = HAL_SPI_TransmitReceive(spi_handle, (uint8_t *) tx_buf, rx_buf, size, 1000);
+    }
+    else if (tx_buf)
+    {
+        state = HAL_SPI_Transmit(spi_handle, (uint8_t *) tx_buf, size, 1000);
+    }
+    else
+    {
+        /* the receive buffer is sent as dummy data on master mode */
+        memset(rx_buf, 0xFF, size);
+        state = HAL_SPI_Receive(spi_handle, rx_buf, size, 1000);
+    }
+
+    return state == HAL_OK ? SPI_BUS_SUCCESS : SPI_BUS_ERR_TRANSFER;
+}
+
+#ifdef SPI_BUS_USING_DMA
+static spi_bus_err bus_transfer_dma(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size)
+{
+    SPI_HandleTypeDef *spi_handle = &((spi_bus_port_data *) bus->user_data)->spi_handle;
+    HAL_StatusTypeDef state;
+
+    if (tx_buf && rx_buf)
+    {
+        state = HAL_SPI_TransmitReceive_DMA(spi_handle, (uint8_t *) tx_buf, rx_buf, size);
+    }
+    else if (tx_buf)
+    {
+        state = HAL_SPI_Transmit_DMA(spi_handle, (uint8_t *) tx_buf, size);
+    }
+    else
+    {
+        memset(rx_buf, 0xFF, size);
+        state = HAL_SPI_Receive_DMA(spi_handle, rx_buf, size);
+    }
+
+    return state == HAL_OK ? SPI_BUS_SUCCESS : SPI_BUS_ERR_TRANSFER;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &spi2_data.spi_handle)
+    {
+        spi_bus_dma_done(&spi2_bus, SPI_BUS_SUCCESS);
+    }
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &spi2_data.spi_handle)
+    {
+        spi_bus_dma_done(&spi2_bus, SPI_BUS_SUCCESS);
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &spi2_data.spi_handle)
+    {
+        spi_bus_dma_done(&spi2_bus, SPI_BUS_ERR_TRANSFER);
+    }
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&spi2_data.dma_rx);
+}
+
+void DMA1_Channel5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&spi2_data.dma_tx);
+}
+
+static void bus_poll(spi_bus *bus)
+{
+    spi_bus_port_data *data = (spi_bus_port_data *) bus->user_data;
+
+    /* It's same as the DMA interrupts, the HAL handler only processes the raised flags. It's called with the
+     * interrupts disabled, so the pending DMA interrupt finds no flag when it's enabled. */
+    HAL_DMA_IRQHandler(&data->dma_rx);
+    HAL_DMA_IRQHandler(&data->dma_tx);
+}
+#endif /* SPI_BUS_USING_DMA */
+
+static uint32_t bus_lock(spi_bus *bus)
+{
+    /* the previous state is kept by caller, so the nested lock restores the right state */
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    return primask;
+}
+
+static void bus_unlock(spi_bus *bus, uint32_t level)
+{
+    __set_PRIMASK(level);
+}
+
+#endif /* SPI_BUS_USING_SPI2 */
@@ -0,0 +1,38 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: It is the configure head file for the ENV image tool. The ENV area layout is decided by the ENV area
+ *           size, the erase size and the write granularity, so they MUST be same as the device ef_cfg.h.
+ *           They can be changed by the -D option, e.g. -DENV_AREA_SIZE=32768
+ * Created on: 2026-10-19
+ */
+
+
+#ifndef EF_CFG_H_
+#define EF_CFG_H_
+
+/* using ENV function, default is NG (Next Generation) mode start from V4.0 */
+#define EF_USING_ENV
+
+/* the minimum size of flash erasure */
+#ifndef EF_ERASE_MIN_SIZE
+#define EF_ERASE_MIN_SIZE              4096
+#endif
+
+/* the flash write granularity, unit: bit
+ * only support 1(nor flash)/ 8(stm32f4)/ 32(stm32f1)/ 64(stm32l4) */
+#ifndef EF_WRITE_GRAN
+#define EF_WRITE_GRAN                  1
+#endif
+
+/* ENV area start address, the image is started from it */
+#ifndef EF_START_ADDR
+#define EF_START_ADDR                  (0)
+#endif
+
+/* ENV area size, it's the image size */
+#ifndef ENV_AREA_SIZE
+#define ENV_AREA_SIZE                  (2 * EF_ERASE_MIN_SIZE)
+#endif
+
+#endif /* EF_CFG_H_ */
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Host tool for building the default ENV area image from a key/value manifest. The library ef_env.c is
+ *           linked with a RAM flash port, so the image is same as the ENV area which is set default on the device.
+ *           The image file is the ENV area (ENV_AREA_SIZE) and the CRC32 trailer (struct ef_env_image_trailer).
+ *           The factory programs the image file to EF_ENV_DEFAULT_IMAGE_ADDR, and its ENV area to the ENV area, by
+ *           one burst, then the device checks the CRC32 and restores the default ENV by copying it. Build it on
+ *           Linux, e.g.
+ *           gcc -Itools/ef_image -Isrc/easyflash/inc tools/ef_image/ef_image.c tools/ef_image/ef_image_port.c
+ *               src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c src/easyflash/src/ef_utils.c -o ef_image
+ *           The ENV area configuration on tools/ef_image/ef_cfg.h must be same as the device.
+ *
+ *           The manifest has one ENV on every line, the empty line and the line starts with '#' are ignored:
+ *           name=string value
+ *           name:hex=0102A0FF
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* the max manifest line size, the hex blob value is 2 characters per byte */
+#define MANIFEST_LINE_MAX                        32768
+/* the max ENV number of the manifest */
+#define MANIFEST_ENV_MAX                         512
+/* the name suffix of the hex blob value */
+#define HEX_VALUE_SUFFIX                         ":hex"
+
+extern void ef_image_port_set_default(ef_env const *default_env, size_t default_env_size);
+extern const uint8_t *ef_image_port_get_image(size_t *size);
+
+static ef_env env_set[MANIFEST_ENV_MAX];
+static size_t env_set_size = 0;
+
+/*
+ * Copy the string to the new memory, strdup is not on C99.
+ */
+static char *str_dup(const char *str)
+{
+    char *copy = malloc(strlen(str) + 1);
+
+    if (copy) {
+        strcpy(copy, str);
+    }
+
+    return copy;
+}
+
+static int hex_to_num(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/*
+ * Parse the hex string to the blob value.
+ *
+ * @return the blob size, 0: the hex string is wrong
+ */
+static size_t parse_hex(const char *str, uint8_t **blob)
+{
+    size_t len = strlen(str), i;
+    int high, low;
+
+    if (len == 0 || len % 2 != 0) {
+        return 0;
+    }
+    *blob = malloc(len / 2);
+    if (*blob == NULL) {
+        return 0;
+    }
+    for (i = 0; i < len / 2; i++) {
+        high = hex_to_num(str[i * 2]);
+        low = hex_to_num(str[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            free(*blob);
+            return 0;
+        }
+        (*blob)[i] = (uint8_t) (high << 4 | low);
+    }
+
+    return len / 2;
+}
+
+/*
+ * Parse the manifest to the default ENV set.
+ *
+ * @return 0: success, -1: failed
+ */
+static int parse_manifest(const char *path)
+{
+    static char line[MANIFEST_LINE_MAX];
+    FILE *fp;
+    char *value;
+    size_t line_num = 0, name_len, i;
+    uint8_t *blob;
+    int result = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Open the manifest %s failed.\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        line_num++;
+        if (strchr(line, '\n') == NULL && !feof(fp)) {
+            fprintf(stderr, "Error: %s:%zu: The line is longer than %d.\n", path, line_num, MANIFEST_LINE_MAX - 2);
+            result = -1;
+            break;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        value = strchr(line, '=');
+        if (value == NULL || value == line) {
+            fprintf(stderr, "Error: %s:%zu: The ENV must be 'name=value'.\n", path, line_num);
+            result = -1;
+            break;
+        }
+        *value++ = '\0';
+        if (env_set_size >= MANIFEST_ENV_MAX) {
+            fprintf(stderr, "Error: %s:%zu: The ENV number is more than %d.\n", path, line_num, MANIFEST_ENV_MAX);
+            result = -1;
+            break;
+        }
+        name_len = strlen(line);
+        if (name_len > strlen(HEX_VALUE_SUFFIX) && !strcmp(line + name_len - strlen(HEX_VALUE_SUFFIX), HEX_VALUE_SUFFIX)) {
+            name_len -= strlen(HEX_VALUE_SUFFIX);
+            line[name_len] = '\0';
+            env_set[env_set_size].value_len = parse_hex(value, &blob);
+            if (env_set[env_set_size].value_len == 0) {
+                fprintf(stderr, "Error: %s:%zu: The hex value of %s is wrong.\n", path, line_num, line);
+                result = -1;
+                break;
+            }
+            env_set[env_set_size].value = blob;
+        } else {
+            /* the string value length is 0 on the default ENV set */
+            env_set[env_set_size].value = str_dup(value);
+            env_set[env_set_size].value_len = 0;
+        }
+        if (name_len > EF_ENV_NAME_MAX) {
+            fprintf(stderr, "Error: %s:%zu: The name %s is longer than %d.\n", path, line_num, line, EF_ENV_NAME_MAX);
+            result = -1;
+            break;
+        }
+        for (i = 0; i < env_set_size; i++) {
+            if (!strcmp(env_set[i].key, line)) {
+                fprintf(stderr, "Error: %s:%zu: The ENV %s is duplicate.\n", path, line_num, line);
+                result = -1;
+                break;
+            }
+        }
+        if (result != 0) {
+            break;
+        }
+        env_set[env_set_size++].key = str_dup(line);
+    }
+    fclose(fp);
+
+    if (result == 0 && env_set_size == 0) {
+        fprintf(stderr, "Error: The manifest %s has no ENV.\n", path);
+        result = -1;
+    }
+
+    return result;
+}
+
+/*
+ * Check all ENV of the manifest are on the image, the ENV which is not created (e.g. the ENV area is full) is found.
+ *
+ * @return 0: success, -1: failed
+ */
+static int check_image(void)
+{
+    size_t i, value_len, saved_len;
+    uint8_t *buf;
+    int result = 0;
+
+    for (i = 0; i < env_set_size && result == 0; i++) {
+        value_len = env_set[i].value_len ? env_set[i].value_len : strlen(env_set[i].value);
+        buf = malloc(value_len + 1);
+        if (buf == NULL) {
+            return -1;
+        }
+        saved_len = 0;
+        if (ef_get_env_blob(env_set[i].key, buf, value_len + 1, &saved_len) != value_len || saved_len != value_len
+                || memcmp(buf, env_set[i].value, value_len)) {
+            fprintf(stderr, "Error: The ENV %s is not on the image. Please check the ENV area size.\n", env_set[i].key);
+            result = -1;
+        }
+        free(buf);
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    struct ef_env_image_trailer trailer;
+    const uint8_t *image;
+    size_t image_size;
+    FILE *fp;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <manifest> <image>\n", argv[0]);
+        return 1;
+    }
+    if (parse_manifest(argv[1]) != 0) {
+        return 1;
+    }
+    /* the empty ENV area is set default by the manifest when EasyFlash initialize */
+    ef_image_port_set_default(env_set, env_set_size);
+    if (easyflash_init() != EF_NO_ERR) {
+        fprintf(stderr, "Error: EasyFlash initialize failed.\n");
+        return 1;
+    }
+    if (check_image() != 0) {
+        return 1;
+    }
+
+    image = ef_image_port_get_image(&image_size);
+    trailer.magic = EF_ENV_IMAGE_MAGIC_WORD;
+    trailer.crc32 = ef_calc_crc32(0, image, image_size);
+    fp = fopen(argv[2], "wb");
+    if (fp == NULL || fwrite(image, 1, image_size, fp) != image_size
+            || fwrite(&trailer, 1, sizeof(trailer), fp) != sizeof(trailer)) {
+        fprintf(stderr, "Error: Write the image %s failed.\n", argv[2]);
+        if (fp) {
+            fclose(fp);
+        }
+        return 1;
+    }
+    fclose(fp);
+    printf("The image %s is built, %zu ENV, %zu bytes and the CRC32 (0x%08lX) trailer.\n", argv[2], env_set_size,
+            image_size, (unsigned long) trailer.crc32);
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: Portable interface for the ENV image tool. The flash is a RAM buffer of the ENV area.
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+/* the ENV area on RAM, the erased data is 0xFF and the write only clears the bits like the NOR flash */
+static uint8_t flash_buf[ENV_AREA_SIZE];
+/* default environment variables set by the manifest */
+static ef_env const *default_env_set;
+static size_t default_env_set_size;
+
+/**
+ * Set the default ENV set and erase the RAM flash. It must be called before easyflash_init.
+ *
+ * @param default_env default ENV set
+ * @param default_env_size default ENV set size
+ */
+void ef_image_port_set_default(ef_env const *default_env, size_t default_env_size) {
+    default_env_set = default_env;
+    default_env_set_size = default_env_size;
+    memset(flash_buf, 0xFF, sizeof(flash_buf));
+}
+
+/**
+ * Get the ENV area image on RAM.
+ *
+ * @param size image size
+ *
+ * @return image
+ */
+const uint8_t *ef_image_port_get_image(size_t *size) {
+    *size = sizeof(flash_buf);
+
+    return flash_buf;
+}
+
+/**
+ * Flash port for hardware initialize.
+ *
+ * @param default_env default ENV set for user
+ * @param default_env_size default ENV set size
+ *
+ * @return result
+ */
+EfErrCode ef_port_init(ef_env const **default_env, size_t *default_env_size) {
+    *default_env = default_env_set;
+    *default_env_size = default_env_set_size;
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Read data from flash.
+ * @note This operation's units is word.
+ *
+ * @param addr flash address
+ * @param buf buffer to store read data
+ * @param size read bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size) {
+    EF_ASSERT(addr - EF_START_ADDR + size <= ENV_AREA_SIZE);
+
+    memcpy(buf, flash_buf + (addr - EF_START_ADDR), size);
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Erase data on flash.
+ * @note This operation is irreversible.
+ * @note This operation's units is different which on many chips.
+ *
+ * @param addr flash address
+ * @param size erase bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_erase(uint32_t addr, size_t size) {
+    /* make sure the start address is a multiple of FLASH_ERASE_MIN_SIZE */
+    EF_ASSERT(addr % EF_ERASE_MIN_SIZE == 0);
+    EF_ASSERT(addr - EF_START_ADDR + size <= ENV_AREA_SIZE);
+
+    memset(flash_buf + (addr - EF_START_ADDR), 0xFF, size);
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Write data to flash.
+ * @note This operation's units is word.
+ * @note This operation must after erase. @see flash_erase.
+ *
+ * @param addr flash address
+ * @param buf the write data buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_write(uint32_t addr, const uint32_t *buf, size_t size) {
+    size_t i;
+
+    EF_ASSERT(addr - EF_START_ADDR + size <= ENV_AREA_SIZE);
+
+    for (i = 0; i < size; i++) {
+        flash_buf[addr - EF_START_ADDR + i] &= ((const uint8_t *) buf)[i];
+    }
+
+    return EF_NO_ERR;
+}
+
+/**
+ * Write the ENV or sector status to flash.
+ *
+ * @param addr flash address
+ * @param buf the write status buffer
+ * @param size write bytes size
+ *
+ * @return result
+ */
+EfErrCode ef_port_write_status(uint32_t addr, const uint32_t *buf, size_t size) {
+    return ef_port_write(addr, buf, size);
+}
+
+/**
+ * lock the ENV ram cache
+ */
+void ef_port_env_lock(void) {
+    /* the tool is single thread */
+}
+
+/**
+ * unlock the ENV ram cache
+ */
+void ef_port_env_unlock(void) {
+    /* the tool is single thread */
+}
+
+/**
+ * Get the current time for the incremental GC time budget.
+ *
+ * @return the current time (us)
+ */
+uint32_t ef_port_get_us(void) {
+    return (uint32_t) ((uint64_t) clock() * 1000000 / CLOCKS_PER_SEC);
+}
+
+/**
+ * This function is print flash debug info.
+ *
+ * @param file the file which has call this function
+ * @param line the line number which has call this function
+ * @param format output format
+ * @param ... args
+ *
+ */
+void ef_log_debug(const char *file, const long line, const char *format, ...) {
+    va_list args;
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    fprintf(stderr, "[Flash](%s:%ld) ", file, line);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+/**
+ * This function is print flash routine info.
+ *
+ * @param format output format
+ * @param ... args
+ */
+void ef_log_info(const char *format, ...) {
+    va_list args;
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    fprintf(stderr, "[Flash]");
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+/**
+ * This function is print flash non-package info.
+ *
+ * @param format output format
+ * @param ... args
+ */
+void ef_print(const char *format, ...) {
+    va_list args;
+
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the EasyFlash Library.
+ *
+ * Function: It is the configure head file for the simulator tests. The ENV area is larger than the device, so the
+ *           GC runs with many sectors. They can be changed by the -D option, e.g. -DENV_AREA_SIZE=8192
+ * Created on: 2026-10-19
+ */
+
+
+#ifndef EF_CFG_H_
+#define EF_CFG_H_
+
+/* using ENV function, default is NG (Next Generation) mode start from V4.0 */
+#define EF_USING_ENV
+
+/* the minimum size of flash erasure */
+#ifndef EF_ERASE_MIN_SIZE
+#define EF_ERASE_MIN_SIZE              4096
+#endif
+
+/* the flash write granularity, unit: bit
+ * only support 1(nor flash)/ 8(stm32f4)/ 32(stm32f1)/ 64(stm32l4) */
+#ifndef EF_WRITE_GRAN
+#define EF_WRITE_GRAN                  1
+#endif
+
+/* backup area start address */
+#ifndef EF_START_ADDR
+#define EF_START_ADDR                  (0)
+#endif
+
+/* ENV area size */
+#ifndef ENV_AREA_SIZE
+#define ENV_AREA_SIZE                  (16 * EF_ERASE_MIN_SIZE)     /* 64K */
+#endif
+
+/* saved log area size, it's used when EF_USING_LOG is defined */
+#ifndef LOG_AREA_SIZE
+#define LOG_AREA_SIZE                  (16 * EF_ERASE_MIN_SIZE)     /* 64K */
+#endif
+
+/* the CRC32 slice number, it's same as the device */
+#ifndef EF_CRC32_SLICE_NUM
+#define EF_CRC32_SLICE_NUM             4
+#endif
+
+#endif /* EF_CFG_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Function: Simulator test of the SFUD 4-byte address on a 32MB W25Q256. The random erase, write and read rounds are
+ *           compared with a reference image on the native 4-byte address opcodes (the SFDP has the 4-byte address
+ *           instruction table) and on the 4-byte address mode (B7h). The chip is also reset by software after the
+ *           initialization, it's back to the 3-byte address mode, then the native opcodes must still be right and
+ *           the mode switching path must corrupt the data. Build and run it on Linux from the repository root, e.g.
+ *           gcc -Isrc/SUFD/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c
+ *               src/SUFD/src/sfud_sim_port.c tools/sim/sim_4byte_addr.c -o sim_4byte_addr && ./sim_4byte_addr
+ * Created on: 2026-10-19
+ */
+
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the W25Q256 */
+#define FLASH_SIZE                               (32 * 1024 * 1024)
+#define FLASH_CAPACITY_ID                        0x19
+/* the random erase, write and read rounds */
+#define ROUND_NUM                                400
+#define ROUND_MAX_SIZE                           9000
+
+#ifdef SFUD_USING_PARAM_CACHE
+extern sfud_err sfud_port_write_param_cache(const sfud_flash *flash, const uint8_t *buf, size_t size);
+#endif
+
+static uint8_t ref[FLASH_SIZE];
+
+/**
+ * run the random rounds on the new W25Q256
+ *
+ * @return the rounds which are read right, ROUND_NUM + 1: all of the rounds and the whole flash are right, -1: error
+ */
+static int run(const char *name, bool native_cmd, bool reset) {
+    static uint8_t data[ROUND_MAX_SIZE], saved[ROUND_MAX_SIZE];
+    static const uint8_t reset_cmd[] = { SFUD_CMD_ENABLE_RESET, SFUD_CMD_RESET };
+    sfud_flash flash = { .name = "W25Q256", .spi.name = "SPI2" };
+    sfud_sim *sim = sfud_sim_port_get_device(flash.spi.name);
+    sfud_sim_config cfg;
+    uint32_t addr, start, end, i;
+    size_t size;
+    int round, right = 0;
+
+    sfud_sim_default_config(&cfg);
+    cfg.capacity_id = FLASH_CAPACITY_ID;
+    cfg.capacity = FLASH_SIZE;
+    cfg.addr_4b_table = native_cmd;
+    sfud_sim_deinit(sim);
+    if (sfud_sim_init(sim, &cfg) != SFUD_SUCCESS) {
+        printf("%s: simulator initialize failed\n", name);
+        return -1;
+    }
+#ifdef SFUD_USING_PARAM_CACHE
+    /* the parameters of the last part are dropped, so the SFDP is probed again */
+    memset(saved, 0, sizeof(saved));
+    sfud_port_write_param_cache(&flash, saved, 256);
+#endif
+    sfud_sim_clear_stats(sim);
+    if (sfud_device_init(&flash) != SFUD_SUCCESS) {
+        printf("%s: initialize failed\n", name);
+        return -1;
+    }
+    if (flash.chip.capacity != FLASH_SIZE || !flash.addr_in_4_byte || flash.addr_4_byte_cmd != native_cmd) {
+        printf("%s: the 4-byte address path is not right\n", name);
+        return -1;
+    }
+    if (reset) {
+        flash.spi.wr(&flash.spi, reset_cmd, sizeof(reset_cmd), NULL, 0);
+    }
+
+    memset(ref, 0xFF, sizeof(ref));
+    srand(2);
+    for (round = 0; round < ROUND_NUM; round++) {
+        addr = rand() % (FLASH_SIZE - ROUND_MAX_SIZE);
+        size = 1 + rand() % ROUND_MAX_SIZE;
+        for (i = 0; i < size; i++) {
+            data[i] = rand();
+        }
+        if (round % 3 == 0) {
+            sfud_erase(&flash, addr, size);
+            start = addr - addr % 4096;
+            end = (addr + size + 4095) / 4096 * 4096;
+            memset(&ref[start], 0xFF, end - start);
+        }
+        sfud_write(&flash, addr, size, data);
+        for (i = 0; i < size; i++) {
+            ref[addr + i] &= data[i];
+        }
+        if (sfud_read(&flash, addr, size, saved) == SFUD_SUCCESS && !memcmp(saved, &ref[addr], size)) {
+            right++;
+        }
+    }
+    if (right == ROUND_NUM && !memcmp(sim->array, ref, sizeof(ref))) {
+        right++;
+    }
+    printf("%-24s rounds right %3d/%d, flash %-9s address mode switches %lu, resets %lu\n", name,
+            right > ROUND_NUM ? ROUND_NUM : right, ROUND_NUM, right > ROUND_NUM ? "right," : "corrupt,",
+            (unsigned long) sim->stats.addr_mode_switches, (unsigned long) sim->stats.resets);
+
+    return right;
+}
+
+int main(void) {
+    /* the native opcodes never change the address mode, so the reset doesn't matter */
+    if (run("native opcodes:", true, false) != ROUND_NUM + 1
+            || run("native opcodes, reset:", true, true) != ROUND_NUM + 1) {
+        return 1;
+    }
+    /* the mode switching path is right until the chip is reset to the 3-byte address mode */
+    if (run("mode switching:", false, false) != ROUND_NUM + 1) {
+        return 1;
+    }
+    if (run("mode switching, reset:", false, true) > ROUND_NUM) {
+        printf("the reset mode switching part is not corrupted\n");
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Function: Host test of the EasyFlash CRC32. The CRC32 is checked by the bitwise reference on the random offsets and
+ *           lengths, and by the chained calculation, then the speed on the 1MB unaligned buffer is printed. The
+ *           implementation is selected by EF_CRC32_SLICE_NUM (1, 4 or 8). Build and run it on Linux from the
+ *           repository root, e.g.
+ *           gcc -O2 -DEF_CRC32_SLICE_NUM=4 -Itools/sim -Isrc/easyflash/inc src/easyflash/src/ef_utils.c
+ *               tools/sim/sim_crc32.c -o sim_crc32 && ./sim_crc32
+ * Created on: 2026-10-19
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <easyflash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* the random checks */
+#define CHECK_NUM                                200000
+/* the maximum length of one random check */
+#define CHECK_MAX_SIZE                           300
+/* the speed test repeats */
+#define BENCH_NUM                                200
+
+static uint8_t buf[1024 * 1024];
+
+static uint32_t ref_crc32(uint32_t crc, const uint8_t *data, size_t size) {
+    int i;
+
+    crc = ~crc;
+    while (size--) {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+int main(void) {
+    size_t i, offset, size, split;
+    volatile uint32_t sink = 0;
+    struct timespec start, end;
+    uint32_t crc;
+    double sec;
+
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = rand();
+    }
+    if (ef_calc_crc32(0, "123456789", 9) != 0xCBF43926) {
+        printf("the check value of \"123456789\" is wrong\n");
+        return 1;
+    }
+    for (i = 0; i < CHECK_NUM; i++) {
+        offset = rand() % 64;
+        size = rand() % CHECK_MAX_SIZE;
+        crc = ef_calc_crc32(0, buf + offset, size);
+        if (crc != ref_crc32(0, buf + offset, size)) {
+            printf("mismatch on offset %lu, length %lu\n", (unsigned long) offset, (unsigned long) size);
+            return 1;
+        }
+        split = size ? rand() % size : 0;
+        if (crc != ef_calc_crc32(ef_calc_crc32(0, buf + offset, split), buf + offset + split, size - split)) {
+            printf("chained mismatch on offset %lu, length %lu\n", (unsigned long) offset, (unsigned long) size);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_NUM; i++) {
+        sink += ef_calc_crc32(0, buf + 1, sizeof(buf) - 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("slice-by-%d: %.0f MB/s\n", EF_CRC32_SLICE_NUM, BENCH_NUM * (sizeof(buf) - 1) / sec / 1e6);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Function: Host test of the SFUD dual-buffer write on a mocked AT45DB161E. The mocked part is shipped on the
+ *           DataFlash page size, the SFUD must configure it to the binary page size on initialization, then the
+ *           random erase, write and read rounds are compared with a reference image. The part which uses the new page
+ *           size after power cycle must be rejected without any data command. Build and run it on Linux from the
+ *           repository root, e.g.
+ *           gcc -Isrc/SUFD/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c tools/sim/sim_dataflash.c
+ *               -o sim_dataflash && ./sim_dataflash
+ * Created on: 2026-10-19
+ */
+
+#include <sfud.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLASH_SIZE                               (2 * 1024 * 1024)
+#define PAGE_SIZE                                512
+/* the random erase, write and read rounds */
+#define ROUND_NUM                                2000
+#define ROUND_MAX_SIZE                           5000
+
+/* the mocked AT45DB161E */
+static struct {
+    uint8_t mem[FLASH_SIZE];
+    uint8_t buf[2][PAGE_SIZE];
+    bool binary_page;                            /**< the binary (power of 2) page size is used */
+    bool config_after_power_cycle;               /**< the page size configuration is used after power cycle */
+    int busy;                                    /**< the status reads until ready */
+    int page_configs;                            /**< page size configuration commands */
+    int data_cmds;                               /**< buffer, page, erase and read commands */
+    int dataflash_data_cmds;                     /**< data commands on the DataFlash page size */
+    int programs;                                /**< buffer to main memory page programs */
+    int loads;                                   /**< main memory page to buffer loads */
+} chip;
+
+static uint8_t ref[FLASH_SIZE];
+
+static sfud_err spi_write_read(const sfud_spi *spi, const uint8_t *write_buf, size_t write_size, uint8_t *read_buf,
+        size_t read_size) {
+    static const uint8_t config_cmd[] = { 0x3D, 0x2A, 0x80, 0xA6 };
+    uint32_t addr = write_size >= 4 ? (write_buf[1] << 16 | write_buf[2] << 8 | write_buf[3]) : 0;
+    size_t i;
+
+    switch (write_buf[0]) {
+    case 0x84: case 0x87: case 0x88: case 0x89: case 0x53: case 0x55: case 0x81: case 0x03:
+        chip.data_cmds++;
+        if (!chip.binary_page) {
+            /* the address is the DataFlash page and offset, it's not the linear address */
+            chip.dataflash_data_cmds++;
+            return SFUD_SUCCESS;
+        }
+        break;
+    }
+    switch (write_buf[0]) {
+    case 0x9F:
+        read_buf[0] = 0x1F;
+        read_buf[1] = 0x26;
+        read_buf[2] = 0x00;
+        break;
+    case 0xD7:
+        read_buf[0] = (chip.busy-- > 0 ? 0x00 : 0x80) | (chip.binary_page ? 0x01 : 0x00);
+        break;
+    case 0x3D:
+        if (write_size == sizeof(config_cmd) && !memcmp(write_buf, config_cmd, sizeof(config_cmd))) {
+            chip.page_configs++;
+            chip.binary_page = !chip.config_after_power_cycle;
+            chip.busy = 10;
+        }
+        break;
+    case 0x84: case 0x87:
+        for (i = 4; i < write_size; i++) {
+            chip.buf[write_buf[0] == 0x87][(addr + i - 4) % PAGE_SIZE] = write_buf[i];
+        }
+        break;
+    case 0x88: case 0x89:
+        for (i = 0; i < PAGE_SIZE; i++) {
+            chip.mem[addr - addr % PAGE_SIZE + i] &= chip.buf[write_buf[0] == 0x89][i];
+        }
+        chip.programs++;
+        chip.busy = 3;
+        break;
+    case 0x53: case 0x55:
+        memcpy(chip.buf[write_buf[0] == 0x55], &chip.mem[addr - addr % PAGE_SIZE], PAGE_SIZE);
+        chip.loads++;
+        chip.busy = 2;
+        break;
+    case 0x81:
+        memset(&chip.mem[addr - addr % PAGE_SIZE], 0xFF, PAGE_SIZE);
+        chip.busy = 5;
+        break;
+    case 0x03:
+        memcpy(read_buf, &chip.mem[addr], read_size);
+        break;
+    case 0x5A:
+        /* no SFDP */
+        memset(read_buf, 0xFF, read_size);
+        break;
+    default:
+        break;
+    }
+
+    return SFUD_SUCCESS;
+}
+
+static void retry_delay(void) {
+}
+
+sfud_err sfud_spi_port_init(sfud_flash *flash) {
+    flash->spi.wr = spi_write_read;
+    flash->retry.delay = retry_delay;
+    flash->retry.times = 1000;
+
+    return SFUD_SUCCESS;
+}
+
+sfud_err sfud_port_read_param_cache(const sfud_flash *flash, uint8_t *buf, size_t size) {
+    memset(buf, 0, size);
+
+    return SFUD_SUCCESS;
+}
+
+sfud_err sfud_port_write_param_cache(const sfud_flash *flash, const uint8_t *buf, size_t size) {
+    return SFUD_SUCCESS;
+}
+
+void sfud_log_debug(const char *file, const long line, const char *format, ...) {
+}
+
+void sfud_log_info(const char *format, ...) {
+}
+
+/**
+ * power on the mocked part which is shipped on the DataFlash page size
+ */
+static void power_on(bool config_after_power_cycle) {
+    memset(&chip, 0, sizeof(chip));
+    memset(chip.mem, 0xFF, sizeof(chip.mem));
+    chip.config_after_power_cycle = config_after_power_cycle;
+}
+
+static int random_rounds(const sfud_flash *flash) {
+    static uint8_t data[ROUND_MAX_SIZE], saved[ROUND_MAX_SIZE];
+    uint32_t addr, i;
+    size_t size;
+    int round;
+
+    memset(ref, 0xFF, sizeof(ref));
+    srand(1);
+    for (round = 0; round < ROUND_NUM; round++) {
+        addr = rand() % (FLASH_SIZE - ROUND_MAX_SIZE);
+        size = 1 + rand() % ROUND_MAX_SIZE;
+        for (i = 0; i < size; i++) {
+            data[i] = rand();
+        }
+        if (rand() % 2) {
+            if (sfud_erase(flash, addr, size) != SFUD_SUCCESS) {
+                printf("erase failed on round %d\n", round);
+                return -1;
+            }
+            for (i = addr - addr % PAGE_SIZE; i < (addr + size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE; i++) {
+                ref[i] = 0xFF;
+            }
+        }
+        if (sfud_write(flash, addr, size, data) != SFUD_SUCCESS
+                || sfud_read(flash, addr, size, saved) != SFUD_SUCCESS) {
+            printf("write or read failed on round %d\n", round);
+            return -1;
+        }
+        for (i = 0; i < size; i++) {
+            ref[addr + i] &= data[i];
+        }
+        if (memcmp(saved, &ref[addr], size)) {
+            printf("read data is different on round %d\n", round);
+            return -1;
+        }
+    }
+    if (memcmp(chip.mem, ref, sizeof(ref))) {
+        printf("the flash is different from the reference\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(void) {
+    sfud_flash flash = { .name = "AT45DB161E", .spi.name = "SPI" };
+    sfud_flash flash2 = { .name = "AT45DB161E", .spi.name = "SPI" };
+
+    /* the page size is configured on the first initialization, then it's kept */
+    power_on(false);
+    if (sfud_device_init(&flash) != SFUD_SUCCESS || chip.page_configs != 1 || !chip.binary_page) {
+        printf("the part is not configured to the binary page size\n");
+        return 1;
+    }
+    if (random_rounds(&flash)) {
+        return 1;
+    }
+    if (sfud_device_init(&flash) != SFUD_SUCCESS || chip.page_configs != 1) {
+        printf("the binary page size is configured again\n");
+        return 1;
+    }
+    printf("configured part: page programs %d, page loads %d, DataFlash page data commands %d\n", chip.programs,
+            chip.loads, chip.dataflash_data_cmds);
+    if (chip.dataflash_data_cmds) {
+        return 1;
+    }
+
+    /* the part which uses the new page size after power cycle is rejected */
+    power_on(true);
+    if (sfud_device_init(&flash2) == SFUD_SUCCESS || chip.data_cmds) {
+        printf("the part on the DataFlash page size is not rejected\n");
+        return 1;
+    }
+    printf("power cycle part: rejected, data commands %d\n", chip.data_cmds);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Function: Simulator test of the EasyFlash ENV name Bloom filter on the boot workload. 300 keys are set, then the
+ *           boot loads the ENV, gets 50 present keys and probes 500 absent optional keys. The simulated time and the
+ *           read commands of the boot are printed. Build it with the default EF_ENV_BLOOM_BITS and with
+ *           -DEF_ENV_BLOOM_BITS=0 (no Bloom filter), and run them on Linux from the repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc [-DEF_ENV_BLOOM_BITS=0]
+ *               src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c
+ *               src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c
+ *               src/easyflash/src/ef_utils.c tools/sim/sim_env_bloom.c -o sim_env_bloom && ./sim_env_bloom
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <string.h>
+
+/* the ENV keys */
+#define KEY_NUM                                  300
+/* the present keys which are got on boot, every KEY_NUM / PRESENT_NUM key */
+#define PRESENT_NUM                              50
+/* the absent optional keys which are probed on boot */
+#define ABSENT_NUM                               500
+
+/* the Bloom filter size is set by the -D option, the default is on ef_env.c */
+#if defined(EF_ENV_BLOOM_BITS) && EF_ENV_BLOOM_BITS == 0
+#define BLOOM_NAME                               "without Bloom filter:"
+#else
+#define BLOOM_NAME                               "with Bloom filter:"
+#endif
+
+static void make_value(char *value, size_t size, int index) {
+    snprintf(value, size, "%d", index * 7);
+}
+
+int main(void) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    char key[24], value[24], *saved;
+    uint64_t start, loaded, end;
+    int i;
+
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed\n");
+        return 1;
+    }
+    ef_env_set_default();
+    for (i = 0; i < KEY_NUM; i++) {
+        snprintf(key, sizeof(key), "cfg.item%d", i);
+        make_value(value, sizeof(value), i);
+        if (ef_set_env(key, value) != EF_NO_ERR) {
+            printf("set %s failed\n", key);
+            return 1;
+        }
+    }
+
+    /* the boot */
+    sfud_sim_clear_stats(sim);
+    start = sfud_sim_get_time();
+    if (ef_load_env() != EF_NO_ERR) {
+        printf("load failed\n");
+        return 1;
+    }
+    loaded = sfud_sim_get_time();
+    for (i = 0; i < PRESENT_NUM; i++) {
+        snprintf(key, sizeof(key), "cfg.item%d", i * (KEY_NUM / PRESENT_NUM));
+        make_value(value, sizeof(value), i * (KEY_NUM / PRESENT_NUM));
+        saved = ef_get_env(key);
+        if (!saved || strcmp(saved, value)) {
+            printf("%s is %s, expect %s\n", key, saved ? saved : "(null)", value);
+            return 1;
+        }
+    }
+    for (i = 0; i < ABSENT_NUM; i++) {
+        snprintf(key, sizeof(key), "opt.feature%d", i);
+        if (ef_get_env(key)) {
+            printf("%s is found, it's not set\n", key);
+            return 1;
+        }
+    }
+    end = sfud_sim_get_time();
+
+    printf("%-22s load %4lu ms, lookups %5lu ms, boot %5lu ms, read commands %6lu\n", BLOOM_NAME,
+            (unsigned long) ((loaded - start) / 1000000), (unsigned long) ((end - loaded) / 1000000),
+            (unsigned long) ((end - start) / 1000000), (unsigned long) sim->stats.read_cmds);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Function: Simulator test of the EasyFlash default ENV image. The image which is built by tools/ef_image is restored
+ *           on the first boot, then the broken image is rejected by its CRC32 and the default ENV are created one by
+ *           one. The ENV of both ways must be same, and the page programs and the simulated time are compared.
+ *           Build and run it on Linux from the repository root, e.g.
+ *           gcc -DENV_AREA_SIZE=65536 -Itools/ef_image -Isrc/easyflash/inc tools/ef_image/ef_image.c
+ *               tools/ef_image/ef_image_port.c src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c
+ *               src/easyflash/src/ef_utils.c -o ef_image && ./ef_image tools/ef_image/default_env.txt env.img
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc -DEF_ENV_DEFAULT_IMAGE_ADDR="(0x100000)"
+ *               src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c
+ *               src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c
+ *               src/easyflash/src/ef_utils.c tools/sim/sim_env_image.c -o sim_env_image && ./sim_env_image env.img
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef EF_ENV_DEFAULT_IMAGE_ADDR
+#error "Please define EF_ENV_DEFAULT_IMAGE_ADDR by the -D option"
+#endif
+
+#define IMAGE_SIZE                               (ENV_AREA_SIZE + sizeof(struct ef_env_image_trailer))
+#define VALUE_MAX_SIZE                           64
+
+/* the default ENV of src/easyflash/src/ef_port.c and tools/ef_image/default_env.txt */
+static const char *keys[] = { "iap_need_copy_app", "iap_copy_app_size", "stop_in_bootloader", "device_id",
+        "boot_times" };
+#define KEY_NUM                                  (sizeof(keys) / sizeof(keys[0]))
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t values[KEY_NUM][VALUE_MAX_SIZE];
+static size_t value_lens[KEY_NUM];
+
+/**
+ * ENV set default, then print the page programs and the simulated time of it
+ */
+static void set_default(const char *name, sfud_sim *sim) {
+    uint64_t time;
+
+    sfud_sim_clear_stats(sim);
+    time = sfud_sim_get_time();
+    ef_env_set_default();
+    time = sfud_sim_get_time() - time;
+    printf("%-16s page programs %3lu, erase commands %2lu, time %4lu ms\n", name,
+            (unsigned long) sim->stats.program_cmds,
+            (unsigned long) (sim->stats.erase_4k + sim->stats.erase_32k + sim->stats.erase_64k),
+            (unsigned long) (time / 1000000));
+}
+
+/**
+ * save the default ENV values, or check them with the saved values
+ */
+static int check_env(const char *name, bool save) {
+    uint8_t value[VALUE_MAX_SIZE];
+    size_t i, len, saved_len;
+
+    for (i = 0; i < KEY_NUM; i++) {
+        len = ef_get_env_blob(keys[i], value, sizeof(value), &saved_len);
+        if (len == 0 || len != saved_len) {
+            printf("%s: %s is not found\n", name, keys[i]);
+            return -1;
+        }
+        if (save) {
+            memcpy(values[i], value, len);
+            value_lens[i] = len;
+        } else if (len != value_lens[i] || memcmp(value, values[i], len)) {
+            printf("%s: %s has the different value\n", name, keys[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int program_image(const sfud_flash *flash) {
+    return sfud_erase_write(flash, EF_ENV_DEFAULT_IMAGE_ADDR, IMAGE_SIZE, image) == SFUD_SUCCESS ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    const sfud_flash *flash;
+    uint8_t broken;
+    FILE *fp;
+
+    if (argc != 2) {
+        printf("Usage: %s <image>\n", argv[0]);
+        return 1;
+    }
+    fp = fopen(argv[1], "rb");
+    if (!fp || fread(image, 1, sizeof(image), fp) != sizeof(image) || fgetc(fp) != EOF) {
+        printf("the image %s must be %lu bytes, please check ENV_AREA_SIZE of tools/ef_image\n", argv[1],
+                (unsigned long) IMAGE_SIZE);
+        return 1;
+    }
+    fclose(fp);
+    if (sfud_init() != SFUD_SUCCESS) {
+        printf("SFUD initialize failed\n");
+        return 1;
+    }
+    flash = sfud_get_device(SFUD_XXXX_DEVICE_INDEX);
+    if (program_image(flash)) {
+        printf("program the image failed\n");
+        return 1;
+    }
+
+    /* the erased ENV area is set default by the image on the first boot */
+    if (easyflash_init() != EF_NO_ERR || check_env("image", true)) {
+        return 1;
+    }
+    set_default("image:", sim);
+    if (check_env("image", false)) {
+        return 1;
+    }
+
+    /* the image which has one broken byte is rejected, the default ENV are created one by one */
+    broken = 0x00;
+    sfud_write(flash, EF_ENV_DEFAULT_IMAGE_ADDR + ENV_AREA_SIZE - 1, 1, &broken);
+    set_default("one by one:", sim);
+    if (check_env("one by one", false)) {
+        return 1;
+    }
+
+    /* the restored ENV is writable and loaded again */
+    if (program_image(flash)) {
+        printf("program the image failed\n");
+        return 1;
+    }
+    ef_env_set_default();
+    if (ef_set_env("device_id", "2") != EF_NO_ERR) {
+        printf("set device_id failed\n");
+        return 1;
+    }
+    ef_load_env();
+    if (!ef_get_env("device_id") || strcmp(ef_get_env("device_id"), "2")) {
+        printf("device_id is not changed after loading\n");
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Function: Simulator test of the EasyFlash ENV loading time. 500 keys are set and updated, then the ENV is loaded
+ *           and every key is checked. When EF_ENV_CHECKPOINT_ADDR is defined, the ENV is also loaded after the idle
+ *           checkpoint, and after one more ENV set which makes the checkpoint stale. Build it with and without the
+ *           checkpoint and run them on Linux from the repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc [-DEF_ENV_CHECKPOINT_ADDR="(0x40000)"]
+ *               src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c
+ *               src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c
+ *               src/easyflash/src/ef_utils.c tools/sim/sim_env_load.c -o sim_env_load && ./sim_env_load
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the ENV keys */
+#define KEY_NUM                                  500
+/* the updates of the random keys after all keys are set */
+#define UPDATE_NUM                               300
+#define VALUE_MAX_SIZE                           40
+
+static char values[KEY_NUM][VALUE_MAX_SIZE];
+
+/**
+ * load the ENV, then print the simulated time and the read commands of it and check every key
+ */
+static int load(const char *name, sfud_sim *sim) {
+    char key[16], *saved;
+    uint64_t time;
+    int i;
+
+    sfud_sim_clear_stats(sim);
+    time = sfud_sim_get_time();
+    if (ef_load_env() != EF_NO_ERR) {
+        printf("%s: load failed\n", name);
+        return -1;
+    }
+    time = sfud_sim_get_time() - time;
+    printf("%-28s load time %6.1f ms, read commands %5lu, read bytes %6lu\n", name, time / 1000000.0,
+            (unsigned long) sim->stats.read_cmds, (unsigned long) sim->stats.read_bytes);
+
+    for (i = 0; i < KEY_NUM; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        saved = ef_get_env(key);
+        if (!saved || strcmp(saved, values[i])) {
+            printf("%s: %s is %s, expect %s\n", name, key, saved ? saved : "(null)", values[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int set_value(int index, int update) {
+    char key[16];
+
+    snprintf(key, sizeof(key), "key%d", index);
+    snprintf(values[index], VALUE_MAX_SIZE, "%0*d", 1 + rand() % 24, update);
+
+    return ef_set_env(key, values[index]) == EF_NO_ERR ? 0 : -1;
+}
+
+int main(void) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    int i;
+
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed\n");
+        return 1;
+    }
+    ef_env_set_default();
+    srand(7);
+    for (i = 0; i < KEY_NUM + UPDATE_NUM; i++) {
+        if (set_value(i < KEY_NUM ? i : rand() % KEY_NUM, i)) {
+            printf("set ENV failed\n");
+            return 1;
+        }
+    }
+
+#ifdef EF_ENV_CHECKPOINT_ADDR
+    if (load("checkpoint, not saved:", sim)) {
+        return 1;
+    }
+    /* the checkpoint is saved on the idle time */
+    if (ef_env_checkpoint() != EF_NO_ERR) {
+        printf("save checkpoint failed\n");
+        return 1;
+    }
+    if (load("checkpoint, saved:", sim)) {
+        return 1;
+    }
+    if (set_value(1, i) || load("checkpoint, stale:", sim)) {
+        return 1;
+    }
+#else
+    if (load("no checkpoint:", sim)) {
+        return 1;
+    }
+#endif
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Function: Simulator test of the EasyFlash ENV GC policies. The ENV area is about 60% full, then the ENV are updated
+ *           with the skewed hot, warm and cold keys. The write amplification (programmed bytes / user bytes), the
+ *           erases and the most worn sector are compared on every GC policy. Build and run it on Linux from the
+ *           repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c
+ *               src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c src/easyflash/src/easyflash.c
+ *               src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c src/easyflash/src/ef_utils.c
+ *               tools/sim/sim_gc_policy.c -o sim_gc_policy && ./sim_gc_policy [updates]
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the default ENV updates of every policy */
+#define UPDATE_NUM                               50000
+/* the ENV keys, they fill about 60% of the ENV area */
+#define KEY_NUM                                  200
+#define INIT_VALUE_SIZE                          160
+/* the updated value size is from VALUE_MIN_SIZE to VALUE_MIN_SIZE + VALUE_RANGE - 1 */
+#define VALUE_MIN_SIZE                           100
+#define VALUE_RANGE                              120
+
+#define ENV_SECTOR_NUM                           (ENV_AREA_SIZE / EF_ERASE_MIN_SIZE)
+#define SIM_SECTORS_PER_ENV_SECTOR               (EF_ERASE_MIN_SIZE / 4096)
+
+static uint32_t rand_seed;
+
+/* the same random sequence on every policy */
+static uint32_t next_rand(void) {
+    rand_seed = rand_seed * 1103515245 + 12345;
+
+    return rand_seed >> 8;
+}
+
+/**
+ * 80% of the updates are on 10% of the keys (hot), 15% are on 30% (warm), and 5% are on 60% (cold)
+ */
+static uint32_t next_key(void) {
+    uint32_t r = next_rand() % 100;
+
+    if (r < 80) {
+        return next_rand() % (KEY_NUM / 10);
+    } else if (r < 95) {
+        return KEY_NUM / 10 + next_rand() % (KEY_NUM * 3 / 10);
+    } else {
+        return KEY_NUM * 4 / 10 + next_rand() % (KEY_NUM * 6 / 10);
+    }
+}
+
+static int run(const char *name, EfGcPolicy policy, sfud_sim *sim, long updates) {
+    uint8_t value[VALUE_MIN_SIZE + VALUE_RANGE], saved[sizeof(value)];
+    uint32_t key_id, len, count, max = 0, total = 0, last_len[KEY_NUM];
+    uint8_t last_byte[KEY_NUM];
+    uint64_t user_bytes = 0;
+    char key[16];
+    size_t sec;
+    long i;
+
+    /* every run is started from the erased ENV area */
+    memset(sim->array + EF_START_ADDR, 0xFF, ENV_AREA_SIZE);
+    ef_env_set_default();
+    ef_env_set_gc_policy(policy);
+    rand_seed = 12345;
+    for (key_id = 0; key_id < KEY_NUM; key_id++) {
+        snprintf(key, sizeof(key), "k%lu", (unsigned long) key_id);
+        memset(value, key_id, INIT_VALUE_SIZE);
+        if (ef_set_env_blob(key, value, INIT_VALUE_SIZE) != EF_NO_ERR) {
+            printf("%s: set %s failed\n", name, key);
+            return -1;
+        }
+        last_len[key_id] = INIT_VALUE_SIZE;
+        last_byte[key_id] = key_id;
+    }
+    sfud_sim_clear_stats(sim);
+    memset(sim->erase_count, 0, ENV_SECTOR_NUM * SIM_SECTORS_PER_ENV_SECTOR * sizeof(uint32_t));
+    for (i = 0; i < updates; i++) {
+        key_id = next_key();
+        snprintf(key, sizeof(key), "k%lu", (unsigned long) key_id);
+        len = VALUE_MIN_SIZE + next_rand() % VALUE_RANGE;
+        memset(value, i, len);
+        if (ef_set_env_blob(key, value, len) != EF_NO_ERR) {
+            printf("%s: set %s failed on update %ld\n", name, key, i);
+            return -1;
+        }
+        last_len[key_id] = len;
+        last_byte[key_id] = i;
+        user_bytes += len + strlen(key);
+    }
+    /* the last value of every key is read back from flash */
+    ef_load_env();
+    for (key_id = 0; key_id < KEY_NUM; key_id++) {
+        snprintf(key, sizeof(key), "k%lu", (unsigned long) key_id);
+        memset(value, last_byte[key_id], last_len[key_id]);
+        if (ef_get_env_blob(key, saved, sizeof(saved), NULL) != last_len[key_id]
+                || memcmp(saved, value, last_len[key_id])) {
+            printf("%s: %s has the wrong value\n", name, key);
+            return -1;
+        }
+    }
+    for (sec = 0; sec < ENV_SECTOR_NUM; sec++) {
+        count = sim->erase_count[(EF_START_ADDR + sec * EF_ERASE_MIN_SIZE) / 4096];
+        total += count;
+        if (count > max) {
+            max = count;
+        }
+    }
+    printf("%-16s WA %.2f, erases %5lu, max wear %4lu\n", name, (double) sim->stats.program_bytes / user_bytes,
+            (unsigned long) total, (unsigned long) max);
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    long updates = argc > 1 ? atol(argv[1]) : UPDATE_NUM;
+
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed\n");
+        return 1;
+    }
+    printf("%ld updates of %d ENV\n", updates, KEY_NUM);
+    if (run("greedy:", EF_GC_POLICY_GREEDY, sim, updates)
+            || run("age-weighted:", EF_GC_POLICY_AGE_WEIGHTED, sim, updates)) {
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
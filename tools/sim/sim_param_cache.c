@@ -0,0 +1,74 @@
+/*
+ * Function: Simulator test of the SFUD flash parameter cache. The flash is initialized twice, the first boot probes
+ *           the SFDP and saves the parameter cache, the second boot loads the parameters from the cache. The SPI
+ *           transactions and the bus time from sfud_device_init to flash ready are printed, and the cached parameters
+ *           must be same as the probed. SFUD_USING_PARAM_CACHE must be defined on sfud_cfg.h. Build and run it on
+ *           Linux from the repository root, e.g.
+ *           gcc -Isrc/SUFD/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c
+ *               src/SUFD/src/sfud_sim_port.c tools/sim/sim_param_cache.c -o sim_param_cache && ./sim_param_cache
+ * Created on: 2026-10-19
+ */
+
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef SFUD_USING_PARAM_CACHE
+#error "Please define SFUD_USING_PARAM_CACHE on sfud_cfg.h"
+#endif
+
+/**
+ * initialize the flash, then print the SPI transactions, the bus time and the simulated time of it
+ */
+static int boot(const char *name, sfud_flash *flash, sfud_sim *sim) {
+    uint64_t time;
+
+    sfud_sim_clear_stats(sim);
+    time = sfud_sim_get_time();
+    if (sfud_device_init(flash) != SFUD_SUCCESS) {
+        printf("%s: initialize failed\n", name);
+        return -1;
+    }
+    time = sfud_sim_get_time() - time;
+    printf("%-14s transactions %2lu, SFDP reads %2lu, bus time %3lu us, time to ready %4lu us\n", name,
+            (unsigned long) sim->stats.transactions, (unsigned long) sim->stats.sfdp_reads,
+            (unsigned long) (sim->stats.bus_ns / 1000), (unsigned long) (time / 1000));
+
+    return 0;
+}
+
+int main(void) {
+    sfud_flash *flash = sfud_get_device(SFUD_XXXX_DEVICE_INDEX);
+    sfud_sim *sim = sfud_sim_port_get_device(flash->spi.name);
+    sfud_flash_chip chip;
+    sfud_sfdp sfdp;
+
+    /* the parameter cache is empty on the first boot */
+    if (boot("first boot:", flash, sim)) {
+        return 1;
+    }
+    if (sim->stats.sfdp_reads == 0) {
+        printf("the SFDP is not probed on the first boot\n");
+        return 1;
+    }
+    chip = flash->chip;
+    sfdp = flash->sfdp;
+    memset(&flash->chip, 0, sizeof(flash->chip));
+    memset(&flash->sfdp, 0, sizeof(flash->sfdp));
+
+    if (boot("cached boot:", flash, sim)) {
+        return 1;
+    }
+    if (sim->stats.sfdp_reads != 0) {
+        printf("the SFDP is probed again, the cache is not used\n");
+        return 1;
+    }
+    if (memcmp(&chip, &flash->chip, sizeof(chip)) || memcmp(&sfdp, &flash->sfdp, sizeof(sfdp))) {
+        printf("the cached parameters are not same as the probed\n");
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,367 @@
+/*
+ * Function: Simulator test of the EasyFlash ENV power failure. The workload has the small and combined (larger than
+ *           one sector) ENV sets, deletes, transactions and checkpoints. It's cut by the power on every trial budget
+ *           of programmed bytes and erased sectors, then the torn flash is loaded by a new process. Every ENV must
+ *           have the old or the new value of the cut operation, and the transaction must be all or nothing. The
+ *           second loading uses the checkpoint which is saved after the first one, then the ENV must be writable.
+ *           Build and run it on Linux from the repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc -DEF_ENV_CHECKPOINT_ADDR="(0x40000)"
+ *               src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c
+ *               src/easyflash/src/easyflash.c src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c
+ *               src/easyflash/src/ef_utils.c tools/sim/sim_power_fail.c -o sim_power_fail
+ *           && ./sim_power_fail [trials] [budget], the single trial of the budget prints the EasyFlash log.
+ * Created on: 2026-10-19
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <easyflash.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* the operations of the workload */
+#define OP_NUM                                   150
+/* the default power cut trials */
+#define TRIAL_NUM                                1000
+/* the flash which is saved on power cut, it has the ENV area and the checkpoint sector */
+#define SNAPSHOT_SIZE                            (512 * 1024)
+/* the combined ENV size is from COMBINED_MIN_SIZE to COMBINED_MIN_SIZE + 3 * COMBINED_STEP_SIZE */
+#define COMBINED_MIN_SIZE                        5000
+#define COMBINED_STEP_SIZE                       1500
+#define VALUE_MAX_SIZE                           (COMBINED_MIN_SIZE + 3 * COMBINED_STEP_SIZE)
+
+enum {
+    OP_SET_SMALL,
+    OP_SET_COMBINED,
+    OP_DEL,
+    OP_TXN,
+    OP_CHECKPOINT,
+};
+
+/* the keys of the model, the transaction uses the last TXN_KEY_NUM keys */
+#define SMALL_KEY_NUM                            6
+#define COMBINED_KEY_NUM                         2
+#define TXN_KEY_NUM                              3
+#define KEY_NUM                                  (SMALL_KEY_NUM + COMBINED_KEY_NUM + TXN_KEY_NUM)
+
+static const char *keys[KEY_NUM] = { "s0", "s1", "s2", "s3", "s4", "s5", "b0", "b1", "t0", "t1", "t2" };
+
+/* the shared memory between the workload and the verifier processes */
+static struct {
+    uint8_t flash[SNAPSHOT_SIZE];
+    int cut_op;                                  /* the operation which is cut, OP_NUM: not cut */
+    uint64_t used;                               /* the used power budget of the workload */
+} *shared;
+
+static int cur_op;
+/* the EasyFlash log is printed on the single trial */
+static bool verbose;
+
+/**
+ * the operation is made by its index, so the model is replayed without the flash
+ */
+static int op_type(int op) {
+    unsigned int r = (unsigned int) op * 2654435761u;
+
+    r ^= r >> 13;
+    switch (r % 10) {
+    case 0: case 1: case 2: case 3: return OP_SET_SMALL;
+    case 4: case 5: return OP_SET_COMBINED;
+    case 6: return OP_DEL;
+    case 7: case 8: return OP_TXN;
+    default: return OP_CHECKPOINT;
+    }
+}
+
+/**
+ * the key of the set or delete operation
+ */
+static int op_key(int op) {
+    switch (op_type(op)) {
+    case OP_SET_SMALL: return op % SMALL_KEY_NUM;
+    case OP_SET_COMBINED: return SMALL_KEY_NUM + op % COMBINED_KEY_NUM;
+    case OP_DEL: return op % (SMALL_KEY_NUM + COMBINED_KEY_NUM);
+    default: return -1;
+    }
+}
+
+/**
+ * the value of the key which is written by the operation
+ */
+static size_t make_value(int key, int op, uint8_t *buf) {
+    size_t size, i;
+
+    if (key >= SMALL_KEY_NUM && key < SMALL_KEY_NUM + COMBINED_KEY_NUM) {
+        size = COMBINED_MIN_SIZE + (op % 4) * COMBINED_STEP_SIZE;
+        for (i = 0; i < size; i++) {
+            buf[i] = (uint8_t) (op * 31 + key * 7 + i);
+        }
+    } else {
+        size = snprintf((char *) buf, VALUE_MAX_SIZE, "%s-value-%d", keys[key], op);
+    }
+
+    return size;
+}
+
+/**
+ * apply the operation on the model, the model has the operation of the last written value, -1: absent
+ */
+static void apply_op(int op, int *model) {
+    int i;
+
+    switch (op_type(op)) {
+    case OP_SET_SMALL:
+    case OP_SET_COMBINED:
+        model[op_key(op)] = op;
+        break;
+    case OP_DEL:
+        model[op_key(op)] = -1;
+        break;
+    case OP_TXN:
+        for (i = KEY_NUM - TXN_KEY_NUM; i < KEY_NUM; i++) {
+            model[i] = op;
+        }
+        break;
+    }
+}
+
+static EfErrCode run_op(int op) {
+    static uint8_t value[VALUE_MAX_SIZE], txn_value[TXN_KEY_NUM][VALUE_MAX_SIZE];
+    EfErrCode result = EF_NO_ERR;
+    size_t size;
+    int i;
+
+    switch (op_type(op)) {
+    case OP_SET_SMALL:
+    case OP_SET_COMBINED:
+        size = make_value(op_key(op), op, value);
+        result = ef_set_env_blob(keys[op_key(op)], value, size);
+        break;
+    case OP_DEL:
+        result = ef_del_env(keys[op_key(op)]);
+        /* the absent ENV is not an error of the workload */
+        if (result == EF_ENV_NAME_ERR) {
+            result = EF_NO_ERR;
+        }
+        break;
+    case OP_TXN:
+        result = ef_txn_begin();
+        for (i = KEY_NUM - TXN_KEY_NUM; result == EF_NO_ERR && i < KEY_NUM; i++) {
+            /* the value is kept until the transaction is committed */
+            size = make_value(i, op, txn_value[i - (KEY_NUM - TXN_KEY_NUM)]);
+            result = ef_txn_set(keys[i], txn_value[i - (KEY_NUM - TXN_KEY_NUM)], size);
+        }
+        if (result == EF_NO_ERR) {
+            result = ef_txn_commit();
+        } else {
+            ef_txn_abort();
+        }
+        break;
+    case OP_CHECKPOINT:
+#ifdef EF_ENV_CHECKPOINT_ADDR
+        result = ef_env_checkpoint();
+#endif
+        break;
+    }
+
+    return result;
+}
+
+static void power_cut(sfud_sim *sim) {
+    memcpy(shared->flash, sim->array, SNAPSHOT_SIZE);
+    shared->cut_op = cur_op;
+    shared->used = sim->power.used;
+    _exit(0);
+}
+
+/**
+ * the workload process, it's cut by the power on the budget
+ */
+static int run_workload(uint64_t budget) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+
+    if (easyflash_init() != EF_NO_ERR) {
+        fprintf(stderr, "workload: EasyFlash initialize failed\n");
+        return 1;
+    }
+    sfud_sim_set_power_cut(sim, budget, power_cut);
+    for (cur_op = 0; cur_op < OP_NUM; cur_op++) {
+        if (run_op(cur_op) != EF_NO_ERR) {
+            fprintf(stderr, "workload: operation %d failed\n", cur_op);
+            return 1;
+        }
+    }
+    /* the buffered data is on flash */
+    sfud_write_buffer_flush(sfud_get_device(SFUD_XXXX_DEVICE_INDEX));
+    memcpy(shared->flash, sim->array, SNAPSHOT_SIZE);
+    shared->cut_op = OP_NUM;
+    shared->used = sim->power.used;
+
+    return 0;
+}
+
+/**
+ * check every ENV on the model before and after the cut operation
+ */
+static int check_env(const char *name, int cut_op, const int *before, const int *after) {
+    static uint8_t value[VALUE_MAX_SIZE], expect[VALUE_MAX_SIZE];
+    size_t size, expect_size;
+    int i, txn_new = -1, is_new;
+
+    for (i = 0; i < KEY_NUM; i++) {
+        size = ef_get_env_blob(keys[i], value, sizeof(value), NULL);
+        /* the old value is checked first, the unchanged ENV has the same old and new value */
+        for (is_new = 0; is_new < 2; is_new++) {
+            int op = is_new ? after[i] : before[i];
+
+            expect_size = op < 0 ? 0 : make_value(i, op, expect);
+            if (size == expect_size && !memcmp(value, expect, size)) {
+                break;
+            }
+        }
+        if (is_new == 2) {
+            fprintf(stderr, "%s: cut on operation %d, %s has the wrong value (%lu bytes)\n", name, cut_op, keys[i],
+                    (unsigned long) size);
+            return -1;
+        }
+        if (i >= KEY_NUM - TXN_KEY_NUM && before[i] != after[i]) {
+            if (txn_new >= 0 && txn_new != is_new) {
+                fprintf(stderr, "%s: cut on operation %d, the transaction is partly committed\n", name, cut_op);
+                return -1;
+            }
+            txn_new = is_new;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * the verifier process, the torn flash is loaded twice and it must be writable
+ */
+static int run_verifier(void) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    int before[KEY_NUM], after[KEY_NUM], i, op;
+
+    for (i = 0; i < KEY_NUM; i++) {
+        before[i] = -1;
+    }
+    for (op = 0; op < shared->cut_op; op++) {
+        apply_op(op, before);
+    }
+    memcpy(after, before, sizeof(after));
+    if (shared->cut_op < OP_NUM) {
+        apply_op(shared->cut_op, after);
+    }
+
+    memcpy(sim->array, shared->flash, SNAPSHOT_SIZE);
+    if (easyflash_init() != EF_NO_ERR) {
+        fprintf(stderr, "first loading: cut on operation %d, EasyFlash initialize failed\n", shared->cut_op);
+        return 1;
+    }
+    if (check_env("first loading", shared->cut_op, before, after)) {
+        return 1;
+    }
+#ifdef EF_ENV_CHECKPOINT_ADDR
+    /* the checkpoint is saved on the idle time after the first loading, it's not saved when any ENV is broken */
+    ef_env_checkpoint();
+#endif
+    /* the loading result is same, it's loaded by the checkpoint when it's enabled */
+    if (ef_load_env() != EF_NO_ERR || check_env("second loading", shared->cut_op, before, after)) {
+        return 1;
+    }
+    /* the ENV is writable after the recovery */
+    op = shared->cut_op < OP_NUM ? shared->cut_op + 1 : OP_NUM;
+    for (i = 0; i < KEY_NUM; i++, op++) {
+        uint8_t value[VALUE_MAX_SIZE];
+        size_t size = make_value(i, op, value);
+
+        if (ef_set_env_blob(keys[i], value, size) != EF_NO_ERR) {
+            fprintf(stderr, "written after loading: cut on operation %d, set %s failed\n", shared->cut_op, keys[i]);
+            return 1;
+        }
+        before[i] = after[i] = op;
+    }
+    if (ef_load_env() != EF_NO_ERR || check_env("written after loading", shared->cut_op, before, after)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * run the function on a new process, so every process has the new library state
+ */
+static int run_process(int (*fn)(uint64_t), uint64_t arg) {
+    int status;
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        /* the EasyFlash log is dropped, the test result is on stderr */
+        if (!verbose) {
+            freopen("/dev/null", "w", stdout);
+        }
+        status = fn(arg);
+        fflush(stdout);
+        _exit(status);
+    } else if (pid < 0) {
+        return -1;
+    }
+    waitpid(pid, &status, 0);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int run_verifier_process(uint64_t arg) {
+    return run_verifier();
+}
+
+int main(int argc, char *argv[]) {
+    int trials = argc > 1 ? atoi(argv[1]) : TRIAL_NUM, trial, cut_ops = 0;
+    uint64_t total;
+
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        fprintf(stderr, "mmap failed\n");
+        return 1;
+    }
+    /* the whole workload without the power cut */
+    if (run_process(run_workload, 0) || run_process(run_verifier_process, 0)) {
+        fprintf(stderr, "the workload without power cut failed\n");
+        return 1;
+    }
+    total = shared->used;
+    /* the single trial of the budget */
+    if (argc > 2) {
+        verbose = true;
+        if (run_process(run_workload, strtoull(argv[2], NULL, 0)) || run_process(run_verifier_process, 0)) {
+            return 1;
+        }
+        fprintf(stderr, "cut on operation %d\nOK\n", shared->cut_op);
+        return 0;
+    }
+    for (trial = 0; trial < trials; trial++) {
+        uint64_t budget = 1 + total * trial / trials + trial % 7;
+
+        if (run_process(run_workload, budget)) {
+            fprintf(stderr, "trial %d: the workload failed\n", trial);
+            return 1;
+        }
+        cut_ops += shared->cut_op < OP_NUM;
+        if (run_process(run_verifier_process, 0)) {
+            fprintf(stderr, "trial %d (budget %lu) failed\n", trial, (unsigned long) budget);
+            return 1;
+        }
+    }
+    fprintf(stderr, "%d trials, %d are cut, %lu programmed bytes and erased sectors of the workload\n", trials,
+            cut_ops, (unsigned long) total);
+    fprintf(stderr, "OK\n");
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Function: Simulator benchmark of the SFUD read chunk size. The interrupts are disabled by the port while the SPI is
+ *           locked, so the longest lock time is the interrupt latency. 64K is read by one sfud_read, then the read
+ *           time, the throughput and the longest lock time are printed. Build and run it on Linux from the repository
+ *           root for every chunk size (0: no limit), e.g.
+ *           for n in 0 1024 256 128 64; do gcc -Isrc/SUFD/inc -DSFUD_READ_MAX_CHUNK_SIZE=$n src/SUFD/src/sfud.c
+ *               src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c
+ *               tools/sim/sim_read_chunk.c -o sim_read_chunk && ./sim_read_chunk; done
+ * Created on: 2026-10-19
+ */
+
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <string.h>
+
+/* the read size */
+#define READ_SIZE                                (64 * 1024)
+
+static uint64_t lock_time, max_lock_ns;
+static uint32_t locks;
+
+static void spi_lock(const sfud_spi *spi) {
+    lock_time = sfud_sim_get_time();
+}
+
+static void spi_unlock(const sfud_spi *spi) {
+    uint64_t lock_ns = sfud_sim_get_time() - lock_time;
+
+    if (lock_ns > max_lock_ns) {
+        max_lock_ns = lock_ns;
+    }
+    locks++;
+}
+
+int main(void) {
+    static uint8_t data[READ_SIZE];
+    sfud_flash *flash = sfud_get_device(SFUD_XXXX_DEVICE_INDEX);
+    sfud_sim *sim = sfud_sim_port_get_device(flash->spi.name);
+    uint64_t time;
+    size_t i;
+
+    if (sfud_device_init(flash) != SFUD_SUCCESS) {
+        printf("initialize failed\n");
+        return 1;
+    }
+    for (i = 0; i < READ_SIZE; i++) {
+        sim->array[i] = (uint8_t) (i * 7 + (i >> 8));
+    }
+    /* the interrupts are disabled while the SPI is locked, like the port */
+    flash->spi.lock = spi_lock;
+    flash->spi.unlock = spi_unlock;
+
+    sfud_sim_clear_stats(sim);
+    time = sfud_sim_get_time();
+    if (sfud_read(flash, 0, READ_SIZE, data) != SFUD_SUCCESS) {
+        printf("read failed\n");
+        return 1;
+    }
+    time = sfud_sim_get_time() - time;
+    if (memcmp(data, sim->array, READ_SIZE)) {
+        printf("read data is different\n");
+        return 1;
+    }
+    printf("chunk %5d: 64K read %5.1f ms, %4.0f KB/s, read commands %4lu, max IRQ off %7.1f us\n",
+            SFUD_READ_MAX_CHUNK_SIZE, time / 1000000.0, READ_SIZE / 1024.0 / (time / 1000000000.0),
+            (unsigned long) sim->stats.read_cmds, max_lock_ns / 1000.0);
+    if (locks != sim->stats.read_cmds) {
+        printf("the SPI is not locked once for every read command\n");
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
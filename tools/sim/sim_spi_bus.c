@@ -0,0 +1,211 @@
+/*
+ * Function: Host test of the SPI bus arbiter on a mock port. The display lines are transferred by DMA, the SPI
+ *           flash commands run between them. The DMA of the mock port is finished after some bus operations, its
+ *           interrupt is taken only when the interrupts are enabled, like PRIMASK on Cortex-M. Build and run it on
+ *           Linux from the repository root, e.g.
+ *           gcc -Isrc/spi_bus/inc src/spi_bus/src/spi_bus.c tools/sim/sim_spi_bus.c -o sim_spi_bus && ./sim_spi_bus
+ * Created on: 2026-10-19
+ */
+
+#include <spi_bus.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the display lines of one refresh */
+#define LINE_NUM                                 10
+/* the display line size, it's transferred by DMA */
+#define LINE_SIZE                                240
+/* the bus operations of one DMA transfer */
+#define DMA_TICKS                                5
+/* the bus operations of one waiting, the waiting hangs when it's exceeded */
+#define HANG_TICKS                               100000
+
+static uint32_t primask, lock_depth, dma_ticks, wait_ticks;
+static bool dma_flag, nested_isr;
+/* the transfer order, one character for every transfer of the device, '|' is the first flash command */
+static char order[256];
+
+static spi_bus mock_bus;
+static uint8_t dummy_cs;
+static spi_bus_device display = { "display", NULL, SPI_BUS_MODE_0, 2, &dummy_cs, 1, 1 };
+static spi_bus_device flash = { "flash", NULL, SPI_BUS_MODE_0, 4, &dummy_cs, 2, 0 };
+/* it has no CS pin, like spi2_read_write_byte on BSP */
+static spi_bus_device bsp = { "bsp", NULL, SPI_BUS_MODE_3, 256, NULL, 0, 2 };
+
+static void record(char c) {
+    size_t len = strlen(order);
+
+    if (len + 1 < sizeof(order)) {
+        order[len] = c;
+    }
+}
+
+/**
+ * check the transfer order: every flash command waits for one running line at most, the lines which are not
+ * transferred before the flash commands are transferred after them, then the BSP device
+ */
+static bool check_order(void) {
+    const char *pos = strchr(order, '|'), *flash_cmd[] = { "f", "f", "ff" };
+    size_t i, lines = 0;
+
+    if (!pos) {
+        return false;
+    }
+    for (i = 0; i < strlen(order); i++) {
+        lines += order[i] == 'd';
+    }
+    for (pos++, i = 0; i < sizeof(flash_cmd) / sizeof(flash_cmd[0]); i++) {
+        pos += *pos == 'd';
+        if (strncmp(pos, flash_cmd[i], strlen(flash_cmd[i]))) {
+            return false;
+        }
+        pos += strlen(flash_cmd[i]);
+    }
+    pos += strspn(pos, "d");
+
+    return lines == LINE_NUM && !strcmp(pos, "bb");
+}
+
+static void mock_configure(spi_bus *bus, uint8_t mode, uint32_t prescaler) {
+}
+
+static void mock_cs(const spi_bus_device *dev, bool select) {
+    if (!dev->cs_port) {
+        printf("the device %s has no CS pin, but it's selected by arbiter\n", dev->name);
+        exit(1);
+    }
+}
+
+static spi_bus_err mock_transfer(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size) {
+    record((bus->owner ? bus->owner : bus->running->dev)->name[0]);
+    if (rx_buf) {
+        memset(rx_buf, tx_buf ? tx_buf[0] : 0xFF, size);
+    }
+
+    return SPI_BUS_SUCCESS;
+}
+
+static spi_bus_err mock_transfer_dma(spi_bus *bus, const uint8_t *tx_buf, uint8_t *rx_buf, size_t size) {
+    record(bus->running->dev->name[0]);
+    dma_ticks = DMA_TICKS;
+
+    return SPI_BUS_SUCCESS;
+}
+
+static void mock_poll(spi_bus *bus) {
+    if (dma_flag) {
+        dma_flag = false;
+        spi_bus_dma_done(bus, SPI_BUS_SUCCESS);
+    }
+}
+
+static uint32_t mock_lock(spi_bus *bus) {
+    uint32_t level = primask;
+
+    primask = 1;
+    lock_depth++;
+    /* the DMA transfer is going on */
+    if (dma_ticks && --dma_ticks == 0) {
+        dma_flag = true;
+    }
+    if (++wait_ticks > HANG_TICKS) {
+        printf("the bus waiting is hung, the interrupts are %s\n", level ? "disabled" : "enabled");
+        exit(1);
+    }
+
+    return level;
+}
+
+static void mock_unlock(spi_bus *bus, uint32_t level) {
+    lock_depth--;
+    primask = level;
+    /* the pending DMA interrupt is taken when the interrupts are enabled */
+    if (!primask && dma_flag) {
+        nested_isr |= lock_depth != 0;
+        dma_flag = false;
+        spi_bus_dma_done(bus, SPI_BUS_SUCCESS);
+    }
+}
+
+static const spi_bus_ops mock_ops = {
+    mock_configure,
+    mock_cs,
+    mock_transfer,
+    mock_transfer_dma,
+    mock_poll,
+    mock_lock,
+    mock_unlock,
+};
+
+/**
+ * refresh the display and run the flash commands between the lines
+ *
+ * @param irq_disabled the interrupts are disabled by caller, like ef_port_env_lock
+ *
+ * @return 0: OK
+ */
+static int run(const char *name, bool irq_disabled) {
+    static uint8_t line[LINE_NUM][LINE_SIZE];
+    static spi_bus_xfer xfer[LINE_NUM];
+    uint8_t cmd[4] = { 0x06 }, status, byte;
+    uint32_t reconfigure_count = mock_bus.reconfigure_count;
+    int i;
+
+    memset(order, 0, sizeof(order));
+    memset(xfer, 0, sizeof(xfer));
+    nested_isr = false;
+    primask = irq_disabled;
+    for (i = 0; i < LINE_NUM; i++) {
+        xfer[i].dev = &display;
+        xfer[i].tx_buf = line[i];
+        xfer[i].size = LINE_SIZE;
+        spi_bus_submit(&xfer[i]);
+    }
+    /* WREN, page program and status poll, they wait for the running line only */
+    wait_ticks = 0;
+    record('|');
+    spi_bus_transfer(&flash, cmd, 1, NULL, 0);
+    spi_bus_transfer(&flash, cmd, sizeof(cmd), NULL, 0);
+    spi_bus_transfer(&flash, cmd, 1, &status, 1);
+    if (primask != irq_disabled) {
+        printf("%s: the interrupt state is changed by arbiter\n", name);
+        return -1;
+    }
+    wait_ticks = 0;
+    spi_bus_wait(&xfer[LINE_NUM - 1]);
+    /* the device which is selected by user holds the bus */
+    spi_bus_acquire(&bsp);
+    spi_bus_exchange(&bsp, cmd, &byte, 1);
+    spi_bus_exchange(&bsp, cmd, &byte, 1);
+    spi_bus_release(&bsp);
+
+    if (!check_order()) {
+        printf("%s: the transfer order %s is wrong\n", name, order);
+        return -1;
+    }
+    if (nested_isr) {
+        printf("%s: the DMA interrupt is taken on the critical section\n", name);
+        return -1;
+    }
+    printf("%-24s order %s, reconfigure %lu times\n", name, order,
+            (unsigned long) (mock_bus.reconfigure_count - reconfigure_count));
+
+    return 0;
+}
+
+int main(void) {
+    mock_bus.name = "mock";
+    mock_bus.ops = &mock_ops;
+    spi_bus_init(&mock_bus);
+    spi_bus_attach(&mock_bus, &display);
+    spi_bus_attach(&mock_bus, &flash);
+    spi_bus_attach(&mock_bus, &bsp);
+
+    if (run("interrupts enabled:", false) || run("interrupts disabled:", true)) {
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
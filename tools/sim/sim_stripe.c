@@ -0,0 +1,100 @@
+/*
+ * Function: Simulator test of the FAL striped flash device on two SPI NOR flash. The 1MB erase and write time on one
+ *           flash and on the striped device are compared, then the random erase/write/read on the whole striped
+ *           device is checked by a reference image. Build and run it on Linux from the repository root, e.g.
+ *           gcc -DFAL_USING_STRIPE_PORT -DSFUD_USING_ASYNC_WRITE -DSFUD_USING_NOR_FLASH1 -Isrc/SUFD/inc
+ *               -Isrc/fal/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c src/SUFD/src/sfud_sim.c
+ *               src/SUFD/src/sfud_sim_port.c src/fal/src/fal_flash_stripe_port.c tools/sim/sim_stripe.c
+ *               -o sim_stripe && ./sim_stripe
+ * Created on: 2026-10-19
+ */
+
+#include <fal.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the size of the timed erase and write */
+#define BENCH_SIZE                               (1024 * 1024)
+/* the random operations on the striped device */
+#define RANDOM_OP_NUM                            300
+/* the maximum size of one random operation */
+#define RANDOM_OP_MAX_SIZE                       300000
+
+extern struct fal_flash_dev stripe_flash0;
+extern sfud_flash sfud_norflash0;
+
+static uint8_t ref[2 * 8 * 1024 * 1024], data[BENCH_SIZE], read_buf[RANDOM_OP_MAX_SIZE];
+
+static uint64_t elapsed_ms(uint64_t start) {
+    return (sfud_sim_get_time() - start) / 1000000;
+}
+
+int main(void) {
+    size_t i, offset, size, start, end;
+    uint64_t time;
+    int n;
+
+    if (spi_flash_init() || stripe_flash0.ops.init()) {
+        printf("flash initialize failed\n");
+        return 1;
+    }
+    printf("striped device length %ld bytes\n", (long) stripe_flash0.len);
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+
+    /* one flash, on the area which isn't used by the striped device */
+    time = sfud_sim_get_time();
+    sfud_erase(&sfud_norflash0, 0, BENCH_SIZE);
+    printf("one flash erase 1MB:   %5lu ms\n", (unsigned long) elapsed_ms(time));
+    time = sfud_sim_get_time();
+    sfud_write(&sfud_norflash0, 0, BENCH_SIZE, data);
+    printf("one flash write 1MB:   %5lu ms\n", (unsigned long) elapsed_ms(time));
+
+    time = sfud_sim_get_time();
+    stripe_flash0.ops.erase(0, 2 * BENCH_SIZE);
+    printf("striped erase 2MB:     %5lu ms\n", (unsigned long) elapsed_ms(time));
+    time = sfud_sim_get_time();
+    stripe_flash0.ops.write(0, data, BENCH_SIZE);
+    printf("striped write 1MB:     %5lu ms\n", (unsigned long) elapsed_ms(time));
+    time = sfud_sim_get_time();
+    stripe_flash0.ops.read(0, read_buf, sizeof(read_buf));
+    printf("striped read %luK:    %5lu ms\n", (unsigned long) sizeof(read_buf) / 1024, (unsigned long) elapsed_ms(time));
+    if (memcmp(read_buf, data, sizeof(read_buf))) {
+        printf("striped read mismatch\n");
+        return 1;
+    }
+
+    /* random erase, write and read, the reference has the NOR flash semantics */
+    stripe_flash0.ops.erase(0, stripe_flash0.len);
+    memset(ref, 0xFF, stripe_flash0.len);
+    for (n = 0; n < RANDOM_OP_NUM; n++) {
+        offset = rand() % (stripe_flash0.len - RANDOM_OP_MAX_SIZE);
+        size = 1 + rand() % RANDOM_OP_MAX_SIZE;
+        if (n % 4 == 0) {
+            start = offset - offset % stripe_flash0.blk_size;
+            end = (offset + size + stripe_flash0.blk_size - 1) / stripe_flash0.blk_size * stripe_flash0.blk_size;
+            if (stripe_flash0.ops.erase(offset, size) < 0) {
+                printf("erase failed on operation %d\n", n);
+                return 1;
+            }
+            memset(ref + start, 0xFF, end - start);
+        }
+        if (stripe_flash0.ops.write(offset, data + n, size) < 0) {
+            printf("write failed on operation %d\n", n);
+            return 1;
+        }
+        for (i = 0; i < size; i++) {
+            ref[offset + i] &= data[n + i];
+        }
+        if (stripe_flash0.ops.read(offset, read_buf, size) < 0 || memcmp(read_buf, ref + offset, size)) {
+            printf("read mismatch on operation %d\n", n);
+            return 1;
+        }
+    }
+    printf("OK\n");
+
+    return 0;
+}
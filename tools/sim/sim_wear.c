@@ -0,0 +1,102 @@
+/*
+ * Function: Simulator test of the EasyFlash ENV wear leveling. The cold ENV fill some sectors, then a counter ENV is
+ *           updated at high rate. The erase count of every ENV sector is printed, the device life is limited by the
+ *           most worn sector. Build and run it on Linux from the repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c
+ *               src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c src/easyflash/src/easyflash.c
+ *               src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c src/easyflash/src/ef_utils.c
+ *               tools/sim/sim_wear.c -o sim_wear && ./sim_wear [updates]
+ *           Add -DEF_ENV_WEAR_LEVEL_THRESHOLD=0 for the least worn sector allocation without static wear leveling.
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the default counter updates */
+#define UPDATE_NUM                               1000000
+/* the cold ENV, they fill about 6 sectors */
+#define COLD_ENV_NUM                             120
+#define COLD_ENV_SIZE                            180
+/* the status ENV is updated on every STAT_PERIOD counter updates */
+#define STAT_PERIOD                              50
+#define STAT_ENV_SIZE                            120
+
+#define ENV_SECTOR_NUM                           (ENV_AREA_SIZE / EF_ERASE_MIN_SIZE)
+#define SIM_SECTORS_PER_ENV_SECTOR               (EF_ERASE_MIN_SIZE / 4096)
+
+int main(int argc, char *argv[]) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    long updates = argc > 1 ? atol(argv[1]) : UPDATE_NUM, i;
+    uint32_t count, min = UINT32_MAX, max = 0, total = 0;
+    char key[16], value[COLD_ENV_SIZE], *saved;
+    size_t sec;
+
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed\n");
+        return 1;
+    }
+    ef_env_set_default();
+    for (i = 0; i < COLD_ENV_NUM; i++) {
+        snprintf(key, sizeof(key), "cold%ld", i);
+        memset(value, 'a' + i % 26, COLD_ENV_SIZE);
+        if (ef_set_env_blob(key, value, COLD_ENV_SIZE) != EF_NO_ERR) {
+            printf("set %s failed\n", key);
+            return 1;
+        }
+    }
+    /* the erases of the cold ENV writing are not counted */
+    memset(sim->erase_count, 0, ENV_SECTOR_NUM * SIM_SECTORS_PER_ENV_SECTOR * sizeof(uint32_t));
+    for (i = 0; i < updates; i++) {
+        snprintf(value, sizeof(value), "%ld", i);
+        if (ef_set_env("counter", value) != EF_NO_ERR) {
+            printf("set counter failed on update %ld\n", i);
+            return 1;
+        }
+        if (i % STAT_PERIOD == 0) {
+            memset(value, 'x', STAT_ENV_SIZE);
+            if (ef_set_env_blob("status", value, STAT_ENV_SIZE) != EF_NO_ERR) {
+                printf("set status failed on update %ld\n", i);
+                return 1;
+            }
+        }
+    }
+    /* the cold ENV and the last counter are kept */
+    ef_load_env();
+    snprintf(value, sizeof(value), "%ld", updates - 1);
+    saved = ef_get_env("counter");
+    if (!saved || strcmp(saved, value)) {
+        printf("counter is %s, expect %s\n", saved ? saved : "(null)", value);
+        return 1;
+    }
+    for (i = 0; i < COLD_ENV_NUM; i++) {
+        char expect[COLD_ENV_SIZE];
+
+        snprintf(key, sizeof(key), "cold%ld", i);
+        memset(expect, 'a' + i % 26, COLD_ENV_SIZE);
+        if (ef_get_env_blob(key, value, sizeof(value), NULL) != COLD_ENV_SIZE || memcmp(value, expect, COLD_ENV_SIZE)) {
+            printf("%s is lost\n", key);
+            return 1;
+        }
+    }
+
+    printf("%ld counter updates, erase count of every sector:\n", updates);
+    for (sec = 0; sec < ENV_SECTOR_NUM; sec++) {
+        count = sim->erase_count[(EF_START_ADDR + sec * EF_ERASE_MIN_SIZE) / 4096];
+        printf("%6lu%s", (unsigned long) count, sec % 8 == 7 ? "\n" : " ");
+        total += count;
+        if (count < min) {
+            min = count;
+        }
+        if (count > max) {
+            max = count;
+        }
+    }
+    printf("min %lu, max %lu, total %lu\n", (unsigned long) min, (unsigned long) max, (unsigned long) total);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Function: Simulator test of the SFUD page write-combining buffer on the EasyFlash ENV. The same ENV updates are
+ *           written with and without the buffer, then the page programs and the simulated time are compared.
+ *           The pending data must be programmed after SFUD_WRITE_BUFFER_TIMEOUT idle sfud_write_buffer_poll calls.
+ *           Build and run it on Linux from the repository root, e.g.
+ *           gcc -Itools/sim -Isrc/SUFD/inc -Isrc/easyflash/inc src/SUFD/src/sfud.c src/SUFD/src/sfud_sfdp.c
+ *               src/SUFD/src/sfud_sim.c src/SUFD/src/sfud_sim_port.c src/easyflash/src/easyflash.c
+ *               src/easyflash/src/ef_env.c src/easyflash/src/ef_port.c src/easyflash/src/ef_utils.c
+ *               tools/sim/sim_write_buffer.c -o sim_write_buffer && ./sim_write_buffer
+ * Created on: 2026-10-19
+ */
+
+#include <easyflash.h>
+#include <sfud.h>
+#include <sfud_sim.h>
+#include <stdio.h>
+#include <string.h>
+
+/* the ENV updates of one run, the GC runs about 2 rounds on the 64K ENV area */
+#define UPDATE_NUM                               3000
+/* the ENV keys of one run */
+#define KEY_NUM                                  20
+
+static void make_value(char *value, size_t size, int update) {
+    snprintf(value, size, "value-%d-%d", update, update * update);
+}
+
+static int run(const char *name, sfud_sim *sim) {
+    char key[16], value[40], *saved;
+    uint64_t time;
+    int i;
+
+    /* every run is started from the default ENV */
+    ef_env_set_default();
+    sfud_sim_clear_stats(sim);
+    time = sfud_sim_get_time();
+    for (i = 0; i < UPDATE_NUM; i++) {
+        snprintf(key, sizeof(key), "key%d", i % KEY_NUM);
+        make_value(value, sizeof(value), i);
+        if (ef_set_env(key, value) != EF_NO_ERR) {
+            printf("%s: set %s failed\n", name, key);
+            return -1;
+        }
+    }
+    time = sfud_sim_get_time() - time;
+    /* the last value of every key is read back from flash */
+    ef_load_env();
+    for (i = UPDATE_NUM - KEY_NUM; i < UPDATE_NUM; i++) {
+        snprintf(key, sizeof(key), "key%d", i % KEY_NUM);
+        make_value(value, sizeof(value), i);
+        saved = ef_get_env(key);
+        if (!saved || strcmp(saved, value)) {
+            printf("%s: %s is %s, expect %s\n", name, key, saved ? saved : "(null)", value);
+            return -1;
+        }
+    }
+    printf("%-16s page programs %5lu, 4K erases %3lu, time %5lu ms\n", name, (unsigned long) sim->stats.program_cmds,
+            (unsigned long) sim->stats.erase_4k, (unsigned long) (time / 1000000));
+
+    return 0;
+}
+
+/**
+ * the buffered write which isn't flushed by the caller is programmed by the poll timeout
+ */
+static int poll_timeout(const sfud_flash *flash, sfud_sim *sim) {
+    static const uint8_t data[] = { 0x12, 0x34, 0x56, 0x78 };
+    uint32_t addr = flash->chip.capacity - SFUD_WRITE_MAX_PAGE_SIZE;
+    uint8_t saved[sizeof(data)];
+    int i;
+
+    if (sfud_erase(flash, addr, SFUD_WRITE_MAX_PAGE_SIZE) != SFUD_SUCCESS
+            || sfud_write_buffered(flash, addr, sizeof(data), data) != SFUD_SUCCESS) {
+        printf("poll timeout: write failed\n");
+        return -1;
+    }
+    sfud_sim_clear_stats(sim);
+    for (i = 1; i < SFUD_WRITE_BUFFER_TIMEOUT; i++) {
+        sfud_write_buffer_poll(flash);
+    }
+    if (sim->stats.program_cmds) {
+        printf("poll timeout: the buffer is flushed before the timeout\n");
+        return -1;
+    }
+    sfud_write_buffer_poll(flash);
+    if (sim->stats.program_cmds != 1 || memcmp(&sim->array[addr], data, sizeof(data))) {
+        printf("poll timeout: the buffer is not flushed on the timeout\n");
+        return -1;
+    }
+    if (sfud_read(flash, addr, sizeof(saved), saved) != SFUD_SUCCESS || memcmp(saved, data, sizeof(data))) {
+        printf("poll timeout: read data is different\n");
+        return -1;
+    }
+    printf("poll timeout:    flushed on poll %d\n", SFUD_WRITE_BUFFER_TIMEOUT);
+
+    return 0;
+}
+
+int main(void) {
+    sfud_sim *sim = sfud_sim_port_get_device("SPI2");
+    sfud_flash *flash;
+    sfud_write_buffer *write_buf;
+
+    if (easyflash_init() != EF_NO_ERR) {
+        printf("EasyFlash initialize failed\n");
+        return 1;
+    }
+    /* the buffer is attached by ef_port_init */
+    flash = sfud_get_device(SFUD_XXXX_DEVICE_INDEX);
+    write_buf = flash->write_buf;
+    if (!write_buf) {
+        printf("SFUD_USING_WRITE_BUFFER is not enabled on 'sfud_cfg.h'\n");
+        return 1;
+    }
+
+    flash->write_buf = NULL;
+    if (run("without buffer:", sim)) {
+        return 1;
+    }
+    flash->write_buf = write_buf;
+    if (run("with buffer:", sim)) {
+        return 1;
+    }
+    if (poll_timeout(flash, sim)) {
+        return 1;
+    }
+    printf("OK\n");
+
+    return 0;
+}
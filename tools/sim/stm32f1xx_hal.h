@@ -0,0 +1,11 @@
+/*
+ * Function: Host stub of the STM32 HAL header for the simulator tests, the device ef_cfg.h and ports include it.
+ * Created on: 2026-10-19
+ */
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stm32f1xx_hal_conf.h>
+
+#endif /* __STM32F1xx_HAL_H */
@@ -0,0 +1,42 @@
+/*
+ * Function: Host stub of the STM32 HAL configuration for the simulator tests. The interrupt control is empty, and
+ *           the DWT cycle counter runs on the simulated clock of sfud_sim at 72MHz.
+ * Created on: 2026-10-19
+ */
+
+#ifndef __STM32F1xx_HAL_CONF_H
+#define __STM32F1xx_HAL_CONF_H
+
+#include <stdint.h>
+
+#define __disable_irq()
+#define __enable_irq()
+
+#define SystemCoreClock                          72000000UL
+
+#define DWT_CTRL_CYCCNTENA_Msk                   (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk               (1UL << 24)
+
+typedef struct {
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+uint64_t sfud_sim_get_time(void);
+
+static DWT_Type sim_dwt;
+static CoreDebug_Type sim_core_debug;
+
+static inline DWT_Type *sim_get_dwt(void) {
+    sim_dwt.CYCCNT = (uint32_t) (sfud_sim_get_time() * (SystemCoreClock / 1000000) / 1000);
+    return &sim_dwt;
+}
+
+#define DWT                                      (sim_get_dwt())
+#define CoreDebug                                (&sim_core_debug)
+
+#endif /* __STM32F1xx_HAL_CONF_H */